@@ -0,0 +1,118 @@
+/*
+ * Copyright 2022 ByteDance Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _FTOA_H_
+#define _FTOA_H_
+
+#include <benchmark/benchmark.h>
+#include <sonic/sonic.h>
+
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+
+// The instruction set of the digit kernels, in the benchmark names.
+#if defined(SONIC_HAVE_AVX2)
+#define FTOA_ARCH "avx2"
+#elif defined(SONIC_HAVE_SSE)
+#define FTOA_ARCH "sse"
+#elif defined(SONIC_HAVE_SVE2_128)
+#define FTOA_ARCH "sve2"
+#elif defined(SONIC_HAVE_NEON)
+#define FTOA_ARCH "neon"
+#elif defined(SONIC_HAVE_RISCV)
+#define FTOA_ARCH "riscv"
+#else
+#define FTOA_ARCH "scalar"
+#endif
+
+// The doubles like coordinates: random ones with 16 or 17 digits, the ones
+// rounded to 6 decimals, and the integers.
+enum class DoubleKind { kRandom, kDecimal6, kInteger };
+
+static std::vector<double> gen_doubles(DoubleKind kind, size_t n) {
+  std::mt19937_64 rng(42);
+  std::uniform_real_distribution<double> dist(-180.0, 180.0);
+  std::vector<double> out(n);
+  for (auto &d : out) {
+    d = dist(rng);
+    if (kind == DoubleKind::kDecimal6) {
+      d = std::round(d * 1e6) / 1e6;
+    } else if (kind == DoubleKind::kInteger) {
+      d = std::round(d * 1e4);
+    }
+  }
+  return out;
+}
+
+static void BM_SonicF64toa(benchmark::State &state, DoubleKind kind) {
+  std::vector<double> vals = gen_doubles(kind, 4096);
+  char buf[64];
+  for (auto _ : state) {
+    for (double d : vals) {
+      benchmark::DoNotOptimize(sonic_json::internal::F64toa(buf, d));
+    }
+  }
+  state.SetItemsProcessed(int64_t(state.iterations()) * int64_t(vals.size()));
+}
+
+// Serialize a numeric array, which is packed by kParsePackNumberArrays or
+// kept as nodes.
+template <ParseFlags parseFlags>
+static void BM_SonicSerializeDoubles(benchmark::State &state,
+                                     DoubleKind kind) {
+  std::vector<double> vals = gen_doubles(kind, 4096);
+  std::string data = "[";
+  char buf[64];
+  for (double d : vals) {
+    data.append(buf, sonic_json::internal::F64toa(buf, d));
+    data += ',';
+  }
+  data.back() = ']';
+  sonic_json::Document doc;
+  sonic_json::WriteBuffer wb;
+  doc.Parse<parseFlags>(data);
+  for (auto _ : state) {
+    doc.Serialize(wb);
+    benchmark::DoNotOptimize(wb.Size());
+  }
+  state.SetItemsProcessed(int64_t(state.iterations()) * int64_t(vals.size()));
+}
+
+static void register_ftoa_benchmarks() {
+  const std::pair<const char *, DoubleKind> kinds[] = {
+      {"random", DoubleKind::kRandom},
+      {"decimal6", DoubleKind::kDecimal6},
+      {"integer", DoubleKind::kInteger},
+  };
+  for (const auto &k : kinds) {
+    std::string prefix = std::string("ftoa_") + FTOA_ARCH + "/" + k.first;
+    benchmark::RegisterBenchmark((prefix + "/F64toa_SonicDyn").c_str(),
+                                 BM_SonicF64toa, k.second);
+    benchmark::RegisterBenchmark(
+        (prefix + "/SerializeArray_SonicDyn").c_str(),
+        BM_SonicSerializeDoubles<ParseFlags::kParseDefault>,
+        k.second);
+    benchmark::RegisterBenchmark(
+        (prefix + "/SerializePackedArray_SonicDyn").c_str(),
+        BM_SonicSerializeDoubles<
+            ParseFlags::kParsePackNumberArrays>,
+        k.second);
+  }
+}
+
+#endif
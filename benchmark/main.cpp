@@ -26,11 +26,19 @@
 #include <vector>
 
 #include "cjson.hpp"
+#include "ftoa.hpp"
 #include "jsoncpp.hpp"
+#include "member_index.hpp"
+#include "ndjson.hpp"
 #include "ondemand.hpp"
+#include "parallel.hpp"
+#include "parse_flags.hpp"
 #include "rapidjson.hpp"
 #include "simdjson.hpp"
 #include "sonic.hpp"
+#include "struct.hpp"
+#include "tape.hpp"
+#include "writer.hpp"
 #include "yyjson.hpp"
 
 static std::string get_json(const std::filesystem::path &file) {
@@ -237,6 +245,92 @@ static void regitser_OnDemand(const std::filesystem::path &testdata_dir) {
     REG_ONDEMAND(RapidjsonSax);
     REG_ONDEMAND(SIMDjson);
   }
+
+  std::vector<MultiOnDemand> multi = {
+      {"twitter",
+       {{"search_metadata", "count"},
+        {"search_metadata", "max_id"},
+        {"statuses", 0, "id"},
+        {"statuses", 0, "user", "screen_name"},
+        {"statuses", 50, "text"},
+        {"statuses", 99, "retweet_count"}}},
+      {"citm_catalog",
+       {{"areaNames", "205705993"},
+        {"events", "138586341", "name"},
+        {"events", "342742596", "id"},
+        {"performances", 0, "start"},
+        {"venueNames", "PLEYEL_PLEYEL"}}},
+  };
+  for (auto &t : multi) {
+    t.json = get_json(testdata_dir / (t.file + ".json"));
+    benchmark::RegisterBenchmark((t.file + "/OnDemandMulti_SonicDyn").c_str(),
+                                 BM_SonicOnDemandMulti, t);
+    benchmark::RegisterBenchmark((t.file + "/OnDemandEach_SonicDyn").c_str(),
+                                 BM_SonicOnDemandEach, t);
+    benchmark::RegisterBenchmark(
+        (t.file + "/OnDemandPrepared_SonicDyn").c_str(),
+        BM_SonicPreparedPointer, t);
+  }
+  std::vector<RepeatedJsonPath> repeated = {
+      {"twitter",
+       {"$.search_metadata.count", "$.statuses[0].user.screen_name",
+        "$.statuses[50].text", "$.statuses[99].retweet_count"}},
+      {"citm_catalog",
+       {"$.areaNames.205705993", "$.events.138586341.name",
+        "$.performances[0].start", "$.venueNames.PLEYEL_PLEYEL"}},
+      // a small row, where parsing the paths is a large part of the cost
+      {"row",
+       {"$.user.name", "$.user.tags[1]", "$.event['type']", "$.ts"},
+       R"({"user": {"id": 1024, "name": "sonic", "tags": ["a", "b"]},)"
+       R"( "event": {"type": "click", "x": 3, "y": 4}, "ts": 1666666666})"},
+  };
+  for (auto &t : repeated) {
+    if (t.json.empty()) t.json = get_json(testdata_dir / (t.file + ".json"));
+    benchmark::RegisterBenchmark(
+        (t.file + "/JsonPathPrepared_SonicDyn").c_str(),
+        BM_SonicPreparedJsonPath, t);
+    benchmark::RegisterBenchmark(
+        (t.file + "/JsonPathOnDemand_SonicDyn").c_str(),
+        BM_SonicJsonPathOnDemand, t);
+    benchmark::RegisterBenchmark((t.file + "/JsonPathPlan_SonicDyn").c_str(),
+                                 BM_SonicJsonPathPlan, t);
+    benchmark::RegisterBenchmark(
+        (t.file + "/JsonPathCached_SonicDyn").c_str(), BM_SonicJsonPathCached,
+        t);
+  }
+  // the filters over the large arrays
+  std::vector<RepeatedJsonPath> filters = {
+      {"twitter", {"$.statuses[?(@.retweet_count > 0)].id"}},
+      {"citm_catalog",
+       {"$.performances[?(@.venueCode == 'PLEYEL_PLEYEL' && "
+        "@.prices[0].amount > 50000)].id"}},
+  };
+  for (auto &t : filters) {
+    t.json = get_json(testdata_dir / (t.file + ".json"));
+    benchmark::RegisterBenchmark(
+        (t.file + "/JsonPathFilterOnDemand_SonicDyn").c_str(),
+        BM_SonicJsonPathOnDemand, t);
+    benchmark::RegisterBenchmark(
+        (t.file + "/JsonPathFilterDom_SonicDyn").c_str(), BM_SonicJsonPathDom,
+        t);
+  }
+  // the descendants, the keys are sparse or in every element
+  std::vector<RepeatedJsonPath> descendants = {
+      {"twitter", {"$..next_results", "$..screen_name"}},
+      {"citm_catalog", {"$..areaNames", "$..logo"}},
+  };
+  for (auto &t : descendants) {
+    t.json = get_json(testdata_dir / (t.file + ".json"));
+    for (const auto &path : t.paths) {
+      RepeatedJsonPath one = {t.file, {path}, t.json};
+      benchmark::RegisterBenchmark(
+          (t.file + "/JsonPathDescendantOnDemand_SonicDyn/" + path).c_str(),
+          BM_SonicJsonPathOnDemand, one);
+      benchmark::RegisterBenchmark(
+          (t.file + "/JsonPathDescendantDom_SonicDyn/" + path).c_str(),
+          BM_SonicJsonPathDom, one);
+    }
+  }
 }
 
 int main(int argc, char **argv) {
@@ -281,12 +375,122 @@ int main(int argc, char **argv) {
 
   ADD_BMK(Decode);
   ADD_BMK(Encode);
+  // the read-only tape document against DNode
+  for (const auto &json : jsons) {
+    ADD_JSON_BMK(SonicTape, Decode);
+    ADD_JSON_BMK(SonicTape, Encode);
+  }
+  // parse with different flags
+  for (const auto &json : jsons) {
+#define ADD_FLAGS_BMK(NAME, FLAGS)                                           \
+  benchmark::RegisterBenchmark(                                              \
+      (json.first.stem().string() + ("/" #NAME "_SonicDyn")).c_str(),        \
+      BM_SonicDecodeFlags<FLAGS>, json.first.string(), json.second)
+    ADD_FLAGS_BMK(DecodeCopy, ParseFlags::kParseDefault);
+    ADD_FLAGS_BMK(DecodeBorrowed, ParseFlags::kParseBorrowInput);
+    ADD_FLAGS_BMK(DecodeLazyNumbers, ParseFlags::kParseLazyNumbers);
+    ADD_FLAGS_BMK(DecodeLazyStrings, ParseFlags::kParseLazyStrings);
+    ADD_FLAGS_BMK(DecodePackedArrays, ParseFlags::kParsePackNumberArrays);
+#undef ADD_FLAGS_BMK
+#define ADD_ROUNDTRIP_BMK(NAME, FLAGS)                                       \
+  benchmark::RegisterBenchmark(                                              \
+      (json.first.stem().string() + ("/" #NAME "_SonicDyn")).c_str(),        \
+      BM_SonicRoundTripFlags<FLAGS>, json.first.string(), json.second)
+    ADD_ROUNDTRIP_BMK(RoundTrip, ParseFlags::kParseDefault);
+    ADD_ROUNDTRIP_BMK(RoundTripLazyStrings, ParseFlags::kParseLazyStrings);
+    ADD_ROUNDTRIP_BMK(RoundTripPackedArrays,
+                      ParseFlags::kParsePackNumberArrays);
+#undef ADD_ROUNDTRIP_BMK
+    benchmark::RegisterBenchmark(
+        (json.first.stem().string() + "/ReadAndParse_SonicDyn").c_str(),
+        BM_SonicReadAndParse, json.first.string(), json.second.size());
+    benchmark::RegisterBenchmark(
+        (json.first.stem().string() + "/ParseFile_SonicDyn").c_str(),
+        BM_SonicParseFile, json.first.string(), json.second.size());
+    // write the same output by the DOM and by the writer
+    benchmark::RegisterBenchmark(
+        (json.first.stem().string() + "/WriteByDom_SonicDyn").c_str(),
+        BM_SonicWriteByDom, json.first.string(), json.second);
+    benchmark::RegisterBenchmark(
+        (json.first.stem().string() + "/Writer_SonicDyn").c_str(),
+        BM_SonicWriter, json.first.string(), json.second);
+  }
+  // NDJSON over a generated log corpus
+  std::string ndjson = gen_ndjson_logs(100000);
+  benchmark::RegisterBenchmark("ndjson_logs/PerLine_SonicDyn",
+                               BM_SonicNdjsonPerLine, std::string_view(ndjson),
+                               false);
+  benchmark::RegisterBenchmark("ndjson_logs/PerLineReParse_SonicDyn",
+                               BM_SonicNdjsonPerLine, std::string_view(ndjson),
+                               true);
+  for (size_t threads : {1, 2, 4, 8}) {
+    benchmark::RegisterBenchmark(
+        ("ndjson_logs/Batch" + std::to_string(threads) + "_SonicDyn").c_str(),
+        BM_SonicNdjsonBatch, std::string_view(ndjson), threads)
+        ->UseRealTime();
+  }
+  // a large array parsed by several threads
+  std::string array = gen_array_logs(400000);
+  for (size_t threads : {1, 2, 4, 8}) {
+    benchmark::RegisterBenchmark(
+        ("array_logs/Parallel" + std::to_string(threads) + "_SonicDyn")
+            .c_str(),
+        BM_SonicParseParallel, std::string_view(array), threads)
+        ->UseRealTime();
+  }
+  // parse the array into structs, with and without the DOM
+  benchmark::RegisterBenchmark("array_logs/StructByDom_SonicDyn",
+                               BM_SonicStructByDom, std::string_view(array));
+  benchmark::RegisterBenchmark("array_logs/StructDirect_SonicDyn",
+                               BM_SonicStructDirect, std::string_view(array));
+  benchmark::RegisterBenchmark("array_logs/StructSerializeByDom_SonicDyn",
+                               BM_SonicStructSerializeByDom,
+                               std::string_view(array));
+  benchmark::RegisterBenchmark("array_logs/StructSerializeDirect_SonicDyn",
+                               BM_SonicStructSerializeDirect,
+                               std::string_view(array));
+  // build and query the member map of wide objects
+  for (size_t keys : {64, 1024, 16384}) {
+    std::string prefix = "wide_object_" + std::to_string(keys);
+    std::string data = gen_wide_object(keys);
+    benchmark::RegisterBenchmark((prefix + "/CreateMap_SonicDyn").c_str(),
+                                 BM_SonicCreateMap, data);
+    benchmark::RegisterBenchmark((prefix + "/CreateMap_StdMultimap").c_str(),
+                                 BM_StdMultimapCreate, data);
+    benchmark::RegisterBenchmark((prefix + "/MapLookup_SonicDyn").c_str(),
+                                 BM_SonicMapLookup, data);
+    benchmark::RegisterBenchmark((prefix + "/MapLookup_StdMultimap").c_str(),
+                                 BM_StdMultimapLookup, data);
+  }
+  // find members without the map, and with the automatic map
+  for (size_t keys : {8, 32, 1024}) {
+    std::string prefix = "wide_object_" + std::to_string(keys);
+    std::string data = gen_wide_object(keys);
+    benchmark::RegisterBenchmark((prefix + "/FindMember_SonicDyn").c_str(),
+                                 BM_SonicFindMember, data);
+    benchmark::RegisterBenchmark((prefix + "/AutoMapLookup_SonicDyn").c_str(),
+                                 BM_SonicAutoMapLookup, data);
+  }
+  // parse the lookup tables with their member maps
+  for (size_t keys : {64, 1024}) {
+    std::string prefix = "wide_objects_" + std::to_string(keys);
+    std::string data = gen_wide_objects(65536 / keys, keys);
+    benchmark::RegisterBenchmark(
+        (prefix + "/ParseThenCreateMap_SonicDyn").c_str(),
+        BM_SonicParseThenCreateMap, data);
+    benchmark::RegisterBenchmark((prefix + "/ParseCreateMap_SonicDyn").c_str(),
+                                 BM_SonicParseCreateMap, data);
+  }
+  // format the doubles by the digit kernels of the target
+  register_ftoa_benchmarks();
   // ADD_BMK(Stat);
   // ADD_BMK(Find);
   do {
     for (const auto &json : jsons) {
       ADD_JSON_BMK(SonicDyn, Stat);
       ADD_JSON_BMK(SonicDyn, Find);
+      ADD_JSON_BMK(SonicTape, Stat);
+      ADD_JSON_BMK(SonicTape, Find);
       ADD_JSON_BMK(Rapidjson, Stat);
       ADD_JSON_BMK(Rapidjson, Find);
     }
@@ -0,0 +1,169 @@
+/*
+ * Copyright 2022 ByteDance Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _MEMBER_INDEX_H_
+#define _MEMBER_INDEX_H_
+
+#include <benchmark/benchmark.h>
+#include <sonic/sonic.h>
+
+#include <algorithm>
+#include <map>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// An object used as a lookup table, e.g. {"user:00000000":0, ...}.
+static std::string gen_wide_object(size_t keys) {
+  std::string out = "{";
+  char buf[32];
+  for (size_t i = 0; i < keys; i++) {
+    snprintf(buf, sizeof(buf), "\"user:%08zu\":%zu,", i * 7919, i);
+    out += buf;
+  }
+  out.back() = '}';
+  return out;
+}
+
+using WideDocument =
+    sonic_json::GenericDocument<sonic_json::DNode<sonic_json::SimpleAllocator>>;
+
+static std::vector<std::string> wide_object_keys(const WideDocument &doc) {
+  std::vector<std::string> keys;
+  for (auto m = doc.MemberBegin(); m != doc.MemberEnd(); ++m) {
+    keys.emplace_back(m->name.GetStringView());
+  }
+  std::shuffle(keys.begin(), keys.end(), std::mt19937(42));
+  return keys;
+}
+
+// The std::multimap index that CreateMap used to build.
+using StdMemberMap = std::multimap<sonic_json::StringView, size_t>;
+
+static StdMemberMap build_std_map(const WideDocument &doc) {
+  StdMemberMap map;
+  size_t i = 0;
+  for (auto m = doc.MemberBegin(); m != doc.MemberEnd(); ++m) {
+    map.emplace(m->name.GetStringView(), i++);
+  }
+  return map;
+}
+
+static void BM_SonicCreateMap(benchmark::State &state, std::string data) {
+  WideDocument doc;
+  doc.Parse(data);
+  for (auto _ : state) {
+    doc.DestroyMap();
+    doc.CreateMap(doc.GetAllocator());
+  }
+  state.SetItemsProcessed(int64_t(state.iterations()) * int64_t(doc.Size()));
+}
+
+static void BM_StdMultimapCreate(benchmark::State &state, std::string data) {
+  WideDocument doc;
+  doc.Parse(data);
+  for (auto _ : state) {
+    StdMemberMap map = build_std_map(doc);
+    benchmark::DoNotOptimize(map);
+  }
+  state.SetItemsProcessed(int64_t(state.iterations()) * int64_t(doc.Size()));
+}
+
+static void BM_SonicMapLookup(benchmark::State &state, std::string data) {
+  WideDocument doc;
+  doc.Parse(data);
+  doc.CreateMap(doc.GetAllocator());
+  std::vector<std::string> keys = wide_object_keys(doc);
+  for (auto _ : state) {
+    for (const auto &key : keys) {
+      benchmark::DoNotOptimize(doc.FindMember(key));
+    }
+  }
+  state.SetItemsProcessed(int64_t(state.iterations()) * int64_t(keys.size()));
+}
+
+static void BM_StdMultimapLookup(benchmark::State &state, std::string data) {
+  WideDocument doc;
+  doc.Parse(data);
+  StdMemberMap map = build_std_map(doc);
+  std::vector<std::string> keys = wide_object_keys(doc);
+  for (auto _ : state) {
+    for (const auto &key : keys) {
+      auto it = map.find(sonic_json::StringView(key));
+      benchmark::DoNotOptimize(doc.MemberBegin() + it->second);
+    }
+  }
+  state.SetItemsProcessed(int64_t(state.iterations()) * int64_t(keys.size()));
+}
+
+static void BM_SonicFindMember(benchmark::State &state, std::string data) {
+  WideDocument doc;
+  doc.Parse(data);
+  std::vector<std::string> keys = wide_object_keys(doc);
+  for (auto _ : state) {
+    for (const auto &key : keys) {
+      benchmark::DoNotOptimize(doc.FindMember(key));
+    }
+  }
+  state.SetItemsProcessed(int64_t(state.iterations()) * int64_t(keys.size()));
+}
+
+static void BM_SonicAutoMapLookup(benchmark::State &state, std::string data) {
+  WideDocument doc;
+  doc.Parse(data);
+  doc.EnableAutoMap(doc.GetAllocator());
+  std::vector<std::string> keys = wide_object_keys(doc);
+  for (auto _ : state) {
+    for (const auto &key : keys) {
+      benchmark::DoNotOptimize(doc.FindMember(key));
+    }
+  }
+  state.SetItemsProcessed(int64_t(state.iterations()) * int64_t(keys.size()));
+}
+
+// Many lookup tables, e.g. [{"user:00000000":0, ...}, ...].
+static std::string gen_wide_objects(size_t tables, size_t keys) {
+  std::string table = gen_wide_object(keys);
+  std::string out = "[";
+  for (size_t i = 0; i < tables; i++) out += table + ",";
+  out.back() = ']';
+  return out;
+}
+
+// The tables are query-ready after parsing, by a CreateMap walk or by
+// kParseCreateMap.
+static void BM_SonicParseThenCreateMap(benchmark::State &state,
+                                       std::string data) {
+  WideDocument doc;
+  for (auto _ : state) {
+    doc.Parse(data);
+    for (auto v = doc.Begin(); v != doc.End(); ++v) {
+      v->CreateMap(doc.GetAllocator());
+    }
+  }
+  state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(data.size()));
+}
+
+static void BM_SonicParseCreateMap(benchmark::State &state, std::string data) {
+  WideDocument doc;
+  for (auto _ : state) {
+    doc.Parse<ParseFlags::kParseCreateMap>(data);
+  }
+  state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(data.size()));
+}
+
+#endif
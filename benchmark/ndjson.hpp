@@ -0,0 +1,95 @@
+/*
+ * Copyright 2022 ByteDance Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _NDJSON_H_
+#define _NDJSON_H_
+
+#include <benchmark/benchmark.h>
+#include <sonic/sonic.h>
+
+#include <cstring>
+#include <random>
+#include <string>
+#include <string_view>
+
+// Generate a corpus of log records in NDJSON.
+static std::string gen_ndjson_logs(size_t records) {
+  static const char *kLevels[] = {"DEBUG", "INFO", "WARN", "ERROR"};
+  static const char *kPaths[] = {"/api/v1/users", "/api/v1/orders?id=42",
+                                 "/static/app.js", "/healthz"};
+  std::mt19937 rng(42);
+  std::string out;
+  for (size_t i = 0; i < records; i++) {
+    uint32_t r = rng();
+    out += R"({"ts":)" + std::to_string(1700000000000ULL + i * 17);
+    out += R"(,"level":")" + std::string(kLevels[r % 4]);
+    out += R"(","host":"host-)" + std::to_string(r % 64);
+    out += R"(","path":")" + std::string(kPaths[(r >> 8) % 4]);
+    out += R"(","status":)" + std::to_string(200 + (r >> 12) % 4 * 100);
+    out += R"(,"latency_ms":)" + std::to_string((r >> 16) % 5000 / 10.0);
+    out += R"(,"msg":"request \"done\" in worker\t)" + std::to_string(r % 8);
+    out += R"(","tags":["svc","v)" + std::to_string(r % 3) + R"("]})";
+    out += '\n';
+  }
+  return out;
+}
+
+// The baseline: split lines by memchr and parse them one by one. ReParse
+// keeps the memory of the document between lines.
+static void BM_SonicNdjsonPerLine(benchmark::State &state,
+                                  std::string_view data, bool reparse) {
+  sonic_json::Document doc;
+  size_t records = 0;
+  for (auto _ : state) {
+    const char *p = data.data();
+    const char *end = p + data.size();
+    while (p < end) {
+      const char *nl =
+          static_cast<const char *>(std::memchr(p, '\n', end - p));
+      if (!nl) nl = end;
+      if (reparse) {
+        doc.ReParse(p, nl - p);
+      } else {
+        doc.Parse(p, nl - p);
+      }
+      if (doc.HasParseError()) {
+        state.SkipWithError("Failed to parse record");
+        return;
+      }
+      records++;
+      p = nl + 1;
+    }
+  }
+  benchmark::DoNotOptimize(records);
+  state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(data.size()));
+}
+
+static void BM_SonicNdjsonBatch(benchmark::State &state, std::string_view data,
+                                size_t threads) {
+  sonic_json::NdjsonParser parser(threads);
+  size_t records = 0;
+  for (auto _ : state) {
+    auto ret = parser.Parse(data, [&](sonic_json::Document &) { records++; });
+    if (ret.Error()) {
+      state.SkipWithError("Failed to parse NDJSON");
+      return;
+    }
+  }
+  benchmark::DoNotOptimize(records);
+  state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(data.size()));
+}
+
+#endif
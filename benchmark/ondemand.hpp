@@ -58,6 +58,127 @@ static void BM_SonicOnDemand(benchmark::State& state, const OnDemand& data) {
                           int64_t(data.json.size()));
 }
 
+// Get many fields by one scan, or by a scan for each field.
+struct MultiOnDemand {
+  std::string file;
+  std::vector<sonic_json::JsonPointer> paths;
+  std::string json;
+};
+
+static void BM_SonicOnDemandMulti(benchmark::State& state,
+                                  const MultiOnDemand& data) {
+  sonic_json::JsonPointerTrie trie(data.paths);
+  std::vector<sonic_json::StringView> targets;
+  for (auto _ : state) {
+    sonic_json::GetOnDemand(data.json, trie, targets);
+    benchmark::DoNotOptimize(targets.data());
+  }
+  state.SetItemsProcessed(int64_t(state.iterations()) *
+                          int64_t(data.paths.size()));
+}
+
+static void BM_SonicOnDemandEach(benchmark::State& state,
+                                 const MultiOnDemand& data) {
+  sonic_json::StringView target;
+  for (auto _ : state) {
+    for (const auto& path : data.paths) {
+      sonic_json::GetOnDemand(data.json, path, target);
+      benchmark::DoNotOptimize(target.data());
+    }
+  }
+  state.SetItemsProcessed(int64_t(state.iterations()) *
+                          int64_t(data.paths.size()));
+}
+
+// Run the same jsonpath queries on a json, by a PreparedJson which reuses the
+// index of the previous queries, or by scanning the json for each one.
+struct RepeatedJsonPath {
+  std::string file;
+  std::vector<std::string> paths;
+  std::string json;
+};
+
+static void BM_SonicPreparedJsonPath(benchmark::State& state,
+                                     const RepeatedJsonPath& data) {
+  sonic_json::PreparedJson prepared(data.json);
+  for (auto _ : state) {
+    for (const auto& path : data.paths) {
+      auto got = prepared.GetByJsonPath(path);
+      benchmark::DoNotOptimize(got);
+    }
+  }
+  state.SetItemsProcessed(int64_t(state.iterations()) *
+                          int64_t(data.paths.size()));
+}
+
+static void BM_SonicJsonPathOnDemand(benchmark::State& state,
+                                     const RepeatedJsonPath& data) {
+  for (auto _ : state) {
+    for (const auto& path : data.paths) {
+      auto got = sonic_json::GetByJsonPathOnDemand(data.json, path);
+      benchmark::DoNotOptimize(got);
+    }
+  }
+  state.SetItemsProcessed(int64_t(state.iterations()) *
+                          int64_t(data.paths.size()));
+}
+
+// The same queries on a dom parsed from the json.
+static void BM_SonicJsonPathDom(benchmark::State& state,
+                                const RepeatedJsonPath& data) {
+  for (auto _ : state) {
+    for (const auto& path : data.paths) {
+      auto got = sonic_json::GetByJsonPath(data.json, path);
+      benchmark::DoNotOptimize(got);
+    }
+  }
+  state.SetItemsProcessed(int64_t(state.iterations()) *
+                          int64_t(data.paths.size()));
+}
+
+// The same queries by compiled plans, the paths are not parsed in the loop.
+static void BM_SonicJsonPathPlan(benchmark::State& state,
+                                 const RepeatedJsonPath& data) {
+  std::vector<sonic_json::JsonPathPlan> plans;
+  for (const auto& path : data.paths) plans.emplace_back(path);
+  for (auto _ : state) {
+    for (const auto& plan : plans) {
+      auto got = sonic_json::GetByJsonPathOnDemand(data.json, plan);
+      benchmark::DoNotOptimize(got);
+    }
+  }
+  state.SetItemsProcessed(int64_t(state.iterations()) *
+                          int64_t(data.paths.size()));
+}
+
+// The same queries by the plans from the thread-local cache.
+static void BM_SonicJsonPathCached(benchmark::State& state,
+                                   const RepeatedJsonPath& data) {
+  auto& cache = sonic_json::JsonPathPlanCache::ThreadLocal();
+  for (auto _ : state) {
+    for (const auto& path : data.paths) {
+      auto got = sonic_json::GetByJsonPathOnDemand(data.json, *cache.Get(path));
+      benchmark::DoNotOptimize(got);
+    }
+  }
+  state.SetItemsProcessed(int64_t(state.iterations()) *
+                          int64_t(data.paths.size()));
+}
+
+static void BM_SonicPreparedPointer(benchmark::State& state,
+                                    const MultiOnDemand& data) {
+  sonic_json::PreparedJson prepared(data.json);
+  sonic_json::StringView target;
+  for (auto _ : state) {
+    for (const auto& path : data.paths) {
+      prepared.GetOnDemand(path, target);
+      benchmark::DoNotOptimize(target.data());
+    }
+  }
+  state.SetItemsProcessed(int64_t(state.iterations()) *
+                          int64_t(data.paths.size()));
+}
+
 static inline bool SIMDjsonOnDemand(simdjson::ondemand::parser& parser,
                                     simdjson::padded_string& json_pad,
                                     const std::vector<std::string_view>& path,
@@ -0,0 +1,56 @@
+/*
+ * Copyright 2022 ByteDance Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#ifndef _PARALLEL_H_
+#define _PARALLEL_H_
+
+#include <benchmark/benchmark.h>
+#include <sonic/sonic.h>
+
+#include <string>
+#include <string_view>
+
+#include "ndjson.hpp"
+
+// A large array of log records.
+static std::string gen_array_logs(size_t records) {
+  std::string out = gen_ndjson_logs(records);
+  out.back() = ']';
+  for (auto &c : out) {
+    if (c == '\n') c = ',';
+  }
+  return "[" + out;
+}
+
+static void BM_SonicParseParallel(benchmark::State &state,
+                                  std::string_view data, size_t threads) {
+  sonic_json::Document doc;
+  for (auto _ : state) {
+    if (threads == 1) {
+      doc.Parse(data);
+    } else {
+      doc.ParseParallel(data, threads);
+    }
+    if (doc.HasParseError()) {
+      state.SkipWithError("Failed to parse array");
+      return;
+    }
+  }
+  state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(data.size()));
+}
+
+#endif
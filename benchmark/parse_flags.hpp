@@ -0,0 +1,98 @@
+/*
+ * Copyright 2022 ByteDance Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _PARSE_FLAGS_H_
+#define _PARSE_FLAGS_H_
+
+#include <benchmark/benchmark.h>
+#include <sonic/sonic.h>
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <string_view>
+
+// Decode with different parse flags. The input is padded so that it can be
+// parsed as borrowed input.
+template <ParseFlags parseFlags>
+static void BM_SonicDecodeFlags(benchmark::State& state, std::string filename,
+                                std::string_view data) {
+  std::string buf(data);
+  buf.append(SONICJSON_PADDING, '\0');
+  sonic_json::Document doc;
+  for (auto _ : state) {
+    doc.Parse<parseFlags>(buf.data(), data.size());
+  }
+  if (doc.HasParseError()) {
+    state.SkipWithError("Failed to parse file");
+    return;
+  }
+  state.SetLabel(filename);
+  state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(data.size()));
+}
+
+// Parse and serialize again, as a proxy which doesn't read the strings.
+template <ParseFlags parseFlags>
+static void BM_SonicRoundTripFlags(benchmark::State& state,
+                                   std::string filename,
+                                   std::string_view data) {
+  sonic_json::Document doc;
+  sonic_json::WriteBuffer wb;
+  for (auto _ : state) {
+    doc.Parse<parseFlags>(data.data(), data.size());
+    doc.Serialize(wb);
+  }
+  if (doc.HasParseError()) {
+    state.SkipWithError("Failed to parse file");
+    return;
+  }
+  state.SetLabel(filename);
+  state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(data.size()));
+}
+
+// Parse a file by reading it into a string, the usual way without ParseFile.
+static void BM_SonicReadAndParse(benchmark::State& state, std::string filename,
+                                 size_t size) {
+  sonic_json::Document doc;
+  for (auto _ : state) {
+    std::ifstream ifs(filename, std::ios::in | std::ios::binary);
+    std::stringstream ss;
+    ss << ifs.rdbuf();
+    doc.Parse(ss.str());
+  }
+  if (doc.HasParseError()) {
+    state.SkipWithError("Failed to parse file");
+    return;
+  }
+  state.SetLabel(filename);
+  state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(size));
+}
+
+static void BM_SonicParseFile(benchmark::State& state, std::string filename,
+                              size_t size) {
+  sonic_json::Document doc;
+  for (auto _ : state) {
+    doc.ParseFile(filename.c_str());
+  }
+  if (doc.HasParseError()) {
+    state.SkipWithError("Failed to parse file");
+    return;
+  }
+  state.SetLabel(filename);
+  state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(size));
+}
+
+#endif
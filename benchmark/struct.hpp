@@ -0,0 +1,147 @@
+/*
+ * Copyright 2022 ByteDance Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _STRUCT_H_
+#define _STRUCT_H_
+
+#include <benchmark/benchmark.h>
+#include <sonic/sonic.h>
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "parallel.hpp"
+
+namespace bench_struct {
+
+// The struct of the records from gen_ndjson_logs.
+struct LogRecord {
+  uint64_t ts = 0;
+  std::string level;
+  std::string host;
+  std::string path;
+  int status = 0;
+  double latency_ms = 0;
+  std::string msg;
+  std::vector<std::string> tags;
+};
+SONIC_DEFINE_FIELDS(LogRecord, ts, level, host, path, status, latency_ms, msg,
+                    tags)
+
+}  // namespace bench_struct
+
+// The baseline: parse into a document, and copy the fields into structs.
+static void BM_SonicStructByDom(benchmark::State &state,
+                                std::string_view data) {
+  using bench_struct::LogRecord;
+  sonic_json::Document doc;
+  std::vector<LogRecord> records;
+  for (auto _ : state) {
+    doc.Parse(data);
+    if (doc.HasParseError()) {
+      state.SkipWithError("Failed to parse array");
+      return;
+    }
+    records.clear();
+    for (auto it = doc.Begin(); it != doc.End(); ++it) {
+      LogRecord r;
+      r.ts = (*it)["ts"].GetUint64();
+      r.level = (*it)["level"].GetString();
+      r.host = (*it)["host"].GetString();
+      r.path = (*it)["path"].GetString();
+      r.status = (*it)["status"].GetInt64();
+      r.latency_ms = (*it)["latency_ms"].GetDouble();
+      r.msg = (*it)["msg"].GetString();
+      auto &tags = (*it)["tags"];
+      for (auto t = tags.Begin(); t != tags.End(); ++t) {
+        r.tags.emplace_back(t->GetString());
+      }
+      records.push_back(std::move(r));
+    }
+  }
+  benchmark::DoNotOptimize(records.data());
+  state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(data.size()));
+}
+
+static void BM_SonicStructDirect(benchmark::State &state,
+                                 std::string_view data) {
+  sonic_json::StructParser p;
+  std::vector<bench_struct::LogRecord> records;
+  for (auto _ : state) {
+    if (p.Parse(data, records).Error() != sonic_json::kErrorNone) {
+      state.SkipWithError("Failed to parse array");
+      return;
+    }
+  }
+  benchmark::DoNotOptimize(records.data());
+  state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(data.size()));
+}
+
+static std::vector<bench_struct::LogRecord> gen_log_records(
+    std::string_view data) {
+  std::vector<bench_struct::LogRecord> records;
+  sonic_json::ParseStruct(data, records);
+  return records;
+}
+
+// The baseline: build a document by AddMember and PushBack, and serialize
+// it. The strings are copied, the keys are literals.
+static void BM_SonicStructSerializeByDom(benchmark::State &state,
+                                         std::string_view data) {
+  using sonic_json::Node;
+  auto records = gen_log_records(data);
+  sonic_json::WriteBuffer wb;
+  for (auto _ : state) {
+    sonic_json::Document doc;
+    auto &a = doc.GetAllocator();
+    doc.SetArray();
+    for (const auto &r : records) {
+      Node obj(sonic_json::kObject);
+      obj.AddMember("ts", Node(r.ts), a, false);
+      obj.AddMember("level", Node(r.level, a), a, false);
+      obj.AddMember("host", Node(r.host, a), a, false);
+      obj.AddMember("path", Node(r.path, a), a, false);
+      obj.AddMember("status", Node(r.status), a, false);
+      obj.AddMember("latency_ms", Node(r.latency_ms), a, false);
+      obj.AddMember("msg", Node(r.msg, a), a, false);
+      Node tags(sonic_json::kArray);
+      for (const auto &t : r.tags) tags.PushBack(Node(t, a), a);
+      obj.AddMember("tags", std::move(tags), a, false);
+      doc.PushBack(std::move(obj), a);
+    }
+    if (doc.Serialize(wb) != sonic_json::kErrorNone) {
+      state.SkipWithError("Failed to serialize");
+      return;
+    }
+  }
+  state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(wb.Size()));
+}
+
+static void BM_SonicStructSerializeDirect(benchmark::State &state,
+                                          std::string_view data) {
+  auto records = gen_log_records(data);
+  sonic_json::WriteBuffer wb;
+  for (auto _ : state) {
+    if (sonic_json::SerializeStruct(records, wb) != sonic_json::kErrorNone) {
+      state.SkipWithError("Failed to serialize");
+      return;
+    }
+  }
+  state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(wb.Size()));
+}
+
+#endif
@@ -0,0 +1,136 @@
+/*
+ * Copyright 2022 ByteDance Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _TAPE_HPP_
+#define _TAPE_HPP_
+#include "json.h"
+#include "sonic/sonic.h"
+
+class SonicTapeStringResult : public StringResult<SonicTapeStringResult> {
+ public:
+  std::string_view str_impl() const { return wb.ToStringView(); }
+  sonic_json::WriteBuffer wb;
+};
+
+class SonicTapeParseResult
+    : public ParseResult<SonicTapeParseResult, SonicTapeStringResult> {
+ public:
+  sonic_json::TapeDocument doc;
+
+  SonicTapeParseResult(std::string_view json) { (void)json; }
+
+  bool contains_impl(std::string_view key) const {
+    (void)key;
+    return false;
+  }
+
+  bool stringfy_impl(SonicTapeStringResult &sr) const {
+    return doc.Serialize(sr.wb) == sonic_json::kErrorNone;
+  }
+
+  bool prettify_impl(SonicTapeStringResult &sr) const {
+    (void)sr;
+    return false;
+  }
+
+  bool stat_impl(DocStat &stat) const {
+    stat = DocStat();
+    GetStats(doc, stat);
+    return true;
+  }
+
+  bool find_impl(DocStat &stat) const {
+    stat = DocStat();
+    find_value(doc, stat);
+    return true;
+  }
+
+ private:
+  void find_value(const sonic_json::TapeNode &v, DocStat &stat) const {
+    switch (v.GetType()) {
+      case sonic_json::kObject:
+        for (auto m = v.MemberBegin(); m != v.MemberEnd(); ++m) {
+          auto re = v.FindMember(m->name.GetStringView());
+          if (re != v.MemberEnd()) {
+            stat.members++;
+            find_value(re->value, stat);
+          }
+        }
+        break;
+      case sonic_json::kArray:
+        for (auto i = v.Begin(); i != v.End(); ++i) {
+          find_value(*i, stat);
+        }
+        break;
+      default:
+        break;
+    }
+  }
+
+  void GetStats(const sonic_json::TapeNode &v, DocStat &stat,
+                size_t depth = 0) const {
+    switch (v.GetType()) {
+      case sonic_json::kNull:
+        stat.nulls++;
+        break;
+      case sonic_json::kFalse:
+        stat.falses++;
+        break;
+      case sonic_json::kTrue:
+        stat.trues++;
+        break;
+      case sonic_json::kObject:
+        if (depth > stat.depth) stat.depth = depth;
+        for (auto m = v.MemberBegin(); m != v.MemberEnd(); ++m) {
+          stat.length += m->name.Size();
+          stat.members++;
+          stat.strings++;
+          GetStats(m->value, stat, depth + 1);
+        }
+        stat.objects++;
+        break;
+      case sonic_json::kArray:
+        if (depth > stat.depth) stat.depth = depth;
+        for (auto i = v.Begin(); i != v.End(); ++i) {
+          stat.elements++;
+          GetStats(*i, stat, depth + 1);
+        }
+        stat.arrays++;
+        break;
+      case sonic_json::kStringCopy:
+        stat.strings++;
+        stat.length += v.Size();
+        break;
+      case sonic_json::kReal:
+      case sonic_json::kUint:
+      case sonic_json::kSint:
+        stat.numbers++;
+        break;
+      default:
+        break;
+    }
+  }
+};
+
+class SonicTape : public JsonBase<SonicTape, SonicTapeParseResult> {
+ public:
+  bool parse_impl(std::string_view json, SonicTapeParseResult &pr) const {
+    pr.doc.Parse(json.data(), json.size());
+    return !pr.doc.HasParseError();
+  }
+};
+
+#endif
@@ -0,0 +1,140 @@
+/*
+ * Copyright 2022 ByteDance Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef _WRITER_H_
+#define _WRITER_H_
+
+#include <benchmark/benchmark.h>
+#include <sonic/sonic.h>
+
+#include <string>
+#include <string_view>
+
+// Generate the output by walking a parsed document, so both benchmarks
+// produce the same JSON from the same source values.
+static sonic_json::Node build_node(const sonic_json::Node &src,
+                                   sonic_json::Document::Allocator &a) {
+  using sonic_json::Node;
+  switch (src.GetType()) {
+    case sonic_json::kObject: {
+      Node obj(sonic_json::kObject);
+      for (auto m = src.MemberBegin(); m != src.MemberEnd(); ++m) {
+        obj.AddMember(m->name.GetStringView(), build_node(m->value, a), a);
+      }
+      return obj;
+    }
+    case sonic_json::kArray: {
+      Node arr(sonic_json::kArray);
+      for (auto e = src.Begin(); e != src.End(); ++e) {
+        arr.PushBack(build_node(*e, a), a);
+      }
+      return arr;
+    }
+    case sonic_json::kStringCopy:
+    case sonic_json::kStringFree:
+      return Node(src.GetStringView(), a);
+    case sonic_json::kSint:
+      return Node(src.GetInt64());
+    case sonic_json::kUint:
+      return Node(src.GetUint64());
+    case sonic_json::kReal:
+      return Node(src.GetDouble());
+    case sonic_json::kTrue:
+      return Node(true);
+    case sonic_json::kFalse:
+      return Node(false);
+    default:
+      return Node();
+  }
+}
+
+static void write_node(const sonic_json::Node &src, sonic_json::Writer &w) {
+  switch (src.GetType()) {
+    case sonic_json::kObject:
+      w.StartObject();
+      for (auto m = src.MemberBegin(); m != src.MemberEnd(); ++m) {
+        w.Key(m->name.GetStringView());
+        write_node(m->value, w);
+      }
+      w.EndObject();
+      break;
+    case sonic_json::kArray:
+      w.StartArray();
+      for (auto e = src.Begin(); e != src.End(); ++e) write_node(*e, w);
+      w.EndArray();
+      break;
+    case sonic_json::kStringCopy:
+    case sonic_json::kStringFree:
+      w.String(src.GetStringView());
+      break;
+    case sonic_json::kSint:
+      w.Int(src.GetInt64());
+      break;
+    case sonic_json::kUint:
+      w.Uint(src.GetUint64());
+      break;
+    case sonic_json::kReal:
+      w.Double(src.GetDouble());
+      break;
+    case sonic_json::kTrue:
+    case sonic_json::kFalse:
+      w.Bool(src.GetBool());
+      break;
+    default:
+      w.Null();
+      break;
+  }
+}
+
+// The baseline: build a document by AddMember and PushBack, and serialize it.
+static void BM_SonicWriteByDom(benchmark::State &state, std::string filename,
+                               std::string_view data) {
+  sonic_json::Document src;
+  src.Parse(data);
+  if (src.HasParseError()) {
+    state.SkipWithError("Failed to parse file");
+    return;
+  }
+  sonic_json::WriteBuffer wb;
+  for (auto _ : state) {
+    sonic_json::Document doc;
+    sonic_json::Node root = build_node(src, doc.GetAllocator());
+    static_cast<sonic_json::Node &>(doc).Swap(root);
+    doc.Serialize(wb);
+  }
+  state.SetLabel(filename);
+  state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(wb.Size()));
+}
+
+static void BM_SonicWriter(benchmark::State &state, std::string filename,
+                           std::string_view data) {
+  sonic_json::Document src;
+  src.Parse(data);
+  if (src.HasParseError()) {
+    state.SkipWithError("Failed to parse file");
+    return;
+  }
+  sonic_json::WriteBuffer wb;
+  sonic_json::Writer w(wb);
+  for (auto _ : state) {
+    w.Reset();
+    write_node(src, w);
+  }
+  state.SetLabel(filename);
+  state.SetBytesProcessed(int64_t(state.iterations()) * int64_t(wb.Size()));
+}
+
+#endif
@@ -187,6 +187,7 @@ class MemoryPoolAllocator {
   struct SharedData {
     ChunkHeader* chunkHead;  //!< Head of the chunk linked-list. Only the head
                              //!< chunk serves allocation.
+    ChunkHeader* spareHead;  //!< Chunks kept by Rewind() for reuse.
     BaseAllocator*
         ownBaseAllocator;  //!< base allocator created by this object.
     size_t refcount;
@@ -240,6 +241,7 @@ class MemoryPoolAllocator {
     shared_->chunkHead->capacity = 0;
     shared_->chunkHead->size = 0;
     shared_->chunkHead->next = 0;
+    shared_->spareHead = 0;
     shared_->ownBuffer = true;
     shared_->refcount = 1;
   }
@@ -269,6 +271,7 @@ class MemoryPoolAllocator {
         size - SIZEOF_SHARED_DATA - SIZEOF_CHUNK_HEADER;
     shared_->chunkHead->size = 0;
     shared_->chunkHead->next = 0;
+    shared_->spareHead = 0;
     shared_->ownBaseAllocator = baseAllocator ? 0 : baseAllocator_;
     shared_->ownBuffer = false;
     shared_->refcount = 1;
@@ -329,6 +332,10 @@ class MemoryPoolAllocator {
   //! Deallocates all memory chunks, excluding the first/user one.
   void Clear() noexcept {
     sonic_assert(shared_->refcount > 0);
+    while (ChunkHeader* c = shared_->spareHead) {
+      shared_->spareHead = c->next;
+      baseAllocator_->Free(c);
+    }
     for (;;) {
       ChunkHeader* c = shared_->chunkHead;
       if (!c->next) {
@@ -340,6 +347,25 @@ class MemoryPoolAllocator {
     shared_->chunkHead->size = 0;
   }
 
+  //! Rewinds all memory chunks to empty, and keeps them for reuse.
+  /*! The later allocations are served by the kept chunks at first, so a
+      steady workload does not allocate memory from the base allocator.
+   */
+  void Rewind() noexcept {
+    sonic_assert(shared_->refcount > 0);
+    for (;;) {
+      ChunkHeader* c = shared_->chunkHead;
+      if (!c->next) {
+        break;
+      }
+      shared_->chunkHead = c->next;
+      c->size = 0;
+      c->next = shared_->spareHead;
+      shared_->spareHead = c;
+    }
+    shared_->chunkHead->size = 0;
+  }
+
   //! Computes the total capacity of allocated memory chunks.
   /*! \return total capacity in bytes.
    */
@@ -348,6 +374,8 @@ class MemoryPoolAllocator {
     size_t capacity = 0;
     for (ChunkHeader* c = shared_->chunkHead; c != 0; c = c->next)
       capacity += c->capacity;
+    for (ChunkHeader* c = shared_->spareHead; c != 0; c = c->next)
+      capacity += c->capacity;
     return capacity;
   }
 
@@ -379,7 +407,7 @@ class MemoryPoolAllocator {
     LOCK_GUARD;
     if (sonic_unlikely(shared_->chunkHead->size + size >
                        shared_->chunkHead->capacity)) {
-      if (!AddChunk(cp_.ChunkSize(size))) {
+      if (!ReuseChunk(size) && !AddChunk(cp_.ChunkSize(size))) {
         shared_->hadOom.store(true, std::memory_order_release);
         return NULL;
       }
@@ -473,6 +501,23 @@ class MemoryPoolAllocator {
     return false;
   }
 
+  //! Takes a kept chunk as the head chunk.
+  /*! \param size The size needed in the chunk.
+      \return true if success.
+  */
+  bool ReuseChunk(size_t size) {
+    for (ChunkHeader** p = &shared_->spareHead; *p != 0; p = &(*p)->next) {
+      ChunkHeader* chunk = *p;
+      if (chunk->capacity >= size) {
+        *p = chunk->next;
+        chunk->next = shared_->chunkHead;
+        shared_->chunkHead = chunk;
+        return true;
+      }
+    }
+    return false;
+  }
+
   static inline void* AlignBuffer(void* buf, size_t& size) {
     sonic_assert(buf != 0);
     const uintptr_t mask = sizeof(void*) - 1;
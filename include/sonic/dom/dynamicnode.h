@@ -16,7 +16,11 @@
 
 #pragma once
 
-#include <map>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
 #include <type_traits>
 #include <utility>
 
@@ -28,6 +32,9 @@
 #include "sonic/dom/type.h"
 #include "sonic/error.h"
 #include "sonic/internal/ftoa.h"
+#include "sonic/internal/member_index.h"
+#include "sonic/internal/utils.h"
+#include "sonic/span.h"
 #include "sonic/writebuffer.h"
 
 namespace sonic_json {
@@ -50,6 +57,7 @@ class DNode : public GenericNode<DNode<Allocator>> {
   friend class SAXHandler<DNode>;
   friend class LazySAXHandler<DNode>;
   friend class SchemaHandler<DNode>;
+  friend class GenericDocument<DNode>;
 
   friend BaseNode;
   template <typename>
@@ -105,7 +113,19 @@ class DNode : public GenericNode<DNode<Allocator>> {
       case kArray: {
         size_t a_size = rhs.Size();
         this->a.len = rhs.getTypeAndLen();  // Copy size and type.
-        if (a_size > 0) {
+        if (rhs.isPackedArray()) {
+          // copy the packed values, the allocator of this node is kept
+          void* mem = packedMalloc(a_size, alloc);
+          if (sonic_unlikely(mem == nullptr)) {
+            this->setLength(0, kArray);
+            setChildren(nullptr);
+            break;
+          }
+          std::memcpy(packedValues(mem),
+                      rhs.template packedSpanImpl<uint64_t>().data(),
+                      a_size * sizeof(uint64_t));
+          setChildren(mem);
+        } else if (a_size > 0) {
           void* mem = containerMalloc<DNode>(a_size, alloc);
           if (sonic_unlikely(mem == nullptr)) {
             this->setLength(0, kArray);
@@ -125,6 +145,12 @@ class DNode : public GenericNode<DNode<Allocator>> {
         break;
       }
       case kString: {
+        if (sonic_unlikely(rhs.isEscapedString())) {
+          // the string kept by kParseLazyStrings is copied unescaped
+          StringView str = rhs.GetStringView();
+          this->StringCopy(str.data(), str.size(), alloc);
+          break;
+        }
         this->sv.len = rhs.getTypeAndLen();  // Copy size and type.
         if (rhs.GetType() != kStringConst || copyString) {
           this->StringCopy(rhs.GetStringView().data(), rhs.Size(), alloc);
@@ -134,6 +160,12 @@ class DNode : public GenericNode<DNode<Allocator>> {
         break;
       }
       case kNumber: {
+        if (sonic_unlikely(rhs.isLazyNumber())) {
+          // the text is in the buffer of rhs
+          this->setType(kReal);
+          this->n.f64 = rhs.GetDouble();
+          break;
+        }
         if (rhs.GetType() != kNumStr) {
           std::memcpy(&(this->data), &rhs, sizeof(this->data));
           break;
@@ -226,6 +258,9 @@ class DNode : public GenericNode<DNode<Allocator>> {
         if (this->Size() != rhs.Size()) {
           return false;
         }
+        if (sonic_unlikely(this->isPackedArray() || rhs.isPackedArray())) {
+          return packedEqual(rhs);
+        }
         auto rhs_it = rhs.Begin();
         for (auto lhs_it = this->Begin(), lhs_e = this->End(); lhs_it != lhs_e;
              ++rhs_it, ++lhs_it) {
@@ -249,6 +284,10 @@ class DNode : public GenericNode<DNode<Allocator>> {
         if (this->GetType() != rhs.GetType()) {
           return false;
         }
+        if (sonic_unlikely(this->isLazyNumber() || rhs.isLazyNumber())) {
+          double l = this->GetDouble(), r = rhs.GetDouble();
+          return !std::memcmp(&l, &r, sizeof(l));
+        }
         // Exactly equal for double.
         return !std::memcmp(this, &rhs, sizeof(rhs));
 
@@ -306,7 +345,9 @@ class DNode : public GenericNode<DNode<Allocator>> {
   using BaseNode::HasMember;
 
   /**
-   * @brief Create a map to trace all members of this object.
+   * @brief Create a map to trace all members of this object. The map is a
+   * flat hash index of the member positions, and it is maintained by
+   * AddMember and RemoveMember.
    * @param alloc allocator that maintain this node's memory
    * @retval true successful
    * @retval false failed, which means that no memory can be allocated by
@@ -323,13 +364,8 @@ class DNode : public GenericNode<DNode<Allocator>> {
       if (nullptr == children()) return false;
     }
     if (getMapUnsafe()) return true;
-    map_type* map = static_cast<map_type*>(alloc.Malloc(sizeof(map_type)));
+    map_type* map = buildMap(this->Size(), alloc);
     if (nullptr == map) return false;
-    new (map) map_type(MAType(&alloc));
-    MemberNode* m = (MemberNode*)getObjChildrenFirstUnsafe();
-    for (size_t i = 0; i < this->Size(); ++i) {
-      map->emplace(std::make_pair((m + i)->name.GetStringView(), i));
-    }
     setMap(map);
     return true;
   }
@@ -346,17 +382,63 @@ class DNode : public GenericNode<DNode<Allocator>> {
 
   /**
    * @brief Destroy the created map. This means that you don't want maintain the
-   * map anymore.
+   * map anymore. The automatic map of EnableAutoMap is disabled as well.
    */
   void DestroyMap() {
     sonic_assert(this->IsObject());
-    if (getMap()) {
-      getMap()->~map_type();
-      Allocator::Free(getMap());
-      setMap(nullptr);
+    if (nullptr == children()) return;
+    releaseMap();
+    if (AutoMap* am = autoMap()) {
+      Allocator::Free(am);
+      meta()->map = 0;
     }
   }
 
+  /**
+   * @brief Create the maps of objects automatically when they are looked up
+   * frequently, for this node and all the objects in it. The objects having
+   * at least `min_members` members are traced: the map is created after
+   * `min_lookups` calls of FindMember without map, and it is destroyed when
+   * the object has been changed as many times as its size since then. The
+   * map is created again if the object is looked up frequently later.
+   * @param alloc allocator that maintain this node's memory, it is kept to
+   * create the maps.
+   * @retval false failed, which means that no memory can be allocated by
+   * allocator.
+   * @note FindMember may create the map, so it is not thread-safe to look up
+   * the traced objects concurrently.
+   */
+  bool EnableAutoMap(Allocator& alloc, size_t min_members = 32,
+                     size_t min_lookups = 64) {
+    if (this->IsArray()) {
+      if (this->isPackedArray()) return true;
+      for (auto it = this->Begin(), e = this->End(); it != e; ++it) {
+        if (!it->EnableAutoMap(alloc, min_members, min_lookups)) return false;
+      }
+      return true;
+    }
+    if (!this->IsObject()) return true;
+    for (auto m = this->MemberBegin(), e = this->MemberEnd(); m != e; ++m) {
+      if (!m->value.EnableAutoMap(alloc, min_members, min_lookups)) {
+        return false;
+      }
+    }
+    if (this->Size() < min_members || nullptr == children() ||
+        nullptr != autoMap()) {
+      return true;
+    }
+    AutoMap* am = static_cast<AutoMap*>(alloc.Malloc(sizeof(AutoMap)));
+    if (nullptr == am) return false;
+    am->alloc = &alloc;
+    am->map = getMapUnsafe();
+    am->min_members = uint32_t(std::min<size_t>(min_members, UINT32_MAX));
+    am->min_lookups = uint32_t(std::min<size_t>(min_lookups, UINT32_MAX));
+    am->lookups = 0;
+    am->changes = 0;
+    meta()->map = reinterpret_cast<uintptr_t>(am) | kAutoMapTag;
+    return true;
+  }
+
   using BaseNode::RemoveMember;
 
   /**
@@ -383,34 +465,39 @@ class DNode : public GenericNode<DNode<Allocator>> {
    */
 
  private:
-  using MSType = StringView;
-  using MAType = MapAllocator<std::pair<const MSType, size_t>, Allocator>;
-#if defined(SONIC_STATIC_DISPATCH)
-  struct Less {
-    bool operator()(MSType s1, MSType s2) const {
-      size_t n1 = s1.size(), n2 = s2.size();
-      const size_t len = std::min(n1, n2);
-      int cmp = internal::InlinedMemcmp(s1.data(), s2.data(), len);
-      return cmp < 0 || (cmp == 0 && n1 < n2);
-    }
+  using map_type = internal::MemberIndex;
+
+  // The state of the automatic map, see EnableAutoMap.
+  struct AutoMap {
+    Allocator* alloc;
+    map_type* map;
+    uint32_t min_members;
+    uint32_t min_lookups;
+    // the lookups without map
+    uint32_t lookups;
+    // the changes since the map is created
+    uint32_t changes;
   };
-  using map_type = std::multimap<MSType, size_t, Less, MAType>;
-#else
-  using map_type = std::multimap<MSType, size_t, std::less<MSType>, MAType>;
-#endif
+
+  // The lowest bit of MetaNode::map marks an AutoMap.
+  constexpr static uintptr_t kAutoMapTag = 1;
 
   struct MetaNode {
     size_t cap;
-    map_type* map;
+    // map_type* or AutoMap* with kAutoMapTag
+    uintptr_t map;
 
     ~MetaNode() {
-      if (map) {
-        map->~map_type();
-        Allocator::Free(map);
+      if (map & kAutoMapTag) {
+        AutoMap* am = reinterpret_cast<AutoMap*>(map ^ kAutoMapTag);
+        if (am->map) Allocator::Free(am->map);
+        Allocator::Free(am);
+      } else if (map) {
+        Allocator::Free(reinterpret_cast<void*>(map));
       }
     }
-    MetaNode() : cap{0}, map{nullptr} {}
-    MetaNode(size_t n) : cap{n}, map{nullptr} {}
+    MetaNode() : cap{0}, map{0} {}
+    MetaNode(size_t n) : cap{n}, map{0} {}
     void SetMetaCap(size_t n) { cap = n; }
   };
 
@@ -523,12 +610,14 @@ class DNode : public GenericNode<DNode<Allocator>> {
   }
 
   DNode& popBackImpl() {
+    if (sonic_unlikely(!unpackArray())) return *this;
     getArrChildrenFirstUnsafe()[this->Size() - 1].~DNode();
     this->subLength(1);
     return *this;
   }
 
   DNode& reserveImpl(size_t new_cap, Allocator& alloc) {
+    if (sonic_unlikely(!unpackArray())) return *this;
     if (new_cap > this->Capacity()) {
       void* mem =
           containerRealloc<DNode>(children(), this->Capacity(), new_cap, alloc);
@@ -537,30 +626,310 @@ class DNode : public GenericNode<DNode<Allocator>> {
     return *this;
   }
 
+  // The range is empty if the packed array can't be unpacked.
   ValueIterator beginImpl() noexcept {
+    if (sonic_unlikely(!unpackArray())) return ValueIterator(nullptr);
     return ValueIterator(getArrChildrenFirst());
   }
 
+  // The range is empty if the nodes of the packed array can't be made.
   ConstValueIterator cbeginImpl() const noexcept {
+    if (sonic_unlikely(this->isPackedArray())) return packedNodes();
     return ConstValueIterator(getArrChildrenFirst());
   }
 
   ValueIterator endImpl() noexcept {
+    if (sonic_unlikely(!unpackArray())) return ValueIterator(nullptr);
     return ValueIterator(getArrChildrenFirst()) + this->Size();
   }
 
   ConstValueIterator cendImpl() const noexcept {
-    return ConstValueIterator(getArrChildrenFirst()) + this->Size();
+    ConstValueIterator first = cbeginImpl();
+    return first != nullptr ? first + this->Size() : first;
   }
 
-  DNode& backImpl() const noexcept {
-    return *(getArrChildrenFirst() + this->Size() - 1);
+  DNode& backImpl() noexcept { return findValueImpl(this->Size() - 1); }
+
+  const DNode& backImpl() const noexcept {
+    return findValueImpl(this->Size() - 1);
   }
 
   size_t capacityImpl() const noexcept {
     return children() != nullptr ? meta()->cap : 0;
   }
 
+  template <typename T>
+  sonic_force_inline Span<const T> packedSpanImpl() const noexcept {
+    return Span<const T>(reinterpret_cast<const T*>(packedValues(children())),
+                         this->Size());
+  }
+
+  static sonic_force_inline uint64_t* packedValues(void* mem) {
+    return reinterpret_cast<uint64_t*>((char*)mem + sizeof(MetaNode));
+  }
+
+  // The slot after the values keeps the nodes made by the const accessors,
+  // see packedNodes.
+  static sonic_force_inline std::atomic<void*>* packedNodesSlot(void* mem,
+                                                               size_t count) {
+    return reinterpret_cast<std::atomic<void*>*>(packedValues(mem) + count);
+  }
+
+  // Allocate the values of a packed array. The allocator is kept in the meta
+  // node to unpack the array.
+  static void* packedMalloc(size_t count, Allocator& alloc) {
+    void* mem = alloc.Malloc(sizeof(MetaNode) + count * sizeof(uint64_t) +
+                             sizeof(std::atomic<void*>));
+    if (sonic_likely(mem != nullptr)) {
+      MetaNode* m = new (static_cast<MetaNode*>(mem)) MetaNode(count);
+      m->map = reinterpret_cast<uintptr_t>(&alloc);
+      new (packedNodesSlot(mem, count)) std::atomic<void*>(nullptr);
+    }
+    return mem;
+  }
+
+  // Pack the numbers following this node on the parsing stack, if they are
+  // all doubles, or all integers in int64_t. The nodes are left as they are
+  // if not packed.
+  bool packNumbers(size_t count, Allocator& alloc) {
+    const DNode* elems = this + 1;
+    // the integers keep their types when unpacked
+    auto is_int = [](const DNode& e) {
+      return (e.t.t == kUint && e.n.i64 >= 0) ||
+             (e.t.t == kSint && e.n.i64 < 0);
+    };
+    const bool ints = elems[0].t.t != kReal;
+    if (ints) {
+      for (size_t i = 0; i < count; i++) {
+        if (!is_int(elems[i])) return false;
+      }
+    } else {
+      for (size_t i = 1; i < count; i++) {
+        if (elems[i].t.t != kReal) return false;
+      }
+    }
+    void* mem = packedMalloc(count, alloc);
+    if (sonic_unlikely(mem == nullptr)) return false;
+    uint64_t* vals = packedValues(mem);
+    for (size_t i = 0; i < count; i++) vals[i] = elems[i].n.u64;
+    this->setLength(count, static_cast<TypeFlag>(
+                               kArray | kPackedArrayMask |
+                               (ints ? kPackedIntMask : 0)));
+    setChildren(mem);
+    return true;
+  }
+
+  static DNode packedNode(uint64_t val, bool ints) noexcept {
+    if (ints) return DNode(static_cast<int64_t>(val));
+    double d;
+    std::memcpy(&d, &val, sizeof(d));
+    return DNode(d);
+  }
+
+  static void makeNodes(DNode* nodes, const uint64_t* vals, size_t n,
+                        bool ints) noexcept {
+    for (size_t i = 0; i < n; i++) {
+      new (nodes + i) DNode(packedNode(vals[i], ints));
+    }
+  }
+
+  // The const accessors read the nodes made from the values once, rather than
+  // unpacking the array, so the values and the spans stay valid. The nodes are
+  // kept with the values until the array is unpacked or destroyed. Return
+  // nullptr if no memory.
+  sonic_force_inline const DNode* packedNodes() const noexcept {
+    void* mem = packedNodesSlot(children(), this->Size())
+                    ->load(std::memory_order_acquire);
+    if (sonic_unlikely(mem == nullptr)) mem = makePackedNodes();
+    if (sonic_unlikely(mem == nullptr)) return nullptr;
+    return (const DNode*)((char*)mem + sizeof(MetaNode));
+  }
+
+  sonic_never_inline void* makePackedNodes() const noexcept {
+    // the readers may share the allocator
+    static std::mutex mutex;
+    std::lock_guard<std::mutex> lock(mutex);
+    const size_t n = this->Size();
+    std::atomic<void*>* slot = packedNodesSlot(children(), n);
+    void* mem = slot->load(std::memory_order_relaxed);
+    if (mem != nullptr) return mem;
+    MetaNode* m = meta();
+    mem = containerMalloc<DNode>(n, *reinterpret_cast<Allocator*>(m->map));
+    if (sonic_unlikely(mem == nullptr)) return nullptr;
+    makeNodes((DNode*)((char*)mem + sizeof(MetaNode)), packedValues(m), n,
+              (this->t.t & kPackedIntMask) != 0);
+    slot->store(mem, std::memory_order_release);
+    return mem;
+  }
+
+  // The packed array is unpacked into nodes when its nodes are accessed as
+  // mutable, which takes the nodes made by the const accessors if any. Return
+  // false if no memory, and the array is kept packed.
+  sonic_force_inline bool unpackArray() noexcept {
+    if (sonic_likely(!this->isPackedArray())) return true;
+    return unpackNumbers();
+  }
+
+  sonic_never_inline bool unpackNumbers() noexcept {
+    MetaNode* m = meta();
+    Allocator& alloc = *reinterpret_cast<Allocator*>(m->map);
+    const size_t n = this->Size();
+    const bool ints = (this->t.t & kPackedIntMask) != 0;
+    void* mem = packedNodesSlot(m, n)->load(std::memory_order_relaxed);
+    if (mem == nullptr) {
+      mem = containerMalloc<DNode>(n, alloc);
+      if (sonic_unlikely(mem == nullptr)) return false;
+      makeNodes((DNode*)((char*)mem + sizeof(MetaNode)), packedValues(m), n,
+                ints);
+    }
+    Allocator::Free(m);
+    this->setLength(n, kArray);
+    setChildren(mem);
+    return true;
+  }
+
+  // Compare the arrays of the same size, at least one is packed.
+  template <typename SourceAllocator>
+  bool packedEqual(const DNode<SourceAllocator>& rhs) const noexcept {
+    if (!this->isPackedArray()) return rhs.packedEqual(*this);
+    const bool ints = (this->t.t & kPackedIntMask) != 0;
+    Span<const uint64_t> vals = packedSpanImpl<uint64_t>();
+    if (rhs.isPackedArray()) {
+      return ints == !rhs.GetInt64Span().empty() &&
+             !std::memcmp(vals.data(),
+                          rhs.template packedSpanImpl<uint64_t>().data(),
+                          vals.size() * sizeof(uint64_t));
+    }
+    auto rhs_it = rhs.Begin();
+    for (size_t i = 0; i < vals.size(); ++i, ++rhs_it) {
+      if (packedNode(vals[i], ints) != *rhs_it) return false;
+    }
+    return true;
+  }
+
+  // Test the jsonpath filter on the node.
+  static bool matchFilter(const DNode* node,
+                          const internal::JsonPathFilter& filter) {
+    const auto& queries = filter.Queries();
+    // the filters have a few queries, not allocate for each node
+    constexpr size_t kShort = 8;
+    internal::FilterValue short_values[kShort];
+    std::vector<internal::FilterValue> long_values;
+    internal::FilterValue* values = short_values;
+    if (sonic_unlikely(queries.size() > kShort)) {
+      long_values.resize(queries.size());
+      values = long_values.data();
+    }
+    for (size_t i = 0; i < queries.size(); i++) {
+      const DNode* v = node->AtPointer(queries[i]);
+      values[i] = v != nullptr ? toFilterValue(*v) : internal::FilterValue();
+    }
+    return filter.Eval(values, [](const internal::FilterValue& a,
+                                  const internal::FilterValue& b) {
+      return *static_cast<const DNode*>(a.node) ==
+             *static_cast<const DNode*>(b.node);
+    });
+  }
+
+  static internal::FilterValue toFilterValue(const DNode& v) {
+    internal::FilterValue ret;
+    ret.node = &v;
+    if (v.IsNull()) {
+      ret.kind = internal::FilterValue::kNull;
+    } else if (v.IsTrue()) {
+      ret.kind = internal::FilterValue::kTrue;
+    } else if (v.IsFalse()) {
+      ret.kind = internal::FilterValue::kFalse;
+    } else if (v.IsStringNumber()) {
+      StringView text = v.GetStringView();
+      ret.kind = internal::FilterValue::kNumber;
+      ret.num =
+          internal::AtofNative(text.data(), static_cast<int>(text.size()));
+    } else if (v.IsNumber()) {
+      ret.kind = internal::FilterValue::kNumber;
+      ret.num = v.GetDouble();
+    } else if (v.IsString()) {
+      ret.kind = internal::FilterValue::kString;
+      ret.str = v.GetStringView();
+    } else {
+      ret.kind = internal::FilterValue::kContainer;
+    }
+    return ret;
+  }
+
+  // The children of the node selected by the path. The packed arrays are
+  // unpacked when selected from the mutable nodes. Return nullptr if no memory.
+  static DNode* jsonPathChildren(DNode* self) {
+    if (sonic_unlikely(!self->unpackArray())) return nullptr;
+    return self->getChildrenFirstUnsafe();
+  }
+
+  static const DNode* jsonPathChildren(const DNode* self) {
+    if (sonic_unlikely(self->isPackedArray())) return self->packedNodes();
+    return self->getChildrenFirstUnsafe();
+  }
+
+  // Select the children of self and its descendants by path[index] in the
+  // document order, and match the rest of the path on them. The containers
+  // are walked by an explicit stack, as the json may be nested deeply.
+  template <typename ResPtr, typename SelfPtr>
+  static void atJsonPathDescendants(SelfPtr self,
+                                    const internal::JsonPath& path,
+                                    size_t index, std::vector<ResPtr>& res) {
+    using CurPtr = std::conditional_t<
+        std::is_const<std::remove_pointer_t<ResPtr>>::value, const DNode*,
+        DNode*>;
+    struct Level {
+      CurPtr first;
+      size_t size;
+      size_t next;
+      bool is_obj;
+      int64_t idx;
+    };
+    const internal::JsonPathNode& node = path[index];
+    std::vector<Level> levels;
+    auto push = [&](CurPtr cur) {
+      if (!cur->IsObject() && !cur->IsArray()) {
+        return;
+      }
+      auto* first = jsonPathChildren(cur);
+      if (sonic_unlikely(first == nullptr)) {
+        return;
+      }
+      const bool is_obj = cur->IsObject();
+      // index maybe negative
+      int64_t idx = node.is_index() ? node.index() : 0;
+      if (idx < 0) {
+        idx += cur->Size();
+      }
+      levels.push_back({reinterpret_cast<CurPtr>(first) + (is_obj ? 1 : 0),
+                        cur->Size(), 0, is_obj, idx});
+    };
+    push(self);
+    while (!levels.empty()) {
+      Level& top = levels.back();
+      if (top.next == top.size) {
+        levels.pop_back();
+        continue;
+      }
+      const size_t i = top.next++;
+      const bool is_obj = top.is_obj;
+      CurPtr cur = top.first + i * (is_obj ? 2 : 1);
+      bool matched = node.is_wildcard();
+      if (node.is_filter()) {
+        matched = matchFilter(cur, path.filter(node));
+      } else if (is_obj && node.is_key()) {
+        matched = (cur - 1)->GetStringView() == node.key();
+      } else if (!is_obj && node.is_index()) {
+        matched = int64_t(i) == top.idx;
+      }
+      if (matched) {
+        atJsonPathImplCommon<ResPtr>(cur, path, index + 1, res);
+      }
+      push(cur);
+    }
+  }
+
   template <typename ResPtr, typename SelfPtr>
   static bool atJsonPathImplCommon(SelfPtr self, const internal::JsonPath& path,
                                    size_t index, std::vector<ResPtr>& res) {
@@ -571,19 +940,31 @@ class DNode : public GenericNode<DNode<Allocator>> {
       return true;
     }
 
-    if (path[index].is_wildcard()) {
+    if (path[index].is_descendant()) {
+      atJsonPathDescendants<ResPtr>(self, path, index + 1, res);
+      return true;
+    }
+
+    if (path[index].is_wildcard() || path[index].is_filter()) {
       // select nothing from the primitive JSON value
       if (!self->IsObject() && !self->IsArray()) {
         return true;
       }
+      auto* first = jsonPathChildren(self);
+      if (sonic_unlikely(first == nullptr)) {
+        return true;
+      }
       using CurPtr = std::conditional_t<
           std::is_const<std::remove_pointer_t<ResPtr>>::value, const DNode*,
           DNode*>;
-      CurPtr n = reinterpret_cast<CurPtr>(self->getChildrenFirstUnsafe()) +
-                 (self->IsObject() ? 1 : 0);
+      CurPtr n = reinterpret_cast<CurPtr>(first) + (self->IsObject() ? 1 : 0);
       size_t step = self->IsObject() ? 2 : 1;
       for (size_t i = 0; i < self->Size(); ++i) {
         CurPtr cur = (n + i * step);
+        if (path[index].is_filter() &&
+            !matchFilter(cur, path.filter(path[index]))) {
+          continue;
+        }
         atJsonPathImplCommon<ResPtr>(cur, path, index + 1, res);
       }
       return true;
@@ -633,7 +1014,7 @@ class DNode : public GenericNode<DNode<Allocator>> {
       if (sonic_likely(mem != nullptr)) {
         setChildren(mem);
         if (old_cap == 0) {
-          setMap(nullptr);  // Set map as nullptr when first alloc memory.
+          meta()->map = 0;  // Set map as nullptr when first alloc memory.
         }
       }
     }
@@ -667,7 +1048,8 @@ class DNode : public GenericNode<DNode<Allocator>> {
   }
 
   template <typename T>
-  sonic_force_inline void* containerMalloc(size_t cap, Allocator& alloc) {
+  static sonic_force_inline void* containerMalloc(size_t cap,
+                                                 Allocator& alloc) {
     size_t alloc_size = cap * sizeof(T) + sizeof(MetaNode);
     void* mem = alloc.Malloc(alloc_size);
     if (sonic_likely(mem != nullptr)) {
@@ -698,8 +1080,10 @@ class DNode : public GenericNode<DNode<Allocator>> {
     return (MetaNode*)(this->a.next.children);
   }
 
+  // The packed arrays are unpacked by the callers, see unpackArray.
   sonic_force_inline DNode* getArrChildrenFirst() const {
     sonic_assert(this->IsArray());
+    sonic_assert(!this->isPackedArray());
     if (nullptr == children()) {
       return nullptr;
     }
@@ -709,11 +1093,13 @@ class DNode : public GenericNode<DNode<Allocator>> {
 
   sonic_force_inline DNode* getArrChildrenFirstUnsafe() const {
     sonic_assert(this->IsArray());
+    sonic_assert(!this->isPackedArray());
     return (DNode*)((char*)this->a.next.children +
                     sizeof(MetaNode) / sizeof(char));
   }
 
   sonic_force_inline DNode* getChildrenFirstUnsafe() const {
+    sonic_assert(!this->isPackedArray());
     return (DNode*)((char*)this->a.next.children +
                     sizeof(MetaNode) / sizeof(char));
   }
@@ -749,24 +1135,83 @@ class DNode : public GenericNode<DNode<Allocator>> {
   sonic_force_inline void setMap(map_type* new_map) {
     sonic_assert(this->IsObject());
     sonic_assert(this->o.next.children != nullptr);
-    ((MetaNode*)(this->o.next.children))->map = new_map;
+    if (AutoMap* am = autoMap()) {
+      am->map = new_map;
+    } else {
+      meta()->map = reinterpret_cast<uintptr_t>(new_map);
+    }
   }
 
   sonic_force_inline map_type* getMap() const {
     sonic_assert(this->IsObject());
     if (nullptr == children()) return nullptr;
-    return ((MetaNode*)(this->o.next.children))->map;
+    return getMapUnsafe();
   }
 
   sonic_force_inline map_type* getMapUnsafe() const {
     sonic_assert(this->IsObject());
-    return ((MetaNode*)(this->o.next.children))->map;
+    uintptr_t map = meta()->map;
+    if (sonic_unlikely(map & kAutoMapTag)) {
+      return reinterpret_cast<AutoMap*>(map ^ kAutoMapTag)->map;
+    }
+    return reinterpret_cast<map_type*>(map);
+  }
+
+  sonic_force_inline AutoMap* autoMap() const {
+    uintptr_t map = meta()->map;
+    if (map & kAutoMapTag) return reinterpret_cast<AutoMap*>(map ^ kAutoMapTag);
+    return nullptr;
+  }
+
+  // free the map and keep the AutoMap
+  void releaseMap() {
+    map_type* map = getMapUnsafe();
+    if (map) {
+      Allocator::Free(map);
+      setMap(nullptr);
+    }
+  }
+
+  // Count a lookup without map, and create the map if the object is looked up
+  // frequently.
+  sonic_never_inline bool autoCreateMap(AutoMap* am) const {
+    if (++am->lookups < am->min_lookups || this->Size() < am->min_members) {
+      return false;
+    }
+    am->lookups = 0;
+    am->changes = 0;
+    am->map = buildMap(this->Size(), *am->alloc);
+    return am->map != nullptr;
+  }
+
+  // Count a change of the object, and destroy the map if the object is
+  // changed frequently.
+  sonic_force_inline void autoCountChange() {
+    AutoMap* am = autoMap();
+    if (am == nullptr || am->map == nullptr) return;
+    if (++am->changes > this->Size()) {
+      releaseMap();
+      am->lookups = 0;
+    }
+  }
+
+  // index the first n members
+  map_type* buildMap(size_t n, Allocator& alloc) const {
+    MemberNode* m = (MemberNode*)getObjChildrenFirstUnsafe();
+    return map_type::Build(
+        n, [m](size_t i) { return m[i].name.GetStringView(); }, alloc);
+  }
+
+  sonic_force_inline uint32_t* findMapSlot(StringView key) const {
+    MemberNode* m = (MemberNode*)getObjChildrenFirstUnsafe();
+    return getMapUnsafe()->Find(
+        key, [m](uint32_t i) { return m[i].name.GetStringView(); });
   }
 
   sonic_force_inline MemberIterator findFromMap(StringView key) const {
-    auto it = getMap()->find(MSType(key.data(), key.size()));
-    if (it != getMap()->end()) {
-      return memberBeginUnsafe() + it->second;
+    uint32_t* slot = findMapSlot(key);
+    if (slot != nullptr) {
+      return memberBeginUnsafe() + *slot;
     }
     return memberEndUnsafe();
   }
@@ -775,37 +1220,33 @@ class DNode : public GenericNode<DNode<Allocator>> {
     if (nullptr != getMap()) {
       return findFromMap(key);
     }
-    auto it = this->MemberBegin();
-    for (auto e = this->MemberEnd(); it != e; ++it) {
-      if (it->name.GetStringView() == key) {
-        break;
+    if (nullptr == children()) {
+      return const_cast<MemberIterator>(this->MemberEnd());
+    }
+    if (AutoMap* am = autoMap()) {
+      if (autoCreateMap(am)) return findFromMap(key);
+    }
+    const MemberNode* m = memberBeginUnsafe();
+    const size_t n = this->Size();
+    const char* k = key.data();
+    const size_t len = key.size();
+    // The length is compared with the packed type and length word of the
+    // name, and the bytes are compared only for the same length. The
+    // interned keys are compared by pointer.
+    const uint64_t want = uint64_t(len) << kInfoBits;
+    for (size_t i = 0; i < n; ++i) {
+      const DNode& name = m[i].name;
+      if (((name.getTypeAndLen() ^ want) >> kInfoBits) == 0 &&
+          internal::KeyEqual(name.sv.p, k, len)) {
+        return const_cast<MemberIterator>(m + i);
       }
     }
-    return const_cast<MemberIterator>(it);
+    return const_cast<MemberIterator>(m + n);
   }
 
   sonic_force_inline MemberIterator findMemberImpl(const char* key,
                                                    size_t len) const {
-    /**************************************************
-     * Only calling internal memcmp when static dispatch.
-     * Dynamic dispatch will have indirect call.
-     **************************************************/
-#if defined(SONIC_STATIC_DISPATCH)
-    if (nullptr != getMap()) {
-      return findFromMap(StringView(key, len));
-    }
-    auto it = this->MemberBegin();
-    for (auto e = this->MemberEnd(); it != e; ++it) {
-      auto name_sv = it->name.GetStringView();
-      if (name_sv.size() == len &&
-          internal::InlinedMemcmpEq(name_sv.data(), key, len)) {
-        break;
-      }
-    }
-    return const_cast<MemberIterator>(it);
-#else
     return findMemberImpl(StringView(key, len));
-#endif
   }
 
   sonic_force_inline DNode& findValueImpl(StringView key) const noexcept {
@@ -818,10 +1259,28 @@ class DNode : public GenericNode<DNode<Allocator>> {
     return tmp;
   }
 
-  DNode& findValueImpl(size_t idx) const noexcept {
+  // A null node is returned if the packed array can't be unpacked.
+  DNode& findValueImpl(size_t idx) noexcept {
+    if (sonic_unlikely(!unpackArray())) return nullNode();
     return *(getArrChildrenFirst() + idx);
   }
 
+  // A null node is returned if the nodes of the packed array can't be made.
+  const DNode& findValueImpl(size_t idx) const noexcept {
+    if (sonic_unlikely(this->isPackedArray())) {
+      const DNode* nodes = packedNodes();
+      if (sonic_unlikely(nodes == nullptr)) return nullNode();
+      return nodes[idx];
+    }
+    return *(getArrChildrenFirst() + idx);
+  }
+
+  static DNode& nullNode() noexcept {
+    static DNode tmp{};
+    tmp.SetNull();
+    return tmp;
+  }
+
   MemberIterator addMemberImpl(StringView key, DNode& value, Allocator& alloc,
                                bool copyKey) {
     constexpr size_t k_default_obj_cap = 16;
@@ -856,10 +1315,14 @@ class DNode : public GenericNode<DNode<Allocator>> {
     this->addLength(1);
 
     // maintain map
-    if (nullptr != getMap()) {
-      // If key exists, it will be still keeped in vector but replaced in map.
-      getMap()->emplace(std::make_pair(last->GetStringView(), count));
+    map_type* map = getMap();
+    if (nullptr != map && !map->Add(last->GetStringView(), count)) {
+      // The map is full, rebuild a larger one. If there is no memory, the
+      // members are found by linear search instead.
+      Allocator::Free(map);
+      setMap(buildMap(count + 1, alloc));
     }
+    autoCountChange();
     return (MemberIterator)last;
   }
 
@@ -869,10 +1332,10 @@ class DNode : public GenericNode<DNode<Allocator>> {
       goto not_find;
     }
     if (getMapUnsafe()) {
-      auto it = getMapUnsafe()->find(MSType(key.data(), key.size()));
-      if (it != getMapUnsafe()->end()) {
-        m = memberBeginUnsafe() + it->second;
-        getMapUnsafe()->erase(it);
+      uint32_t* slot = findMapSlot(key);
+      if (slot != nullptr) {
+        m = memberBeginUnsafe() + *slot;
+        getMapUnsafe()->Erase(slot);
         goto find;
       }
 
@@ -895,17 +1358,11 @@ class DNode : public GenericNode<DNode<Allocator>> {
       // maintain map
       map_type* map = getMap();
       if (map) {
-        size_t pos = m - memberBeginUnsafe();
-        // erase tail
-        auto range =
-            map->equal_range(m->name.GetStringView());  // already moved.
-        for (auto i = range.first; i != range.second; ++i) {
-          if (i->second == this->Size() - 1) {
-            map->erase(i);
-            break;  // only one erase.
-          }
-        }
-        map->emplace(std::make_pair(m->name.GetStringView(), pos));
+        // the tail is moved to pos
+        uint32_t* slot = map->FindPos(m->name.GetStringView(),
+                                      uint32_t(this->Size() - 1));
+        sonic_assert(slot != nullptr);
+        *slot = uint32_t(m - memberBeginUnsafe());
       }
     } else {
       m->name.~DNode();
@@ -913,6 +1370,7 @@ class DNode : public GenericNode<DNode<Allocator>> {
     }
 
     this->subLength(1);
+    autoCountChange();
     return true;
   }
   not_find:
@@ -921,7 +1379,7 @@ class DNode : public GenericNode<DNode<Allocator>> {
 
   MemberIterator eraseMemberImpl(MemberIterator first, MemberIterator last) {
     // Destroy map before removing members.
-    DestroyMap();
+    if (nullptr != children()) releaseMap();
     size_t size = this->Size();
     MemberIterator end = this->MemberEnd();
     if (size_t(last - first) >= size) {
@@ -945,6 +1403,7 @@ class DNode : public GenericNode<DNode<Allocator>> {
   DNode& pushBackImpl(DNode& value, Allocator& alloc) {
     constexpr size_t k_default_array_cap = 16;
     sonic_assert(this->IsArray());
+    if (sonic_unlikely(!unpackArray())) return *this;
     // reserve capacity
     size_t cap = this->Capacity();
     if (this->Size() >= cap) {
@@ -1017,8 +1476,14 @@ class DNode : public GenericNode<DNode<Allocator>> {
         break;
       }
       case kArray: {
-        for (auto it = this->Begin(), e = this->End(); it != e; ++it) {
-          it->destroy();
+        if (!this->isPackedArray()) {
+          for (auto it = this->Begin(), e = this->End(); it != e; ++it) {
+            it->destroy();
+          }
+        } else {
+          // the nodes of the numbers own nothing
+          Allocator::Free(packedNodesSlot(children(), this->Size())
+                              ->load(std::memory_order_relaxed));
         }
         Allocator::Free(children());
         break;
@@ -1038,7 +1503,7 @@ class DNode : public GenericNode<DNode<Allocator>> {
 
   DNode& clearImpl() {
     this->destroy();
-    this->setLength(0);
+    this->setLength(0, this->GetType());
     setChildren(nullptr);
     return *this;
   }
@@ -29,6 +29,34 @@ enum class ParseFlags : uint32_t {
   // native numeric representation. In-range floating-point numbers stay
   // double; in-range integers stay int64/uint64.
   kParseOverflowNumAsNumStr = 1 << 3,
+  // Parse directly from the caller's buffer instead of an internal copy.
+  // The buffer must stay alive and unchanged while the document is used, and
+  // must be followed by SONICJSON_PADDING readable bytes (zero-filled padding
+  // is enough). The input is never written: strings without escapes point
+  // into it, escaped strings are unescaped into the document allocator.
+  kParseBorrowInput = 1 << 4,
+  // Intern the object keys while parsing, so that the repeated keys point to
+  // their first occurrence, and the equal keys are the same pointer. It
+  // doesn't shrink the parsed buffer, only the repeated unescaped copies of a
+  // borrowed input are freed, if the allocator frees memory.
+  kParseInternKeys = 1 << 6,
+  // Create the member maps of the large objects while parsing, when their
+  // members are still in cache. The threshold is set by
+  // GenericDocument::SetCreateMapMembers.
+  kParseCreateMap = 1 << 7,
+  // Keep the text of the floating-point numbers, and decode it by GetDouble.
+  // The numbers are still double typed, and are serialized as their text.
+  // The text is in the parsed buffer, so the nodes can't outlive it.
+  kParseLazyNumbers = 1 << 8,
+  // Keep the string values with escaped chars as they are in the input, and
+  // unescape them in the parsed buffer once, when first accessed. They are
+  // serialized as their text until then. The nodes are not written, so the
+  // document can be read from many threads.
+  kParseLazyStrings = 1 << 9,
+  // Pack the arrays of only doubles, or only integers in int64, into plain
+  // values, see GetDoubleSpan. They are unpacked into nodes when accessed by a
+  // non-const node. The const accessors make the nodes once beside the values.
+  kParsePackNumberArrays = 1 << 10,
 };
 
 // Compatibility layer for downstream users.
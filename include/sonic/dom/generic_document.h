@@ -17,12 +17,18 @@
 #pragma once
 
 #include <algorithm>
+#include <cstring>
+#include <memory>
+#include <thread>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
 #include "sonic/dom/dynamicnode.h"
 #include "sonic/dom/json_pointer.h"
 #include "sonic/dom/parser.h"
+#include "sonic/internal/key_interner.h"
+#include "sonic/internal/mapped_file.h"
 
 namespace sonic_json {
 
@@ -32,10 +38,23 @@ struct has_clear : std::false_type {};
 template <typename A>
 struct has_clear<A, std::void_t<decltype(std::declval<A&>().Clear())>>
     : std::true_type {};
+template <typename A, typename = void>
+struct has_rewind : std::false_type {};
+template <typename A>
+struct has_rewind<A, std::void_t<decltype(std::declval<A&>().Rewind())>>
+    : std::true_type {};
+template <typename A, typename = void>
+struct has_capacity : std::false_type {};
+template <typename A>
+struct has_capacity<
+    A, std::void_t<decltype(std::declval<const A&>().Capacity())>>
+    : std::true_type {};
 }  // namespace internal
 
 template <ParseFlags parseFlags>
 class Parser;
+template <typename NodeType, ParseFlags parseFlags>
+class GenericDocumentStream;
 template <typename NodeType>
 class GenericDocument : public NodeType {
  public:
@@ -53,6 +72,7 @@ class GenericDocument : public NodeType {
       own_alloc_ = std::unique_ptr<Allocator>(new Allocator());
       alloc_ = own_alloc_.get();
     }
+    sax_ = SAXHandler<NodeType>(*alloc_);
   }
 
   GenericDocument(const GenericDocument& rhs) = delete;
@@ -67,7 +87,12 @@ class GenericDocument : public NodeType {
         str_(rhs.str_),
         schema_str_(rhs.schema_str_),
         str_cap_(rhs.str_cap_),
-        strp_(rhs.strp_) {
+        strp_(rhs.strp_),
+        slices_(std::move(rhs.slices_)),
+        sax_(std::move(rhs.sax_)),
+        file_(std::move(rhs.file_)),
+        interner_(std::move(rhs.interner_)),
+        map_members_(rhs.map_members_) {
     rhs.clear();
   }
 
@@ -92,6 +117,11 @@ class GenericDocument : public NodeType {
     schema_str_ = rhs.schema_str_;
     str_cap_ = rhs.str_cap_;
     strp_ = rhs.strp_;
+    slices_ = std::move(rhs.slices_);
+    sax_ = std::move(rhs.sax_);
+    file_ = std::move(rhs.file_);
+    interner_ = std::move(rhs.interner_);
+    map_members_ = rhs.map_members_;
 
     // Step3: clear rhs memory
     rhs.clear();
@@ -110,6 +140,11 @@ class GenericDocument : public NodeType {
     std::swap(schema_str_, rhs.schema_str_);
     std::swap(str_cap_, rhs.str_cap_);
     std::swap(strp_, rhs.strp_);
+    slices_.swap(rhs.slices_);
+    std::swap(sax_, rhs.sax_);
+    std::swap(file_, rhs.file_);
+    interner_.swap(rhs.interner_);
+    std::swap(map_members_, rhs.map_members_);
     return *this;
   }
 
@@ -137,12 +172,128 @@ class GenericDocument : public NodeType {
     return Parse<parseFlags>(json.data(), json.size());
   }
 
+  /**
+   * @brief Parse by json string pointer and length
+   * @param parseFlags combination of different ParseFlag.
+   * @param data json string pointer
+   * @param len json string size
+   * @note With ParseFlags::kParseBorrowInput, the document references `data`
+   * instead of copying it. `data` must be followed by SONICJSON_PADDING
+   * readable bytes, and must outlive the document (or the next Parse).
+   */
   template <ParseFlags parseFlags = ParseFlags::kParseDefault>
   GenericDocument& Parse(const char* data, size_t len) {
     destroyDom();
     return parseImpl<parseFlags>(data, len);
   }
 
+  /**
+   * @brief Parse a json file by mapping it into memory.
+   * @param parseFlags combination of different ParseFlag.
+   * @param file the file path
+   * @note The file is parsed as borrowed input and is never copied, the
+   * mapping is kept by the document until the next parsing. The file must
+   * not be changed while the document is used. The error is kErrorOpenFile
+   * if the file can't be opened or mapped.
+   */
+  template <ParseFlags parseFlags = ParseFlags::kParseDefault>
+  GenericDocument& ParseFile(const char* file) {
+    destroyDom();
+    parse_result_ = file_.Open(file);
+    if (sonic_unlikely(HasParseError())) {
+      return *this;
+    }
+    return parseImpl<parseFlags | ParseFlags::kParseBorrowInput>(
+        file_.Data(), file_.Size());
+  }
+
+  /**
+   * @brief Parse the target of json pointer in a json file, the file is
+   * mapped into memory as ParseFile.
+   * @param file the file path
+   * @param path the query path of the json keys
+   */
+  template <ParseFlags parseFlags = ParseFlags::kParseDefault,
+            typename JPStringType = SONIC_JSON_POINTER_NODE_STRING_DEFAULT_TYPE>
+  GenericDocument& ParseFileOnDemand(
+      const char* file, const GenericJsonPointer<JPStringType>& path) {
+    destroyDom();
+    parse_result_ = file_.Open(file);
+    if (sonic_unlikely(HasParseError())) {
+      return *this;
+    }
+    return parseOnDemandImpl<parseFlags | ParseFlags::kParseBorrowInput,
+                             JPStringType>(file_.Data(), file_.Size(), path);
+  }
+
+  /**
+   * @brief Clear the document and keep its memory for the next ReParse. The
+   * owned memory pool is rewound, instead of releasing its chunks.
+   * @note All nodes from the document are invalid after Reset, including the
+   * nodes moved out of it.
+   */
+  void Reset() { rewindDom(); }
+
+  /**
+   * @brief Get the bytes kept by the document for the next ReParse: the
+   * owned memory pool, the string buffer and the node stack of the parser.
+   */
+  size_t ReuseCapacity() const {
+    size_t bytes = sax_.Capacity();
+    if constexpr (Allocator::kNeedFree) {
+      bytes += str_cap_;
+    } else if constexpr (internal::has_capacity<Allocator>::value) {
+      if (own_alloc_) bytes += own_alloc_->Capacity();
+    }
+    return bytes;
+  }
+
+  /**
+   * @brief Parse by std::string, reusing the memory of the last parsing.
+   * @note It is the same as Parse, except that the memory pool chunks, the
+   * string buffer and the node stack are kept by the document. A steady
+   * workload does not allocate from heap after warm-up when using the owned
+   * memory pool allocator. All nodes from the last parsing are invalid.
+   */
+  template <ParseFlags parseFlags = ParseFlags::kParseDefault>
+  GenericDocument& ReParse(StringView json) {
+    return ReParse<parseFlags>(json.data(), json.size());
+  }
+
+  template <ParseFlags parseFlags = ParseFlags::kParseDefault>
+  GenericDocument& ReParse(const char* data, size_t len) {
+    rewindDom();
+    sax_.Rewind();
+    return parseImpl<parseFlags>(data, len, sax_, true);
+  }
+
+  /**
+   * @brief Parse a large json array by several threads. The array is split
+   * at its top-level commas, every slice is parsed by a thread into its own
+   * memory, and the elements are joined into the root array without copying
+   * their values.
+   * @param json json string, other json than an array is parsed by Parse.
+   * @param threads the number of threads, including the calling thread. 0
+   * means the number of hardware threads.
+   * @param slice_bytes the minimum bytes of a slice, so the small json is
+   * parsed by less threads.
+   * @note The result is the same as Parse. If the json is invalid, it is
+   * parsed again by Parse to report the first error.
+   */
+  template <ParseFlags parseFlags = ParseFlags::kParseDefault>
+  GenericDocument& ParseParallel(StringView json, size_t threads = 0,
+                                 size_t slice_bytes = kDefaultSliceBytes) {
+    static_assert(!(parseFlags & ParseFlags::kParseBorrowInput),
+                  "ParseParallel does not support borrowed input");
+    destroyDom();
+    if (threads == 0) threads = std::thread::hardware_concurrency();
+    threads = std::min(threads, json.size() / std::max<size_t>(slice_bytes, 1));
+    if (threads >= 2 && parseParallelImpl<parseFlags>(json, threads)) {
+      return *this;
+    }
+    return parseImpl<parseFlags>(json.data(), json.size());
+  }
+
   template <ParseFlags parseFlags = ParseFlags::kParseDefault>
   GenericDocument& ParseSchema(StringView json) {
     return ParseSchema<parseFlags>(json.data(), json.size());
@@ -195,6 +346,27 @@ class GenericDocument : public NodeType {
     return parse_result_.Offset();
   }
 
+  /**
+   * @brief Get the total length of the repeated key copies that were freed
+   * in the last parsing with kParseInternKeys. Only the unescaped keys of a
+   * borrowed input are copies, and they are freed only if the allocator frees
+   * memory, so it is 0 otherwise. The keys in the parsed buffer are never
+   * freed.
+   */
+  size_t GetInternSavedBytes() const {
+    return interner_ ? interner_->SavedBytes() : 0;
+  }
+
+  /**
+   * @brief Set the member count of the objects whose maps are created when
+   * parsing with kParseCreateMap. The default is 32.
+   * @param members the objects with at least `members` members get maps, 0 is
+   * treated as 1.
+   */
+  void SetCreateMapMembers(uint32_t members) {
+    map_members_ = members ? members : 1;
+  }
+
  private:
   sonic_force_inline void clear() {
     parse_result_ = ParseResult();
@@ -202,6 +374,7 @@ class GenericDocument : public NodeType {
     alloc_ = nullptr;
     str_ = nullptr;
     schema_str_ = nullptr;
+    str_cap_ = 0;
   }
 
   void destroyDom() {
@@ -214,31 +387,97 @@ class GenericDocument : public NodeType {
         str_ = nullptr;
         schema_str_ = nullptr;
       }
+      slices_.clear();
+      file_.Close();
       return;
     }
     // NOTE: must free dynamic nodes at first
     reinterpret_cast<DNode<Allocator>*>(this)->~DNode();
     Allocator::Free(str_);
     Allocator::Free(schema_str_);
+    slices_.clear();
+    file_.Close();
     // Avoid Double Free
     str_ = nullptr;
     schema_str_ = nullptr;
+    str_cap_ = 0;
+    this->setType(kNull);
+  }
+
+  // Clear the dom as destroyDom, but keep the memory for reuse.
+  void rewindDom() {
+    if constexpr (!Allocator::kNeedFree) {
+      this->setType(kNull);
+      slices_.clear();
+      if (own_alloc_) {
+        if constexpr (internal::has_rewind<Allocator>::value) {
+          alloc_->Rewind();
+        } else if constexpr (internal::has_clear<Allocator>::value) {
+          alloc_->Clear();
+        }
+        str_ = nullptr;
+        schema_str_ = nullptr;
+      }
+      file_.Close();
+      return;
+    }
+    // the string buffer is kept
+    reinterpret_cast<DNode<Allocator>*>(this)->~DNode();
+    Allocator::Free(schema_str_);
+    schema_str_ = nullptr;
+    slices_.clear();
+    file_.Close();
     this->setType(kNull);
   }
 
   template <ParseFlags parseFlags>
   GenericDocument& parseImpl(const char* json, size_t len) {
-    Parser<parseFlags> p;
     SAXHandler<NodeType> sax(*alloc_);
+    return parseImpl<parseFlags>(json, len, sax, false);
+  }
+
+  // The interner is kept by the document, so that its table is reused.
+  template <ParseFlags parseFlags>
+  internal::KeyInterner* keyInterner() {
+    if constexpr (parseFlags & ParseFlags::kParseInternKeys) {
+      if (!interner_) interner_.reset(new internal::KeyInterner());
+    }
+    if (interner_) interner_->Reset();
+    if constexpr (parseFlags & ParseFlags::kParseInternKeys) {
+      return interner_.get();
+    }
+    return nullptr;
+  }
+
+  template <ParseFlags parseFlags>
+  uint32_t createMapMembers() const {
+    if constexpr (parseFlags & ParseFlags::kParseCreateMap) {
+      return map_members_;
+    }
+    return 0;
+  }
+
+  template <ParseFlags parseFlags>
+  GenericDocument& parseImpl(const char* json, size_t len,
+                             SAXHandler<NodeType>& sax, bool reuse) {
+    Parser<parseFlags> p;
+    sax.interner_ = keyInterner<parseFlags>();
+    sax.map_members_ = createMapMembers<parseFlags>();
+    sax.pack_arrays_ = parseFlags & ParseFlags::kParsePackNumberArrays;
     if (!sax.SetUp(StringView(json, len))) {
       parse_result_ = kErrorNoMem;
       return *this;
     }
-    parse_result_ = allocateStringBuffer(json, len);
-    if (sonic_unlikely(HasParseError())) {
-      return *this;
+    if constexpr (parseFlags & ParseFlags::kParseBorrowInput) {
+      // the parser never writes the borrowed input
+      parse_result_ = p.Parse(const_cast<char*>(json), len, sax);
+    } else {
+      parse_result_ = allocateStringBuffer(json, len, reuse);
+      if (sonic_unlikely(HasParseError())) {
+        return *this;
+      }
+      parse_result_ = p.Parse(str_, len, sax);
     }
-    parse_result_ = p.Parse(str_, len, sax);
     if (sonic_unlikely(sax.oom_)) {
       parse_result_ = kErrorNoMem;
       return *this;
@@ -250,8 +489,125 @@ class GenericDocument : public NodeType {
     return *this;
   }
 
+  // Slice is a part of the array parsed by ParseParallel. Its nodes and
+  // strings are kept in the document after joined.
+  struct Slice {
+    std::unique_ptr<Allocator> alloc{new Allocator()};
+    char* str{nullptr};
+    NodeType root{};
+    ParseResult result{};
+
+    Slice() = default;
+    Slice(const Slice&) = delete;
+    Slice& operator=(const Slice&) = delete;
+    ~Slice() {
+      if (Allocator::kNeedFree) Allocator::Free(str);
+    }
+
+    // Parse the slice as an array, the missing brackets are added.
+    template <ParseFlags parseFlags>
+    void Parse(const char* json, size_t len, bool head, bool tail,
+               uint32_t map_members) {
+      size_t n = len + head + tail;
+      str = static_cast<char*>(alloc->Malloc(n + 64));
+      if (str == nullptr) {
+        result = kErrorNoMem;
+        return;
+      }
+      if (head) str[0] = '[';
+      std::memcpy(str + head, json, len);
+      if (tail) str[n - 1] = ']';
+      str[n] = 'x';
+      str[n + 1] = '"';
+      str[n + 2] = 'x';
+      Parser<parseFlags> p;
+      SAXHandler<NodeType> sax(*alloc);
+      sax.map_members_ = map_members;
+      sax.pack_arrays_ = parseFlags & ParseFlags::kParsePackNumberArrays;
+      if (!sax.SetUp(StringView(str, n))) {
+        result = kErrorNoMem;
+        return;
+      }
+      result = p.Parse(str, n, sax);
+      if (sonic_unlikely(sax.oom_)) {
+        result = kErrorNoMem;
+      } else if (!result.Error()) {
+        root = std::move(sax.st_[0]);
+      }
+    }
+  };
+
+  // Return false if the json should be parsed by one thread.
+  template <ParseFlags parseFlags>
+  bool parseParallelImpl(StringView json, size_t threads) {
+    const char* data = json.data();
+    size_t len = json.size();
+    size_t start = 0;
+    while (start < len && internal::IsSpace(data[start])) start++;
+    if (start == len || data[start] != '[') return false;
+
+    // find the commas as the slice boundaries
+    std::vector<size_t> splits(threads - 1);
+    size_t cnt = internal::SplitArray(
+        reinterpret_cast<const uint8_t*>(data) + start, len - start,
+        (len - start) / threads, splits.data(), splits.size());
+    if (cnt == 0) return false;
+
+    std::vector<std::unique_ptr<Slice>> slices(cnt + 1);
+    for (auto& s : slices) s.reset(new Slice());
+    uint32_t map_members = createMapMembers<parseFlags>();
+    auto parse = [&](size_t i) {
+      size_t begin = i == 0 ? 0 : start + splits[i - 1] + 1;
+      size_t end = i == cnt ? len : start + splits[i];
+      slices[i]->template Parse<parseFlags>(data + begin, end - begin, i != 0,
+                                            i != cnt, map_members);
+    };
+    std::vector<std::thread> workers;
+    workers.reserve(cnt);
+    for (size_t i = 1; i <= cnt; i++) workers.emplace_back(parse, i);
+    parse(0);
+    for (auto& w : workers) w.join();
+
+    // A slice is valid only if it has elements, otherwise the commas are
+    // misplaced. The errors are reported by the single-threaded parsing.
+    size_t total = 0;
+    for (auto& s : slices) {
+      if (s->result.Error() || s->root.Empty()) return false;
+      // the packed elements are joined as nodes
+      if (!s->root.unpackArray()) return false;
+      total += s->root.Size();
+    }
+
+    // join the elements of all slices into the root
+    void* mem = this->template containerMalloc<NodeType>(total, *alloc_);
+    if (sonic_unlikely(mem == nullptr)) {
+      parse_result_ = kErrorNoMem;
+      return true;
+    }
+    this->setLength(total, kArray);
+    this->setChildren(mem);
+    NodeType* dst = this->getArrChildrenFirstUnsafe();
+    for (auto& s : slices) {
+      NodeType& arr = s->root;
+      internal::Xmemcpy<sizeof(NodeType)>(
+          (void*)dst, (void*)arr.getArrChildrenFirstUnsafe(), arr.Size());
+      dst += arr.Size();
+      // the elements are owned by the root now
+      Allocator::Free(arr.children());
+      arr.setLength(0, kArray);
+      arr.setChildren(nullptr);
+    }
+    // the offset in the last slice starts from the added '['
+    parse_result_ = ParseResult(
+        kErrorNone, start + splits[cnt - 1] + slices[cnt]->result.Offset());
+    slices_ = std::move(slices);
+    return true;
+  }
+
   template <ParseFlags parseFlags>
   GenericDocument& parseSchemaImpl(const char* json, size_t len) {
+    static_assert(!(parseFlags & ParseFlags::kParseBorrowInput),
+                  "ParseSchema does not support borrowed input");
     Parser<parseFlags> p;
     SchemaHandler<NodeType> sax(this, *alloc_);
     if (!sax.SetUp(StringView(json, len))) {
@@ -287,10 +643,17 @@ class GenericDocument : public NodeType {
     return parseImpl<parseFlags>(target.data(), target.size());
   }
 
-  SonicError allocateStringBuffer(const char* json, size_t len) {
+  SonicError allocateStringBuffer(const char* json, size_t len,
+                                  bool reuse = false) {
     size_t pad_len = len + 64;
-    str_ = (char*)(alloc_->Malloc(pad_len));
+    // only the buffer from heap can be reused, the memory pool is rewound
+    if (!Allocator::kNeedFree || !reuse || str_cap_ < pad_len) {
+      if (Allocator::kNeedFree && reuse) Allocator::Free(str_);
+      str_ = (char*)(alloc_->Malloc(pad_len));
+      str_cap_ = pad_len;
+    }
     if (str_ == nullptr) {
+      str_cap_ = 0;
       return kErrorNoMem;
     }
     std::memcpy(str_, json, len);
@@ -316,6 +679,28 @@ class GenericDocument : public NodeType {
   }
   template <ParseFlags parseFlags>
   friend class Parser;
+  template <typename, ParseFlags>
+  friend class GenericDocumentStream;
+
+  // Note: they are callback functions in GenericDocumentStream
+  void parseStreamBegin() {
+    destroyDom();
+    parse_result_ = ParseResult();
+  }
+
+  GenericDocument& parseStreamEnd(SAXHandler<NodeType>& sax,
+                                  ParseResult result) {
+    parse_result_ = result;
+    if (sonic_unlikely(sax.oom_)) {
+      parse_result_ = kErrorNoMem;
+      return *this;
+    }
+    if (sonic_unlikely(HasParseError())) {
+      return *this;
+    }
+    NodeType::operator=(std::move(sax.st_[0]));
+    return *this;
+  }
 
   // Note: it is a callback function in parse.parse_impl
   void copyToRoot(DNode<Allocator>& node) {
@@ -323,6 +708,8 @@ class GenericDocument : public NodeType {
     NodeType::operator=(std::move(node));
   }
 
+  constexpr static size_t kDefaultSliceBytes = 1 << 20;
+
   std::unique_ptr<Allocator> own_alloc_{nullptr};
   Allocator* alloc_{nullptr};  // maybe external allocator
   ParseResult parse_result_{};
@@ -337,6 +724,21 @@ class GenericDocument : public NodeType {
   char* schema_str_{nullptr};
   size_t str_cap_{0};
   long strp_{0};
+
+  // the memory of slices by ParseParallel
+  std::vector<std::unique_ptr<Slice>> slices_{};
+
+  // the node stack kept by ReParse
+  SAXHandler<NodeType> sax_{};
+
+  // the file mapped by ParseFile
+  internal::MappedFile file_{};
+
+  // the key table of kParseInternKeys
+  std::unique_ptr<internal::KeyInterner> interner_{};
+
+  // the threshold of kParseCreateMap
+  uint32_t map_members_{32};
 };
 
 using Document = GenericDocument<DNode<SONIC_DEFAULT_ALLOCATOR>>;
@@ -17,17 +17,21 @@
 #pragma once
 
 #include <cstddef>
+#include <cstring>
 #include <limits>
 #include <memory>
+#include <thread>
 #include <vector>
 
 #include "sonic/dom/handler.h"
 #include "sonic/dom/json_pointer.h"
+#include "sonic/dom/parser.h"
 #include "sonic/dom/schema_handler.h"
 #include "sonic/dom/serialize.h"
 #include "sonic/dom/type.h"
 #include "sonic/error.h"
 #include "sonic/jsonpath/jsonpath.h"
+#include "sonic/span.h"
 #include "sonic/string_view.h"
 #include "sonic/writebuffer.h"
 
@@ -334,16 +338,20 @@ class GenericNode {
    */
   sonic_force_inline std::string GetString() const {
     sonic_assert(IsString() || IsStringNumber());
-    return std::string(sv.p, Size());
+    StringView s = GetStringView();
+    return std::string(s.data(), s.size());
   }
 
   /**
    * @brief  Get the string view of this node, won't copy the string.
    * @return StringView
+   * @note The string kept by kParseLazyStrings is unescaped in place on the
+   * first access, see escapedStringView.
    */
   sonic_force_inline StringView GetStringView() const noexcept {
     sonic_assert(IsString() || IsStringNumber() || IsRaw());
-    return StringView(sv.p, Size());
+    if (sonic_unlikely(isEscapedString())) return escapedStringView();
+    return StringView(sv.p, sv.len >> kInfoBits);
   }
 
   sonic_force_inline StringView GetStringNumber() const noexcept {
@@ -390,7 +398,13 @@ class GenericNode {
    */
   sonic_force_inline double GetDouble() const noexcept {
     sonic_assert(IsNumber() && !IsStringNumber());
-    if (IsDouble()) return n.f64;
+    if (IsDouble()) {
+      if (sonic_unlikely(isLazyNumber())) {
+        StringView text = getLazyNumber();
+        return internal::DecodeLazyDouble(text.data(), text.size());
+      }
+      return n.f64;
+    }
     if (IsUint64())
       return static_cast<double>(
           n.u64);  // uint64_t -> double (may lose precision))
@@ -579,6 +593,7 @@ class GenericNode {
   size_t Size() const noexcept {
     sonic_assert(this->IsContainer() || this->IsString() || this->IsRaw() ||
                  this->IsStringNumber());
+    if (sonic_unlikely(isEscapedString())) return escapedStringView().size();
     return sv.len >> kInfoBits;
   }
 
@@ -736,6 +751,18 @@ class GenericNode {
     return AtJsonPathCommon(downCast(), jsonpath);
   }
 
+  /**
+   * @brief get specific nodes by a compiled json path, the path is not parsed
+   * again.
+   */
+  JsonPathResult<NodeType> AtJsonPath(const JsonPathPlan& plan) {
+    return AtJsonPathCommon(downCast(), plan);
+  }
+
+  JsonPathResult<const NodeType> AtJsonPath(const JsonPathPlan& plan) const {
+    return AtJsonPathCommon(downCast(), plan);
+  }
+
  private:
   template <typename DerivedPtr>
   static sonic_force_inline JsonPathResult<std::remove_pointer_t<DerivedPtr>>
@@ -754,14 +781,33 @@ class GenericNode {
       ret.error = kUnsupportedJsonPath;
       return ret;
     }
+    atJsonPathNodes(self, path, ret);
+    return ret;
+  }
 
+  template <typename DerivedPtr>
+  static sonic_force_inline JsonPathResult<std::remove_pointer_t<DerivedPtr>>
+  AtJsonPathCommon(DerivedPtr self, const JsonPathPlan& plan) {
+    JsonPathResult<std::remove_pointer_t<DerivedPtr>> ret = {};
+    ret.error = kErrorNone;
+    if (!plan.IsValid()) {
+      ret.error = kUnsupportedJsonPath;
+      return ret;
+    }
+    atJsonPathNodes(self, plan.GetNodes(), ret);
+    return ret;
+  }
+
+  template <typename DerivedPtr, typename Result>
+  static sonic_force_inline void atJsonPathNodes(DerivedPtr self,
+                                                 const internal::JsonPath& path,
+                                                 Result& ret) {
     if (path[0].is_root() && path.size() == 1) {
       ret.nodes.push_back(self);
     } else if (!self->atJsonPathImpl(path, 1, ret.nodes)) {
       ret.error = kNotFoundByJsonPath;
       ret.nodes.clear();
     }
-    return ret;
   }
 
  public:
@@ -985,6 +1031,8 @@ class GenericNode {
    * @brief Get specific child node in an array by index
    * @param idx index
    * @return NodeType&
+   * @note For an array packed by kParsePackNumberArrays, the nodes are made
+   * from the values once and kept with the array, which stays packed.
    */
   const NodeType& operator[](size_t idx) const noexcept {
     sonic_assert(this->IsArray());
@@ -992,6 +1040,34 @@ class GenericNode {
     return downCast()->findValueImpl(idx);
   }
 
+  /**
+   * @brief Get the doubles of an array packed by kParsePackNumberArrays.
+   * @return the values, or an empty span if the array is not packed doubles.
+   * @note The span is invalidated when the array is accessed by non-const
+   * nodes, e.g. Begin() or operator[], which unpack the array.
+   */
+  Span<const double> GetDoubleSpan() const noexcept {
+    sonic_assert(this->IsArray());
+    if (isPackedArray() && !(t.t & kPackedIntMask)) {
+      return downCast()->template packedSpanImpl<double>();
+    }
+    return Span<const double>();
+  }
+
+  /**
+   * @brief Get the integers of an array packed by kParsePackNumberArrays.
+   * @return the values, or an empty span if the array is not packed integers.
+   * @note The span is invalidated when the array is accessed by non-const
+   * nodes, e.g. Begin() or operator[], which unpack the array.
+   */
+  Span<const int64_t> GetInt64Span() const noexcept {
+    sonic_assert(this->IsArray());
+    if (isPackedArray() && (t.t & kPackedIntMask)) {
+      return downCast()->template packedSpanImpl<int64_t>();
+    }
+    return Span<const int64_t>();
+  }
+
   /**
    * @brief Reserve array capacity if NodeType support. Otherwise do nothing.
    * @param new_cap Expected capacity of an array.
@@ -1105,6 +1181,71 @@ class GenericNode {
   sonic_force_inline TypeFlag getBasicType() const noexcept {
     return static_cast<TypeFlag>(t.t & kBasicTypeMask);
   }
+  sonic_force_inline bool isLazyNumber() const noexcept {
+    return (t.t & kLazyNumberMask) != 0;
+  }
+  sonic_force_inline StringView getLazyNumber() const noexcept {
+    return StringView(sv.p, sv.len >> kInfoBits);
+  }
+  sonic_force_inline bool isPackedArray() const noexcept {
+    return (t.t & (kBasicTypeMask | kPackedArrayMask)) ==
+           (kArray | kPackedArrayMask);
+  }
+  sonic_force_inline bool isEscapedString() const noexcept {
+    return (t.t & kEscapedStringMask) != 0;
+  }
+  sonic_force_inline StringView getEscapedString() const noexcept {
+    return StringView(sv.p, sv.len >> kInfoBits);
+  }
+  // The string kept by kParseLazyStrings is unescaped in the parsed buffer
+  // once, by the first access from any thread. The node is not written. The
+  // opening quote before the text keeps the state of the text.
+  enum : char {
+    kEscapedPending = '"',
+    kEscapedBusy = 1,  // being unescaped or read as escaped by a thread
+    kEscapedDone = 2,
+  };
+  char* escapedState() const noexcept { return const_cast<char*>(sv.p) - 1; }
+  // Lock the escaped text. Returns false if it is unescaped already.
+  bool lockEscapedString() const noexcept {
+    char* state = escapedState();
+    for (;;) {
+      char expect = kEscapedPending;
+      if (__atomic_compare_exchange_n(state, &expect, kEscapedBusy, false,
+                                      __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE)) {
+        return true;
+      }
+      if (expect == kEscapedDone) return false;
+      std::this_thread::yield();
+    }
+  }
+  void unlockEscapedString(char state) const noexcept {
+    __atomic_store_n(escapedState(), state, __ATOMIC_RELEASE);
+  }
+  // The unescaped string is shorter than the escaped text. The shortening is
+  // kept backwards from the closing quote in 7 bits per byte, which takes no
+  // more bytes than it saves plus the quote.
+  sonic_never_inline StringView escapedStringView() const noexcept {
+    StringView text = getEscapedString();
+    char* p = const_cast<char*>(text.data());
+    uint8_t* q = reinterpret_cast<uint8_t*>(p) + text.size();
+    if (__atomic_load_n(escapedState(), __ATOMIC_ACQUIRE) != kEscapedDone &&
+        lockEscapedString()) {
+      size_t len = internal::DecodeLazyString(p);
+      size_t gap = text.size() - len;
+      for (; gap >= 0x80; gap >>= 7) *q-- = 0x80 | (gap & 0x7f);
+      *q = static_cast<uint8_t>(gap);
+      unlockEscapedString(kEscapedDone);
+      return StringView(p, len);
+    }
+    size_t gap = 0;
+    for (int shift = 0;; shift += 7) {
+      uint8_t b = *q--;
+      gap |= static_cast<size_t>(b & 0x7f) << shift;
+      if (!(b & 0x80)) break;
+    }
+    return StringView(p, text.size() - gap);
+  }
   sonic_force_inline void setLength(size_t len) noexcept {
     sv.len = (len << kInfoBits) | static_cast<uint64_t>(t.t);
   }
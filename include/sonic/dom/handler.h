@@ -17,9 +17,11 @@
 #pragma once
 
 #include <string>
+#include <vector>
 
 #include "sonic/dom/type.h"
 #include "sonic/internal/arch/simd_base.h"
+#include "sonic/internal/key_interner.h"
 #include "sonic/string_view.h"
 #include "sonic/writebuffer.h"
 
@@ -35,6 +37,15 @@ class SAXHandler {
   using MemberType = typename NodeType::MemberNode;
 
   bool oom_{false};
+  // set by the document when parsing with kParseInternKeys
+  internal::KeyInterner *interner_{nullptr};
+  // the objects with at least map_members_ members get their member maps,
+  // 0 means no maps are created.
+  uint32_t map_members_{0};
+  // set when parsing with kParsePackNumberArrays
+  bool pack_arrays_{false};
+  // the depth stack of the parser, kept for the next parsing
+  std::vector<uint32_t> depth_{};
 
   SAXHandler() = default;
   SAXHandler(Allocator &alloc) : alloc_(&alloc) {}
@@ -43,11 +54,16 @@ class SAXHandler {
   SAXHandler &operator=(const SAXHandler &rhs) = delete;
   SAXHandler(SAXHandler &&rhs)
       : oom_(rhs.oom_),
+        interner_(rhs.interner_),
+        map_members_(rhs.map_members_),
+        pack_arrays_(rhs.pack_arrays_),
+        depth_(std::move(rhs.depth_)),
         st_(rhs.st_),
         np_(rhs.np_),
         cap_(rhs.cap_),
         parent_(rhs.parent_),
         alloc_(rhs.alloc_) {
+    rhs.interner_ = nullptr;
     rhs.st_ = nullptr;
     rhs.cap_ = 0;
     rhs.np_ = 0;
@@ -63,7 +79,12 @@ class SAXHandler {
     parent_ = rhs.parent_;
     alloc_ = rhs.alloc_;
     oom_ = rhs.oom_;
+    interner_ = rhs.interner_;
+    map_members_ = rhs.map_members_;
+    pack_arrays_ = rhs.pack_arrays_;
+    depth_ = std::move(rhs.depth_);
 
+    rhs.interner_ = nullptr;
     rhs.st_ = nullptr;
     rhs.np_ = 0;
     rhs.cap_ = 0;
@@ -89,6 +110,19 @@ class SAXHandler {
     return true;
   }
 
+  // Destroy the nodes and keep the stack memory for the next parsing.
+  sonic_force_inline void Rewind() {
+    for (size_t i = 0; i < np_; i++) {
+      st_[i].~NodeType();
+    }
+    np_ = 0;
+    parent_ = 0;
+    oom_ = false;
+  }
+
+  // The bytes of the node stack.
+  size_t Capacity() const { return st_ ? cap_ * sizeof(NodeType) : 0; }
+
   sonic_force_inline void TearDown() {
     if (st_ == nullptr) return;
     for (size_t i = 0; i < np_; i++) {
@@ -133,10 +167,40 @@ class SAXHandler {
     return true;
   }
 
-  sonic_force_inline bool Key(StringView s) { return stringImpl(s); }
+  sonic_force_inline bool Key(StringView s) {
+    if (interner_ != nullptr) {
+      const char *p = interner_->Intern(s);
+      if (p != nullptr) s = StringView(p, s.size());
+    }
+    return stringImpl(s);
+  }
 
   sonic_force_inline bool String(StringView s) { return stringImpl(s); }
 
+  // Used when parsing borrowed input, the allocated strings are owned by
+  // nodes.
+  sonic_force_inline bool Key(StringView s, bool allocated) {
+    if (interner_ != nullptr) {
+      // the owned copies are freed with their nodes, so they can't be the
+      // canonical ones if the allocator frees memory.
+      const char *p =
+          interner_->Intern(s, !(allocated && Allocator::kNeedFree));
+      if (p != nullptr) {
+        if (!stringImpl(StringView(p, s.size()))) return false;
+        if (allocated) {
+          Allocator::Free((void *)(s.data()));
+          if (Allocator::kNeedFree) interner_->AddSavedBytes(s.size());
+        }
+        return true;
+      }
+    }
+    return stringImpl(s, allocated ? kStringFree : kStringCopy);
+  }
+
+  sonic_force_inline bool String(StringView s, bool allocated) {
+    return stringImpl(s, allocated ? kStringFree : kStringCopy);
+  }
+
   sonic_force_inline bool NumStr(StringView s) {
     SONIC_ADD_NODE();
     new (&st_[np_ - 1]) NodeType();
@@ -145,6 +209,22 @@ class SAXHandler {
     return true;
   }
 
+  // The escaped text of a string by kParseLazyStrings.
+  sonic_force_inline bool LazyString(StringView s) {
+    return stringImpl(s,
+                      static_cast<TypeFlag>(kStringCopy | kEscapedStringMask));
+  }
+
+  // The text of a real number by kParseLazyNumbers.
+  sonic_force_inline bool LazyDouble(StringView s) {
+    SONIC_ADD_NODE();
+    new (&st_[np_ - 1]) NodeType();
+    st_[np_ - 1].setLength(s.size(),
+                           static_cast<TypeFlag>(kReal | kLazyNumberMask));
+    st_[np_ - 1].sv.p = s.data();
+    return true;
+  }
+
   sonic_force_inline bool Raw(const char *data, size_t len) {
     SONIC_ADD_NODE();
     new (&st_[np_ - 1]) NodeType();
@@ -187,6 +267,11 @@ class SAXHandler {
         obj.setChildren(mem);
         internal::Xmemcpy<sizeof(MemberType)>(
             (void *)obj.getObjChildrenFirstUnsafe(), (void *)(&obj + 1), pairs);
+        // the map is only an index, so the object is kept without it when
+        // no memory.
+        if (sonic_unlikely(map_members_ != 0 && pairs >= map_members_)) {
+          obj.setMap(obj.buildMap(pairs, *alloc_));
+        }
       }
     } else {
       obj.setChildren(nullptr);
@@ -199,6 +284,12 @@ class SAXHandler {
   sonic_force_inline bool EndArray(uint32_t count) {
     NodeType &arr = st_[parent_];
     size_t old = arr.o.next.ofs;
+    if (sonic_unlikely(pack_arrays_) && count &&
+        arr.packNumbers(count, *alloc_)) {
+      np_ = parent_ + 1;
+      parent_ = old;
+      return true;
+    }
     arr.setLength(count, kArray);
     if (count) {
       void *mem = arr.template containerMalloc<NodeType>(count, *alloc_);
@@ -221,13 +312,16 @@ class SAXHandler {
     return true;
   }
 
+  sonic_force_inline Allocator &GetAllocator() { return *alloc_; }
+
  private:
   friend class GenericDocument<NodeType>;
 
-  sonic_force_inline bool stringImpl(StringView s) {
+  sonic_force_inline bool stringImpl(StringView s,
+                                     TypeFlag type = kStringCopy) {
     SONIC_ADD_NODE();
     new (&st_[np_ - 1]) NodeType();
-    st_[np_ - 1].setLength(s.size(), kStringCopy);
+    st_[np_ - 1].setLength(s.size(), type);
     st_[np_ - 1].sv.p = s.data();
     return true;
   }
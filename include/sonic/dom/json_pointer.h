@@ -16,6 +16,9 @@
 
 #pragma once
 
+#include <algorithm>
+#include <cstdint>
+#include <string>
 #include <type_traits>
 #include <vector>
 
@@ -163,4 +166,97 @@ using JsonPointerNode =
 using JsonPointerView = GenericJsonPointer<StringView>;
 using JsonPointerNodeView = GenericJsonPointerNode<StringView>;
 
+/**
+ * @brief JsonPointerTrie merges many json pointers into a prefix trie, so
+ * GetOnDemand can get all their targets by one scan of the json. The shared
+ * prefixes of the pointers are matched once. The trie can be built once and
+ * reused for many json.
+ */
+class JsonPointerTrie {
+ public:
+  struct Node {
+    // the object keys and their children
+    std::vector<std::string> keys;
+    std::vector<uint32_t> key_nodes;
+    // the sorted array indexes and their children
+    std::vector<int> indexes;
+    std::vector<uint32_t> index_nodes;
+    // the pointers ending at this node
+    std::vector<uint32_t> targets;
+
+    bool HasChildren() const { return !keys.empty() || !indexes.empty(); }
+  };
+
+  JsonPointerTrie() : nodes_(1) {}
+
+  template <typename StringType>
+  explicit JsonPointerTrie(
+      const std::vector<GenericJsonPointer<StringType>> &paths)
+      : nodes_(1) {
+    for (const auto &path : paths) Add(path);
+  }
+
+  /**
+   * @brief Add a json pointer.
+   * @return the index of its target.
+   */
+  template <typename StringType>
+  size_t Add(const GenericJsonPointer<StringType> &path) {
+    uint32_t id = 0;
+    for (const auto &p : path) {
+      if (p.IsStr()) {
+        id = child(id, std::string(p.Data(), p.Size()));
+      } else {
+        id = child(id, p.GetNum());
+      }
+    }
+    if (nodes_[id].targets.empty()) target_nodes_++;
+    nodes_[id].targets.push_back(static_cast<uint32_t>(size_));
+    return size_++;
+  }
+
+  // The count of the pointers.
+  size_t Size() const { return size_; }
+
+  // The count of the nodes where some pointers end.
+  size_t TargetNodes() const { return target_nodes_; }
+
+  size_t NodeCount() const { return nodes_.size(); }
+
+  // The root is the node 0.
+  const Node &GetNode(uint32_t id) const { return nodes_[id]; }
+
+ private:
+  uint32_t newNode() {
+    nodes_.emplace_back();
+    return static_cast<uint32_t>(nodes_.size() - 1);
+  }
+
+  uint32_t child(uint32_t id, std::string &&key) {
+    const auto &keys = nodes_[id].keys;
+    for (size_t i = 0; i < keys.size(); i++) {
+      if (keys[i] == key) return nodes_[id].key_nodes[i];
+    }
+    uint32_t c = newNode();
+    nodes_[id].keys.push_back(std::move(key));
+    nodes_[id].key_nodes.push_back(c);
+    return c;
+  }
+
+  uint32_t child(uint32_t id, int index) {
+    auto &indexes = nodes_[id].indexes;
+    auto it = std::lower_bound(indexes.begin(), indexes.end(), index);
+    size_t i = it - indexes.begin();
+    if (it != indexes.end() && *it == index) return nodes_[id].index_nodes[i];
+    uint32_t c = newNode();
+    nodes_[id].indexes.insert(nodes_[id].indexes.begin() + i, index);
+    nodes_[id].index_nodes.insert(nodes_[id].index_nodes.begin() + i, c);
+    return c;
+  }
+
+  std::vector<Node> nodes_;
+  size_t size_{0};
+  size_t target_nodes_{0};
+};
+
 }  // namespace sonic_json
@@ -0,0 +1,256 @@
+/*
+ * Copyright 2022 ByteDance Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "sonic/dom/flags.h"
+#include "sonic/dom/generic_document.h"
+#include "sonic/error.h"
+#include "sonic/internal/arch/simd_skip.h"
+#include "sonic/internal/utils.h"
+#include "sonic/string_view.h"
+
+namespace sonic_json {
+
+/**
+ * @brief GenericNdjsonParser parses newline-delimited JSON (JSON Lines). The
+ * records are split by a SIMD scan of the newlines outside strings, and parsed
+ * by a group of threads in batches. Every thread has its own allocator and
+ * documents, and the documents are visited in the input order. The threads
+ * are started by the first batch, and wait for the next batches until the
+ * parser is destroyed.
+ */
+template <typename NodeType>
+class GenericNdjsonParser {
+ public:
+  using Allocator = typename NodeType::AllocatorType;
+  using DocumentType = GenericDocument<NodeType>;
+
+  /**
+   * @brief Construct a NDJSON parser.
+   * @param threads the number of parsing threads, including the calling
+   * thread. 0 means the number of hardware threads.
+   * @param batch_bytes the input bytes parsed by all threads in one batch.
+   * It bounds the memory of the parsed documents.
+   */
+  explicit GenericNdjsonParser(size_t threads = 1,
+                               size_t batch_bytes = kDefaultBatchBytes)
+      : batch_bytes_(std::min(std::max<size_t>(batch_bytes, 64), kMaxWindow)) {
+    if (threads == 0) threads = std::thread::hardware_concurrency();
+    if (threads == 0) threads = 1;
+    workers_.resize(threads);
+  }
+
+  GenericNdjsonParser(const GenericNdjsonParser &) = delete;
+  GenericNdjsonParser &operator=(const GenericNdjsonParser &) = delete;
+
+  ~GenericNdjsonParser() {
+    {
+      std::lock_guard<std::mutex> lock(mu_);
+      stop_ = true;
+    }
+    start_cv_.notify_all();
+    for (auto &th : threads_) th.join();
+  }
+
+  /**
+   * @brief Parse all records and call `visit(DocumentType &)` for each of
+   * them in the input order. Blank lines are ignored.
+   * @param input the NDJSON text, must not be changed while parsing
+   * @param visit called in the calling thread. The document is only valid in
+   * the call, it is reused by the later records.
+   * @return the first error and its offset in the input. The records before
+   * the failed one have been visited.
+   */
+  template <ParseFlags parseFlags = ParseFlags::kParseDefault,
+            typename Visitor>
+  ParseResult Parse(StringView input, Visitor &&visit) {
+    static_assert(!(parseFlags & ParseFlags::kParseBorrowInput),
+                  "the records in NDJSON are not padded");
+    const uint8_t *data = reinterpret_cast<const uint8_t *>(input.data());
+    size_t len = input.size();
+    size_t base = 0;
+    while (base < len) {
+      // find the complete records in the next window
+      size_t window = std::min(len - base, batch_bytes_);
+      size_t cnt = 0;
+      while (true) {
+        if (newlines_.size() < window) newlines_.resize(window);
+        cnt = internal::IndexNewlines(data + base, window, newlines_.data());
+        if (cnt > 0 || base + window == len) break;
+        // the record is larger than the window
+        if (window == kMaxWindow) return ParseResult(kErrorNoMem, base);
+        window = std::min({len - base, window * 2, kMaxWindow});
+      }
+      records_.clear();
+      size_t start = base;
+      for (size_t i = 0; i < cnt; i++) {
+        size_t end = base + newlines_[i];
+        addRecord(data, start, end);
+        start = end + 1;
+      }
+      if (base + window == len) {
+        addRecord(data, start, len);
+        start = len;
+      }
+      base = start;
+
+      parseBatch<parseFlags>(input);
+      for (auto &w : workers_) {
+        for (size_t i = 0; i < w.parsed; i++) {
+          DocumentType &doc = w.docs[i];
+          if (sonic_unlikely(doc.HasParseError())) {
+            return ParseResult(doc.GetParseError(),
+                               records_[w.begin + i].first +
+                                   doc.GetErrorOffset());
+          }
+          visit(doc);
+        }
+      }
+    }
+    return ParseResult(kErrorNone, len);
+  }
+
+ private:
+  // the batch is split as continuous ranges, so the order is kept by visiting
+  // the workers one by one.
+  struct Worker {
+    std::unique_ptr<Allocator> alloc{new Allocator()};
+    std::vector<DocumentType> docs{};
+    size_t begin{0};
+    size_t end{0};
+    size_t parsed{0};
+
+    template <ParseFlags parseFlags>
+    void Run(StringView input,
+             const std::vector<std::pair<size_t, size_t>> &records) {
+      // the documents of the previous batch are no longer used, and they are
+      // cleared by Parse() without touching the memory.
+      if constexpr (internal::has_rewind<Allocator>::value) {
+        alloc->Rewind();
+      } else if constexpr (internal::has_clear<Allocator>::value) {
+        alloc->Clear();
+      }
+      parsed = 0;
+      for (size_t i = begin; i < end; i++) {
+        if (parsed == docs.size()) docs.emplace_back(alloc.get());
+        DocumentType &doc = docs[parsed++];
+        doc.template Parse<parseFlags>(input.data() + records[i].first,
+                                       records[i].second - records[i].first);
+        // the later records are useless after an error
+        if (sonic_unlikely(doc.HasParseError())) break;
+      }
+    }
+  };
+
+  sonic_force_inline void addRecord(const uint8_t *data, size_t start,
+                                    size_t end) {
+    // skip the blank lines
+    size_t pos = start;
+    while (pos < end && internal::IsSpace(data[pos])) pos++;
+    if (pos < end) records_.emplace_back(start, end);
+  }
+
+  template <ParseFlags parseFlags>
+  void parseBatch(StringView input) {
+    size_t n = records_.size();
+    size_t used = std::max<size_t>(std::min(workers_.size(), n), 1);
+    size_t per = (n + used - 1) / used;
+    for (size_t t = 0; t < workers_.size(); t++) {
+      Worker &w = workers_[t];
+      w.begin = std::min(t * per, n);
+      w.end = t < used ? std::min(w.begin + per, n) : w.begin;
+    }
+    if (used > 1) {
+      if (threads_.empty()) {
+        for (size_t t = 1; t < workers_.size(); t++) {
+          threads_.emplace_back([this, t]() { loop(t); });
+        }
+      }
+      {
+        std::lock_guard<std::mutex> lock(mu_);
+        run_ = &runWorker<parseFlags>;
+        input_ = input;
+        used_ = used;
+        pending_ = threads_.size();
+        batch_++;
+      }
+      start_cv_.notify_all();
+    }
+    workers_[0].template Run<parseFlags>(input, records_);
+    if (used > 1) {
+      std::unique_lock<std::mutex> lock(mu_);
+      done_cv_.wait(lock, [this]() { return pending_ == 0; });
+    }
+    for (size_t t = used; t < workers_.size(); t++) workers_[t].parsed = 0;
+  }
+
+  template <ParseFlags parseFlags>
+  static void runWorker(GenericNdjsonParser &self, size_t t) {
+    self.workers_[t].template Run<parseFlags>(self.input_, self.records_);
+  }
+
+  // The thread of workers_[t], it runs the worker once for every batch.
+  void loop(size_t t) {
+    uint64_t seen = 0;
+    std::unique_lock<std::mutex> lock(mu_);
+    while (true) {
+      start_cv_.wait(lock, [&]() { return stop_ || batch_ != seen; });
+      if (stop_) return;
+      seen = batch_;
+      if (t < used_) {
+        lock.unlock();
+        run_(*this, t);
+        lock.lock();
+      }
+      if (--pending_ == 0) done_cv_.notify_one();
+    }
+  }
+
+  constexpr static size_t kDefaultBatchBytes = 4 << 20;
+  // positions of newlines are 32 bits
+  constexpr static size_t kMaxWindow = UINT32_MAX;
+
+  size_t batch_bytes_;
+  std::vector<Worker> workers_{};
+  std::vector<uint32_t> newlines_{};
+  std::vector<std::pair<size_t, size_t>> records_{};  // [begin, end)
+
+  // the threads of workers_[1..], and the batch they are running
+  std::vector<std::thread> threads_{};
+  std::mutex mu_{};
+  std::condition_variable start_cv_{};
+  std::condition_variable done_cv_{};
+  uint64_t batch_{0};
+  size_t used_{0};
+  size_t pending_{0};
+  bool stop_{false};
+  void (*run_)(GenericNdjsonParser &, size_t){nullptr};
+  StringView input_{};
+};
+
+using NdjsonParser = GenericNdjsonParser<DNode<SONIC_DEFAULT_ALLOCATOR>>;
+
+}  // namespace sonic_json
@@ -19,6 +19,7 @@
 #include <climits>
 #include <cstring>
 #include <type_traits>
+#include <utility>
 #include <vector>
 
 #include "sonic/dom/flags.h"
@@ -54,6 +55,33 @@ ParseResult GetOnDemand(StringView json,
   return ParseResult(kErrorNone, pos);
 }
 
+// GetOnDemand get the target raw json fields of many json pointers by one
+// scan. targets[i] is the field of the i-th pointer in the trie, or empty if
+// it is not found. Only the invalid json is an error, and the offset is where
+// the scan stops.
+inline ParseResult GetOnDemand(StringView json, const JsonPointerTrie &paths,
+                               std::vector<StringView> &targets) {
+  internal::PointerTrieScanner scan;
+  size_t pos = 0;
+  targets.assign(paths.Size(), StringView());
+  long ret = scan.GetOnDemand(json, pos, paths, targets.data());
+  if (ret < 0) {
+    targets.assign(paths.Size(), StringView());
+    return ParseResult(SonicError(-ret), pos);
+  }
+  return ParseResult(kErrorNone, pos);
+}
+
+template <typename JPStringType = SONIC_JSON_POINTER_NODE_STRING_DEFAULT_TYPE>
+ParseResult GetOnDemand(
+    StringView json, const std::vector<GenericJsonPointer<JPStringType>> &paths,
+    std::vector<StringView> &targets) {
+  return GetOnDemand(json, JsonPointerTrie(paths), targets);
+}
+
+template <ParseFlags parseFlags>
+class StreamParser;
+
 template <ParseFlags parseFlags = ParseFlags::kParseDefault>
 class Parser {
  public:
@@ -70,7 +98,20 @@ class Parser {
     reset();
     json_buf_ = reinterpret_cast<uint8_t *>(data);
     len_ = len;
-    parseImpl(sax);
+    if constexpr (kBorrowInput) {
+      size_t start = 0;
+      if (sonic_unlikely(isRootNumberAtEnd(start))) {
+        parseBorrowedNumber(sax, start);
+      } else {
+        parseImpl(sax);
+      }
+      // tokens must not run into the padding of a borrowed buffer
+      if (!err_ && pos_ > len_) {
+        err_ = kParseErrorInvalidChar;
+      }
+    } else {
+      parseImpl(sax);
+    }
     if (!err_ && hasTrailingChars()) {
       err_ = kParseErrorInvalidChar;
     }
@@ -79,12 +120,31 @@ class Parser {
 
   // parseLazyImpl only mark the json positions, and not parse any more, even
   // the keys.
+  template <ParseFlags>
+  friend class StreamParser;
+
   template <typename LazySAX>
   sonic_force_inline ParseResult ParseLazy(const uint8_t *data, size_t len,
                                            LazySAX &sax) {
     return parseLazyImpl(data, len, sax);
   }
 
+  // Decode the text of a number, which must be followed by a non-number char.
+  // Returns the error if the text is not a json number, e.g. the infinity.
+  template <typename SAX>
+  sonic_force_inline SonicError ParseNumberText(const char *data, size_t len,
+                                                SAX &sax) {
+    reset();
+    json_buf_ = reinterpret_cast<uint8_t *>(const_cast<char *>(data));
+    len_ = len;
+    pos_ = 1;
+    parseNumber(sax);
+    if (err_ == kErrorNone && pos_ != len_) {
+      err_ = kParseErrorInvalidChar;
+    }
+    return err_;
+  }
+
  private:
   sonic_force_inline bool hasTrailingChars() {
     while (pos_ < len_) {
@@ -96,6 +156,76 @@ class Parser {
 
   sonic_force_inline void setParseError(SonicError err) { err_ = err; }
 
+  // Whether the borrowed input is a number which ends at the end of the
+  // input, `start` is the offset of the number. The number scanning doesn't
+  // stop at len_, so it would run into the padding.
+  sonic_force_inline bool isRootNumberAtEnd(size_t &start) const {
+    if (len_ == 0 || static_cast<uint8_t>(json_buf_[len_ - 1] - '0') > 9) {
+      return false;
+    }
+    while (start < len_ && internal::IsSpace(json_buf_[start])) start++;
+    uint8_t c = json_buf_[start];
+    return c == '-' || static_cast<uint8_t>(c - '0') <= 9;
+  }
+
+  // Forwards the number of a copied input to the SAX, the texts are moved
+  // back to the input.
+  template <typename SAX>
+  struct RebaseNumberSAX {
+    SAX &sax;
+    const char *copy;
+    const char *input;
+
+    const char *rebase(const char *p) const { return input + (p - copy); }
+    bool Uint(uint64_t u) { return sax.Uint(u); }
+    bool Int(int64_t i) { return sax.Int(i); }
+    bool Double(double d) { return sax.Double(d); }
+    bool NumStr(StringView s) {
+      return sax.NumStr(StringView(rebase(s.data()), s.size()));
+    }
+    bool LazyDouble(StringView s) {
+      return sax.LazyDouble(StringView(rebase(s.data()), s.size()));
+    }
+    bool Raw(const char *data, size_t len) {
+      return sax.Raw(rebase(data), len);
+    }
+  };
+
+  // Parse the root number of a borrowed input from a zero-padded copy.
+  template <typename SAX>
+  void parseBorrowedNumber(SAX &sax, size_t start) {
+    size_t n = len_ - start;
+    std::vector<uint8_t> copy(n + kJsonPaddingSize, 0);
+    std::memcpy(copy.data(), json_buf_ + start, n);
+    uint8_t *input = json_buf_;
+    size_t len = len_;
+    RebaseNumberSAX<SAX> rebase{sax,
+                                reinterpret_cast<const char *>(copy.data()),
+                                reinterpret_cast<const char *>(input + start)};
+    json_buf_ = copy.data();
+    len_ = n;
+    pos_ = 1;
+    parseNumber(rebase);
+    json_buf_ = input;
+    len_ = len;
+    pos_ += start;
+  }
+
+  sonic_force_inline uint8_t skipSpace() {
+    if constexpr (kBorrowInput) {
+      // The padding of borrowed buffer has no sentinel, so we must not skip
+      // spaces beyond the input. Returns '\0' when reaching the end.
+      if (sonic_unlikely(pos_ >= len_)) {
+        pos_ = len_ + 1;
+        return '\0';
+      }
+      uint8_t c = scan.SkipSpaceSafe(json_buf_, pos_, len_);
+      return internal::IsSpace(c) ? '\0' : c;
+    } else {
+      return scan.SkipSpace(json_buf_, pos_);
+    }
+  }
+
   template <typename SAX>
   sonic_force_inline bool parseNull(SAX &sax) {
     const static uint32_t kNullBin = 0x6c6c756e;
@@ -130,24 +260,123 @@ class Parser {
     return false;
   }
 
+  template <ParseFlags flags = parseFlags>
   sonic_force_inline StringView parseStringHelper() {
     uint8_t *src = json_buf_ + pos_;
     uint8_t *sdst = src;
-    size_t n = internal::parseStringInplace<parseFlags>(src, err_);
+    size_t n = internal::parseStringInplace<flags>(src, err_);
     pos_ = src - json_buf_;
     return StringView(reinterpret_cast<char *>(sdst), n);
   }
 
+  // parseStringBorrowed never writes the input. The string without escaped
+  // chars is a view of the input, otherwise it is unescaped into the memory
+  // from SAX allocator, and `allocated` is set.
+  template <typename SAX>
+  sonic_force_inline StringView parseStringBorrowed(SAX &sax,
+                                                    bool &allocated) {
+    using Allocator = typename SAX::Allocator;
+    constexpr bool kAllowUnescapedControlChars =
+        parseFlags & ParseFlags::kParseAllowUnescapedControlChars;
+    constexpr uint64_t kOnes = 0x0101010101010101ULL;
+    const uint8_t *src = json_buf_ + pos_;
+    allocated = false;
+    // Find the first quote, backslash or control char in 8-byte words. Most
+    // strings are short and unescaped, they end in the first few words.
+    for (size_t i = pos_; i < len_; i += 8) {
+      uint64_t v;
+      std::memcpy(&v, json_buf_ + i, 8);
+      uint64_t quote = v ^ (kOnes * '"');
+      uint64_t bs = v ^ (kOnes * '\\');
+      uint64_t mask = ((quote - kOnes) & ~quote) | ((bs - kOnes) & ~bs);
+      if constexpr (!kAllowUnescapedControlChars) {
+        mask |= (v - kOnes * 0x20) & ~v;
+      }
+      mask &= kOnes * 0x80;
+      if (!mask) continue;
+      i += internal::TrailingZeroes(mask) >> 3;
+      if (sonic_unlikely(i >= len_)) break;
+      uint8_t c = json_buf_[i];
+      if (sonic_likely(c == '"')) {
+        pos_ = i + 1;
+        return StringView(reinterpret_cast<const char *>(src),
+                          json_buf_ + i - src);
+      }
+      if (c != '\\') {
+        pos_ = i;
+        setParseError(kParseErrorUnEscaped);
+        return StringView();
+      }
+      goto escaped;
+    }
+    pos_ = len_;
+    setParseError(kParseErrorInvalidChar);
+    return StringView();
+
+  escaped:
+    if (sonic_unlikely(!internal::SkipString(json_buf_, pos_, len_))) {
+      setParseError(kParseErrorInvalidChar);
+      return StringView();
+    }
+    size_t n = json_buf_ + pos_ - 1 - src;
+    // copy with the end quote, and padding for the SIMD loads
+    uint8_t *dst =
+        static_cast<uint8_t *>(sax.GetAllocator().Malloc(n + 1 + 32));
+    if (sonic_unlikely(dst == nullptr)) {
+      setParseError(kErrorNoMem);
+      return StringView();
+    }
+    std::memcpy(dst, src, n + 1);
+    uint8_t *end = dst;
+    n = internal::parseStringInplace<parseFlags>(end, err_);
+    if (sonic_unlikely(err_ != kErrorNone)) {
+      pos_ = (src - json_buf_) + (end - dst);
+      Allocator::Free(static_cast<void *>(dst));
+      return StringView();
+    }
+    allocated = true;
+    return StringView(reinterpret_cast<const char *>(dst), n);
+  }
+
   template <typename SAX>
   sonic_force_inline bool parseStrInPlace(SAX &sax) {
+    if constexpr (kBorrowInput) {
+      bool allocated = false;
+      StringView sv = parseStringBorrowed(sax, allocated);
+      if (sonic_unlikely(err_ != kErrorNone)) return true;
+      if (sonic_unlikely(!sax.String(sv, allocated))) {
+        if (allocated) SAX::Allocator::Free((void *)(sv.data()));
+        return false;
+      }
+      return true;
+    }
+    size_t start = pos_;
     StringView sv = parseStringHelper();
     if (sonic_unlikely(err_ != kErrorNone)) return true;
+    if constexpr (kLazyStrings) {
+      // The escaped string is checked but kept with the closing quote. It is
+      // unescaped and shortened if the arch doesn't support it.
+      if (json_buf_[pos_ - 1] == '"' && sv.size() == pos_ - 1 - start) {
+        return sax.LazyString(sv);
+      }
+    }
     return sax.String(sv);
   }
 
   template <typename SAX>
   sonic_force_inline bool parseKeyInPlace(SAX &sax) {
-    StringView sv = parseStringHelper();
+    if constexpr (kBorrowInput) {
+      bool allocated = false;
+      StringView sv = parseStringBorrowed(sax, allocated);
+      if (sonic_unlikely(err_ != kErrorNone)) return true;
+      if (sonic_unlikely(!sax.Key(sv, allocated))) {
+        if (allocated) SAX::Allocator::Free((void *)(sv.data()));
+        return false;
+      }
+      return true;
+    }
+    // the keys are always unescaped
+    StringView sv = parseStringHelper<kKeyFlags>();
     if (sonic_unlikely(err_ != kErrorNone)) return true;
     return sax.Key(sv);
   }
@@ -220,6 +449,48 @@ class Parser {
     }
   }
 
+  // Scan the fraction and exponent from s[i], and pass the text of the real
+  // number to sax.LazyDouble. `digits` is the count of the integer digits.
+  // Return false if the number may overflow, it is decoded by the caller to
+  // report the error.
+  template <typename SAX>
+  sonic_force_inline bool parseLazyReal(SAX &sax, size_t start, size_t i,
+                                        int digits) {
+    const char *s = reinterpret_cast<const char *>(json_buf_);
+    using internal::is_digit;
+    int exp = 0;
+    if (s[i] == '.') {
+      i++;
+      if (sonic_unlikely(!is_digit(s[i]))) {
+        pos_ = i;
+        err_ = kParseErrorInvalidChar;
+        return true;
+      }
+      i = internal::SkipDigits(s, i);
+    }
+    if (s[i] == 'e' || s[i] == 'E') {
+      i++;
+      bool neg = (s[i] == '-');
+      if (neg || s[i] == '+') i++;
+      if (sonic_unlikely(!is_digit(s[i]))) {
+        pos_ = i;
+        err_ = kParseErrorInvalidChar;
+        return true;
+      }
+      while (is_digit(s[i])) {
+        if (sonic_likely(exp < 10000)) exp = exp * 10 + (s[i] - '0');
+        i++;
+      }
+      if (neg) exp = -exp;
+    }
+    // the value is less than 10 ^ (digits + exp)
+    if (sonic_unlikely(digits + exp > 308)) return false;
+    pos_ = i;
+    err_ = sax.LazyDouble(StringView(s + start, i - start)) ? kErrorNone
+                                                            : kSaxTermination;
+    return true;
+  }
+
   template <typename SAX>
   sonic_force_inline bool parseNumber(SAX &sax) {
 // These helper macros are used only within this function.
@@ -299,6 +570,11 @@ class Parser {
     /* check leading zero */
     if (s[i] == '0') {
       i++;
+      if constexpr (kLazyNumbers) {
+        if (s[i] == '.' || s[i] == 'e' || s[i] == 'E') {
+          if (parseLazyReal(sax, start_idx, i, 1)) return true;
+        }
+      }
       if (sonic_likely(s[i] == '.')) {
         i++;
         CHECK_DIGIT();
@@ -359,6 +635,11 @@ class Parser {
       }
     }
 
+    if constexpr (kLazyNumbers) {
+      if (s[i] == '.' || s[i] == 'e' || s[i] == 'E') {
+        if (parseLazyReal(sax, start_idx, i, man_nd + exp10)) return true;
+      }
+    }
     if (sonic_likely(s[i] == '.')) {
       i++;
       CHECK_DIGIT();
@@ -703,6 +984,21 @@ class Parser {
 #undef RETURN_SET_ERROR_CODE
   }
 
+  // Parse a number or literal token without spaces, used by StreamParser.
+  template <typename SAX>
+  sonic_force_inline ParseResult parseScalar(char *data, size_t len,
+                                             SAX &sax) {
+    reset();
+    json_buf_ = reinterpret_cast<uint8_t *>(data);
+    len_ = len;
+    pos_ = 1;
+    parsePrimitives(sax);
+    if (!err_ && pos_ != len_) {
+      err_ = kParseErrorInvalidChar;
+    }
+    return ParseResult{err_, static_cast<size_t>(pos_)};
+  }
+
   template <typename SAX>
   void parsePrimitives(SAX &sax) {
     bool ok = true;
@@ -754,6 +1050,24 @@ class Parser {
   struct CheckKeyReturn<T, decltype((void)T::check_key_return, 0)>
       : std::true_type {};
 
+  template <typename T, typename = int>
+  struct HasDepthStack : std::false_type {};
+
+  template <typename T>
+  struct HasDepthStack<T, decltype((void)std::declval<T &>().depth_, 0)>
+      : std::true_type {};
+
+  // The depth stack is kept by the SAX if it has one, so that its capacity
+  // is reused by the next parsing.
+  template <typename SAX>
+  sonic_force_inline std::vector<uint32_t> &depthStack(SAX &sax) {
+    if constexpr (HasDepthStack<SAX>::value) {
+      return sax.depth_;
+    } else {
+      return depth_;
+    }
+  }
+
   template <typename SAX>
   sonic_force_inline void parseImpl(SAX &sax) {
 #define sonic_check_err()     \
@@ -771,18 +1085,18 @@ class Parser {
   } while (0)
 
     using namespace sonic_json::internal;
-    // TODO (liuq19): vector is a temporary choice, will optimize in future.
-    std::vector<uint32_t> depth;
+    std::vector<uint32_t> &depth = depthStack(sax);
+    depth.clear();
     const uint32_t kArrMask = 1ull << 31;
     const uint32_t kObjMask = 0;
     bool found = true;
 
-    uint8_t c = scan.SkipSpace(json_buf_, pos_);
+    uint8_t c = skipSpace();
     switch (c) {
       case '[': {
         sonic_sax_check(sax.StartArray());
         depth.push_back(kArrMask);
-        c = scan.SkipSpace(json_buf_, pos_);
+        c = skipSpace();
         if (c == ']') {
           sonic_sax_check(sax.EndArray(0));
           goto scope_end;
@@ -792,13 +1106,16 @@ class Parser {
       case '{': {
         sonic_sax_check(sax.StartObject());
         depth.push_back(kObjMask);
-        c = scan.SkipSpace(json_buf_, pos_);
+        c = skipSpace();
         if (c == '}') {
           sonic_sax_check(sax.EndObject(0));
           goto scope_end;
         }
         goto obj_key;
       }
+      case '\0':
+        // no more tokens in borrowed input
+        goto err_invalid_char;
       default:
         parsePrimitives(sax);
         goto doc_end;
@@ -808,7 +1125,7 @@ class Parser {
     if (sonic_unlikely(c != '"')) goto err_invalid_char;
     found = parseKeyInPlace(sax);
     sonic_check_err();
-    c = scan.SkipSpace(json_buf_, pos_);
+    c = skipSpace();
     if (sonic_unlikely(c != ':')) goto err_invalid_char;
 
     if SONIC_IF_CONSTEXPR (CheckKeyReturn<SAX>::value) {
@@ -834,12 +1151,12 @@ class Parser {
       if (err_ == kErrorNone) err_ = kSaxTermination;
       return;
     }
-    c = scan.SkipSpace(json_buf_, pos_);
+    c = skipSpace();
     switch (c) {
       case '{': {
         sonic_sax_check(sax.StartObject());
         depth.push_back(kObjMask);
-        c = scan.SkipSpace(json_buf_, pos_);
+        c = skipSpace();
         if (c == '}') {
           sonic_sax_check(sax.EndObject(0));
           goto scope_end;
@@ -849,7 +1166,7 @@ class Parser {
       case '[': {
         sonic_sax_check(sax.StartArray());
         depth.push_back(kArrMask);
-        c = scan.SkipSpace(json_buf_, pos_);
+        c = skipSpace();
         if (c == ']') {
           sonic_sax_check(sax.EndArray(0));
           goto scope_end;
@@ -904,12 +1221,12 @@ class Parser {
       default:
         goto err_invalid_char;
     }
-    c = scan.SkipSpace(json_buf_, pos_);
+    c = skipSpace();
 
   obj_cont:
     depth.back()++;
     if (c == ',') {
-      c = scan.SkipSpace(json_buf_, pos_);
+      c = skipSpace();
       goto obj_key;
     }
     if (sonic_unlikely(c != '}')) {
@@ -923,7 +1240,7 @@ class Parser {
     if (sonic_unlikely(depth.empty())) {
       goto doc_end;
     }
-    c = scan.SkipSpace(json_buf_, pos_);
+    c = skipSpace();
     if (depth.back() & kArrMask) {
       goto arr_cont;
     }
@@ -934,7 +1251,7 @@ class Parser {
       case '{': {
         sonic_sax_check(sax.StartObject());
         depth.push_back(kObjMask);
-        c = scan.SkipSpace(json_buf_, pos_);
+        c = skipSpace();
         if (c == '}') {
           sonic_sax_check(sax.EndObject(0));
           goto scope_end;
@@ -944,7 +1261,7 @@ class Parser {
       case '[': {
         sonic_sax_check(sax.StartArray());
         depth.push_back(kArrMask);
-        c = scan.SkipSpace(json_buf_, pos_);
+        c = skipSpace();
         if (c == ']') {
           sonic_sax_check(sax.EndArray(0));
           goto scope_end;
@@ -999,12 +1316,12 @@ class Parser {
       default:
         goto err_invalid_char;
     }
-    c = scan.SkipSpace(json_buf_, pos_);
+    c = skipSpace();
 
   arr_cont:
     depth.back()++;
     if (c == ',') {
-      c = scan.SkipSpace(json_buf_, pos_);
+      c = skipSpace();
       goto arr_val;
     }
     if (sonic_likely(c == ']')) {
@@ -1163,12 +1480,71 @@ class Parser {
     len_ = 0;
   }
   constexpr static size_t kJsonPaddingSize = SONICJSON_PADDING;
+  constexpr static bool kBorrowInput =
+      parseFlags & ParseFlags::kParseBorrowInput;
+  constexpr static bool kLazyNumbers =
+      parseFlags & ParseFlags::kParseLazyNumbers;
+  constexpr static bool kLazyStrings =
+      parseFlags & ParseFlags::kParseLazyStrings;
+  constexpr static ParseFlags kKeyFlags = static_cast<ParseFlags>(
+      static_cast<uint32_t>(parseFlags) &
+      ~static_cast<uint32_t>(ParseFlags::kParseLazyStrings));
+  static_assert(!(kLazyStrings && kBorrowInput),
+                "kParseLazyStrings unescapes the strings in the parsed buffer, "
+                "which is not written with kParseBorrowInput");
+  static_assert(!(kLazyStrings &&
+                  (parseFlags & ParseFlags::kParseAllowUnescapedControlChars)),
+                "kParseLazyStrings serializes the strings as their text, "
+                "which must not have unescaped control chars");
 
   uint8_t *json_buf_{nullptr};
   size_t len_{0};
   size_t pos_{0};
   SonicError err_{kErrorNone};
   internal::SkipScanner scan{};
+  std::vector<uint32_t> depth_{};  // used if the SAX has no depth stack
 };
 
+namespace internal {
+
+// Decode the text of a json number as a double, returns the error of parsing
+// it as a json if the text is not a json number.
+inline SonicError DecodeDouble(const char *data, size_t len, double &val) {
+  struct Handler {
+    double val = 0;
+    bool Double(double d) {
+      val = d;
+      return true;
+    }
+    bool Int(int64_t i) { return Double(static_cast<double>(i)); }
+    bool Uint(uint64_t u) { return Double(static_cast<double>(u)); }
+  } h;
+  // The text may end at the end of a borrowed input, whose padding is not
+  // zeros, so decode it from a zero-padded copy.
+  constexpr size_t kShort = 64;
+  char buf[kShort + SONICJSON_PADDING];
+  std::vector<char> long_buf;
+  char *copy = buf;
+  if (sonic_unlikely(len > kShort)) {
+    long_buf.resize(len + SONICJSON_PADDING);
+    copy = long_buf.data();
+  }
+  std::memcpy(copy, data, len);
+  std::memset(copy + len, 0, SONICJSON_PADDING);
+  Parser<ParseFlags::kParseDefault> p;
+  SonicError err = len != 0 ? p.ParseNumberText(copy, len, h)
+                            : kParseErrorInvalidChar;
+  val = h.val;
+  return err;
+}
+
+// Decode the text of a real number kept by kParseLazyNumbers.
+inline double DecodeLazyDouble(const char *data, size_t len) {
+  double val = 0;
+  DecodeDouble(data, len, val);
+  return val;
+}
+
+}  // namespace internal
+
 }  // namespace sonic_json
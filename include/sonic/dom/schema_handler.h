@@ -20,6 +20,7 @@
 
 #include "sonic/dom/type.h"
 #include "sonic/internal/arch/simd_base.h"
+#include "sonic/internal/arch/simd_quote.h"
 #include "sonic/string_view.h"
 #include "sonic/writebuffer.h"
 
@@ -212,6 +213,28 @@ class SchemaHandler {
     return true;
   }
 
+  // Used by the stream parser, the allocated strings are owned by the handler
+  // once accepted.
+  sonic_force_inline bool Key(StringView s, bool allocated) {
+    if (parent_node_ && parent_node_->IsObject()) {
+      // the key is only used to find the member
+      bool found = Key(s);
+      if (found && allocated) Allocator::Free((void *)(s.data()));
+      return found;
+    }
+    cur_node_ = nullptr;
+    return stringImpl(s, allocated ? kStringFree : kStringCopy);
+  }
+
+  sonic_force_inline bool String(StringView s, bool allocated) {
+    if (cur_node_) {
+      cur_node_->SetString(s, *alloc_);
+      if (allocated) Allocator::Free((void *)(s.data()));
+      return true;
+    }
+    return stringImpl(s, allocated ? kStringFree : kStringCopy);
+  }
+
   sonic_force_inline bool StartObject() noexcept {
     if (cur_node_) {
       parent_st_.emplace_back(parent_node_);
@@ -262,6 +285,31 @@ class SchemaHandler {
     return true;
   }
 
+  sonic_force_inline bool LazyString(StringView s) {
+    if (cur_node_) {
+      // the node is copied, so unescape it now
+      size_t len = internal::DecodeLazyString(const_cast<char *>(s.data()));
+      cur_node_->SetString(StringView(s.data(), len), *alloc_);
+      return true;
+    }
+    return stringImpl(s,
+                      static_cast<TypeFlag>(kStringCopy | kEscapedStringMask));
+  }
+
+  sonic_force_inline bool LazyDouble(StringView s) {
+    const TypeFlag flag = static_cast<TypeFlag>(kReal | kLazyNumberMask);
+    if (cur_node_) {
+      cur_node_->setLength(s.size(), flag);
+      cur_node_->sv.p = s.data();
+      return true;
+    }
+    SONIC_ADD_NODE();
+    new (&st_[np_ - 1]) NodeType();
+    st_[np_ - 1].setLength(s.size(), flag);
+    st_[np_ - 1].sv.p = s.data();
+    return true;
+  }
+
   sonic_force_inline bool EndObject(uint32_t pairs) {
     if (parent_node_ && parent_node_->IsObject()) {
       parent_node_ = parent_st_.back();
@@ -351,13 +399,16 @@ class SchemaHandler {
   }
   static constexpr bool check_key_return = true;
 
+  sonic_force_inline Allocator &GetAllocator() { return *alloc_; }
+
  private:
   friend class GenericDocument<NodeType>;
 
-  sonic_force_inline bool stringImpl(StringView s) {
+  sonic_force_inline bool stringImpl(StringView s,
+                                     TypeFlag type = kStringCopy) {
     SONIC_ADD_NODE();
     new (&st_[np_ - 1]) NodeType();
-    st_[np_ - 1].setLength(s.size(), kStringCopy);
+    st_[np_ - 1].setLength(s.size(), type);
     st_[np_ - 1].sv.p = s.data();
     return true;
   }
@@ -368,9 +419,19 @@ class SchemaHandler {
     if (sonic_likely(np_ < cap_)) {
       np_++;
       return true;
-    } else {
+    }
+    // the stream parser can not reserve the stack by the input size
+    size_t new_cap = cap_ * 2;
+    NodeType *new_st = static_cast<NodeType *>(
+        std::realloc((void *)(st_), sizeof(NodeType) * new_cap));
+    if (!new_st) {
+      oom_ = true;
       return false;
     }
+    st_ = new_st;
+    cap_ = new_cap;
+    np_++;
+    return true;
   }
 
   NodeType *st_{nullptr};
@@ -19,6 +19,7 @@
 
 #include <cmath>
 #include <cstring>
+#include <type_traits>
 
 #include "sonic/dom/flags.h"
 #include "sonic/dom/type.h"
@@ -26,12 +27,67 @@
 #include "sonic/internal/arch/simd_quote.h"
 #include "sonic/internal/ftoa.h"
 #include "sonic/internal/itoa.h"
+#include "sonic/span.h"
 #include "sonic/writebuffer.h"
 
 namespace sonic_json {
 
 namespace internal {
 
+// Write Infinity/-Infinity or NaN/-NaN as strings if kSerializeInfNan is set.
+// Returns the written length, or 0 if the double can not be serialized.
+template <SerializeFlags serializeFlags>
+sonic_force_inline ssize_t SerializeInfNan(char* out, double d) {
+  if constexpr (serializeFlags & SerializeFlags::kSerializeInfNan) {
+    if (std::isinf(d)) {
+      const bool neg_inf = std::signbit(d);
+      const char* s = neg_inf ? "\"-Infinity\"" : "\"Infinity\"";
+      ssize_t rn = neg_inf ? 11 : 10;
+      std::memcpy(out, s, (size_t)rn);
+      return rn;
+    }
+    if (std::isnan(d)) {
+      const bool neg_nan = std::signbit(d);
+      const char* s = neg_nan ? "\"-NaN\"" : "\"NaN\"";
+      ssize_t rn = neg_nan ? 6 : 5;
+      std::memcpy(out, s, (size_t)rn);
+      return rn;
+    }
+  }
+  (void)out;
+  (void)d;
+  return 0;
+}
+
+// Write the values of an array packed by kParsePackNumberArrays in one loop,
+// with the brackets and a trailing comma. Returns false for infinity and NaN,
+// unless kSerializeInfNan is set.
+template <SerializeFlags serializeFlags, typename T>
+sonic_force_inline bool SerializePacked(Span<const T> vals, WriteBuffer& wb) {
+  constexpr size_t kNumberSize = 33;
+  wb.Grow(vals.size() * kNumberSize + 2);
+  char* const begin = wb.End<char>();
+  char* p = begin;
+  *p++ = '[';
+  for (const T v : vals) {
+    if constexpr (std::is_same<T, int64_t>::value) {
+      p = internal::I64toa(p, v);
+    } else {
+      ssize_t rn = internal::F64toa<serializeFlags>(p, v);
+      if (sonic_unlikely(rn <= 0)) {
+        rn = SerializeInfNan<serializeFlags>(p, v);
+        if (rn <= 0) return false;
+      }
+      p += rn;
+    }
+    *p++ = ',';
+  }
+  p[-1] = ']';
+  *p++ = ',';
+  wb.PushSizeUnsafe<char>(p - begin);
+  return true;
+}
+
 template <SerializeFlags serializeFlags, typename NodeType>
 sonic_force_inline SonicError SerializeImpl(const NodeType* node,
                                             WriteBuffer& wb) {
@@ -64,7 +120,9 @@ sonic_force_inline SonicError SerializeImpl(const NodeType* node,
     wb.Reserve(estimate + wb.Size());
   }
 
-  bool is_single = (!node->IsContainer()) || node->Empty();
+  // the packed array is written as a single value
+  bool is_single =
+      (!node->IsContainer()) || node->Empty() || node->isPackedArray();
   if (sonic_unlikely(is_single)) {
     val_cnt = 1;
     goto val_begin;
@@ -78,6 +136,21 @@ val_begin:
   switch (node->getBasicType()) {
     case kString: {
       is_key = ((size_t)(is_obj) & (~val_cnt));
+      if constexpr (!(serializeFlags & SerializeFlags::kSerializeEscapeEmoji)) {
+        // the escaped text by kParseLazyStrings is valid output, unless it
+        // is unescaped already
+        if (sonic_unlikely(node->isEscapedString()) &&
+            node->lockEscapedString()) {
+          str_len = node->getEscapedString().size();
+          wb.Grow(str_len + 3);
+          wb.PushUnsafe<char>('"');
+          wb.PushUnsafe(node->getEscapedString().data(), str_len);
+          wb.PushUnsafe<char>('"');
+          wb.PushUnsafe<char>(',');
+          node->unlockEscapedString(NodeType::kEscapedPending);
+          break;
+        }
+      }
       str_len = node->Size();
       inc_len = str_len * 6 + 32 + 3;
       wb.Grow(inc_len);
@@ -102,28 +175,19 @@ val_begin:
                wb.End<char>();
           break;
         case kReal: {
+          if (sonic_unlikely(node->isLazyNumber())) {
+            rn = 0;
+            str_len = node->getLazyNumber().size();
+            wb.Grow(str_len + 1);
+            wb.PushUnsafe(node->getLazyNumber().data(), str_len);
+            break;
+          }
           const double d = node->GetDouble();
           rn = internal::F64toa<serializeFlags>(wb.End<char>(), d);
           // support Infinity/-Infinity or NaN/-NaN
-
           if (sonic_unlikely(rn <= 0)) {
-            if (serializeFlags & SerializeFlags::kSerializeInfNan) {
-              if (sonic_unlikely(std::isinf(d))) {
-                const bool neg_inf = std::signbit(d);
-                const char* s = neg_inf ? "\"-Infinity\"" : "\"Infinity\"";
-                rn = neg_inf ? 11 : 10;
-                std::memcpy(wb.End<char>(), s, (size_t)rn);
-              } else if (sonic_unlikely(std::isnan(d))) {
-                const bool neg_nan = std::signbit(d);
-                const char* s = neg_nan ? "\"-NaN\"" : "\"NaN\"";
-                rn = neg_nan ? 6 : 5;
-                std::memcpy(wb.End<char>(), s, (size_t)rn);
-              } else {
-                goto inf_err;
-              }
-            } else {
-              goto inf_err;
-            }
+            rn = SerializeInfNan<serializeFlags>(wb.End<char>(), d);
+            if (rn <= 0) goto inf_err;
           }
           break;
         }
@@ -153,6 +217,15 @@ val_begin:
     }
     case kObject:
     case kArray: {
+      if (sonic_unlikely(node->isPackedArray())) {
+        bool ok = node->GetInt64Span().empty()
+                      ? SerializePacked<serializeFlags>(node->GetDoubleSpan(),
+                                                        wb)
+                      : SerializePacked<serializeFlags>(node->GetInt64Span(),
+                                                        wb);
+        if (sonic_unlikely(!ok)) goto inf_err;
+        break;
+      }
       wb.Grow(3);
       is_obj_nxt = node->IsObject();
       val_cnt_nxt = node->Size();
@@ -0,0 +1,532 @@
+/*
+ * Copyright 2022 ByteDance Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "sonic/dom/flags.h"
+#include "sonic/dom/generic_document.h"
+#include "sonic/dom/parser.h"
+#include "sonic/error.h"
+#include "sonic/internal/arch/simd_quote.h"
+#include "sonic/internal/utils.h"
+#include "sonic/string_view.h"
+
+namespace sonic_json {
+
+/**
+ * @brief StreamParser parses a JSON document from a sequence of chunks. It
+ * emits SAX events as soon as the tokens are complete, and keeps its state
+ * (the depth stack and the partial string or number) between chunks. Strings
+ * are unescaped into the memory from the SAX allocator and handed over by
+ * `Key(StringView, true)` and `String(StringView, true)`, so the chunks can be
+ * released once Feed() returns.
+ */
+template <ParseFlags parseFlags = ParseFlags::kParseDefault>
+class StreamParser {
+  static_assert(!(parseFlags & (ParseFlags::kParseBorrowInput |
+                                ParseFlags::kParseIntegerAsRaw |
+                                ParseFlags::kParseOverflowNumAsNumStr |
+                                ParseFlags::kParseLazyNumbers |
+                                ParseFlags::kParseLazyStrings)),
+                "StreamParser does not keep the input, so flags that "
+                "reference or index the whole input are unsupported");
+
+ public:
+  StreamParser() = default;
+  StreamParser(StreamParser &&) = default;
+  StreamParser(const StreamParser &) = delete;
+  StreamParser &operator=(StreamParser &&) = default;
+  StreamParser &operator=(const StreamParser &) = delete;
+  ~StreamParser() = default;
+
+  /**
+   * @brief Parse the next chunk of the document.
+   * @param data chunk pointer, no padding is needed
+   * @param len chunk size
+   * @param sax SAX handler, must be the same one for the whole document
+   * @return the first error and its offset in the whole document. The error
+   * is kept, and all later calls return it until Reset().
+   */
+  template <typename SAX>
+  ParseResult Feed(const char *data, size_t len, SAX &sax) {
+    if (sonic_likely(err_ == kErrorNone)) {
+      feedImpl(data, len, sax);
+    }
+    return ParseResult(err_, err_ == kErrorNone ? offset_ : err_pos_);
+  }
+
+  /**
+   * @brief Finish the document after the last chunk. The pending number at
+   * the end is emitted, and the document must be complete.
+   */
+  template <typename SAX>
+  ParseResult Finish(SAX &sax) {
+    if (err_ == kErrorNone && token_ == kScalarToken) {
+      token_ = kNoToken;
+      emitScalar(tok_.data(), tok_.size(), sax);
+    }
+    if (err_ == kErrorNone && state_ != kDone) {
+      setError(kParseErrorEof, offset_);
+    }
+    return ParseResult(err_, err_ == kErrorNone ? offset_ : err_pos_);
+  }
+
+  /**
+   * @brief Reset the parser for a new document, the buffers are reused.
+   */
+  void Reset() {
+    depth_.clear();
+    tok_.clear();
+    state_ = kValue;
+    token_ = kNoToken;
+    escaped_ = false;
+    skipping_ = false;
+    skip_depth_ = 0;
+    tok_start_ = 0;
+    offset_ = 0;
+    err_pos_ = 0;
+    err_ = kErrorNone;
+  }
+
+  /**
+   * @brief Whether a complete document has been parsed.
+   */
+  bool Done() const { return state_ == kDone && err_ == kErrorNone; }
+
+ private:
+  // what the next token is expected to be
+  enum State : uint8_t {
+    kValue,
+    kValueOrEnd,  // after '['
+    kKey,
+    kKeyOrEnd,  // after '{'
+    kColon,
+    kCommaOrEnd,
+    kDone,
+  };
+  // the token not finished in the previous chunk
+  enum Token : uint8_t {
+    kNoToken,
+    kStringToken,
+    kKeyToken,
+    kScalarToken,
+  };
+
+  template <typename T, typename = int>
+  struct CheckKeyReturn : std::false_type {};
+
+  template <typename T>
+  struct CheckKeyReturn<T, decltype((void)T::check_key_return, 0)>
+      : std::true_type {};
+
+  sonic_force_inline static bool isScalarChar(uint8_t c) {
+    return (c >= '0' && c <= '9') || ((c | 0x20) >= 'a' && (c | 0x20) <= 'z') ||
+           c == '-' || c == '+' || c == '.';
+  }
+
+  sonic_force_inline static const char *findQuoteOrBackslash(
+      const char *p, const char *end) {
+    constexpr uint64_t kOnes = 0x0101010101010101ULL;
+    for (; p + 8 <= end; p += 8) {
+      uint64_t v;
+      std::memcpy(&v, p, 8);
+      uint64_t quote = v ^ (kOnes * '"');
+      uint64_t bs = v ^ (kOnes * '\\');
+      uint64_t mask = ((quote - kOnes) & ~quote) | ((bs - kOnes) & ~bs);
+      mask &= kOnes * 0x80;
+      if (mask) return p + (internal::TrailingZeroes(mask) >> 3);
+    }
+    while (p < end && *p != '"' && *p != '\\') p++;
+    return p;
+  }
+
+  sonic_force_inline static const char *skipSpace(const char *p,
+                                                 const char *end) {
+    // fast path for the indents in pretty-printed JSON
+    constexpr uint64_t kSpaces = 0x2020202020202020ULL;
+    while (p < end && internal::IsSpace(static_cast<uint8_t>(*p))) {
+      uint64_t v;
+      if (p + 8 <= end && (std::memcpy(&v, p, 8), v == kSpaces)) {
+        p += 8;
+      } else {
+        p++;
+      }
+    }
+    return p;
+  }
+
+  sonic_force_inline void setError(SonicError err, size_t pos) {
+    err_ = err;
+    err_pos_ = pos;
+  }
+
+  template <typename SAX>
+  void feedImpl(const char *data, size_t len, SAX &sax) {
+    const char *p = data;
+    const char *end = data + len;
+#define SONIC_POS(ptr) (offset_ + static_cast<size_t>((ptr) - data))
+#define SONIC_SAX_CHECK(expr)                            \
+  do {                                                   \
+    if (!skipping_ && sonic_unlikely(!(expr))) {         \
+      setError(kSaxTermination, SONIC_POS(p));           \
+      return;                                            \
+    }                                                    \
+  } while (0)
+
+    while (p < end) {
+      if (token_ == kScalarToken) {
+        const char *s = p;
+        while (p < end && isScalarChar(*p)) p++;
+        if (p == end) {
+          // the number may continue in the next chunk
+          if (!skipping_) tok_.append(s, p - s);
+          break;
+        }
+        token_ = kNoToken;
+        if (tok_.empty()) {
+          emitScalar(s, p - s, sax);
+        } else {
+          tok_.append(s, p - s);
+          emitScalar(tok_.data(), tok_.size(), sax);
+          tok_.clear();
+        }
+        if (err_ != kErrorNone) return;
+        continue;
+      }
+      if (token_ != kNoToken) {
+        const char *s = p;
+        bool closed = false;
+        while (p < end) {
+          if (escaped_) {
+            escaped_ = false;
+            p++;
+            continue;
+          }
+          p = findQuoteOrBackslash(p, end);
+          if (p == end) break;
+          if (*p++ == '"') {
+            closed = true;
+            break;
+          }
+          escaped_ = true;
+        }
+        if (!closed) {
+          if (!skipping_) tok_.append(s, p - s);
+          break;
+        }
+        bool is_key = token_ == kKeyToken;
+        token_ = kNoToken;
+        if (tok_.empty()) {
+          emitString(s, p - s, is_key, sax);
+        } else {
+          tok_.append(s, p - s);
+          emitString(tok_.data(), tok_.size(), is_key, sax);
+          tok_.clear();
+        }
+        if (err_ != kErrorNone) return;
+        continue;
+      }
+
+      p = skipSpace(p, end);
+      if (p == end) break;
+      uint8_t c = static_cast<uint8_t>(*p);
+      switch (state_) {
+        case kValueOrEnd:
+          if (c == ']') {
+            p++;
+            if (!endContainer(sax)) {
+              setError(kSaxTermination, SONIC_POS(p));
+              return;
+            }
+            continue;
+          }
+          // fall through
+        case kValue:
+          switch (c) {
+            case '{':
+              SONIC_SAX_CHECK(sax.StartObject());
+              depth_.push_back(kObjMask);
+              state_ = kKeyOrEnd;
+              p++;
+              continue;
+            case '[':
+              SONIC_SAX_CHECK(sax.StartArray());
+              depth_.push_back(kArrMask);
+              state_ = kValueOrEnd;
+              p++;
+              continue;
+            case '"':
+              token_ = kStringToken;
+              tok_start_ = SONIC_POS(p);
+              p++;
+              continue;
+            case '0':
+            case '1':
+            case '2':
+            case '3':
+            case '4':
+            case '5':
+            case '6':
+            case '7':
+            case '8':
+            case '9':
+            case '-':
+            case 't':
+            case 'f':
+            case 'n':
+              token_ = kScalarToken;
+              tok_start_ = SONIC_POS(p);
+              continue;
+            default:
+              break;
+          }
+          break;
+        case kKeyOrEnd:
+          if (c == '}') {
+            p++;
+            if (!endContainer(sax)) {
+              setError(kSaxTermination, SONIC_POS(p));
+              return;
+            }
+            continue;
+          }
+          // fall through
+        case kKey:
+          if (c == '"') {
+            token_ = kKeyToken;
+            tok_start_ = SONIC_POS(p);
+            p++;
+            continue;
+          }
+          break;
+        case kColon:
+          if (c == ':') {
+            state_ = kValue;
+            p++;
+            continue;
+          }
+          break;
+        case kCommaOrEnd: {
+          bool in_arr = depth_.back() & kArrMask;
+          if (c == ',') {
+            state_ = in_arr ? kValue : kKey;
+            p++;
+            continue;
+          }
+          if (c == (in_arr ? ']' : '}')) {
+            p++;
+            if (!endContainer(sax)) {
+              setError(kSaxTermination, SONIC_POS(p));
+              return;
+            }
+            continue;
+          }
+          break;
+        }
+        case kDone:
+          break;
+      }
+      setError(kParseErrorInvalidChar, SONIC_POS(p));
+      return;
+    }
+    offset_ += len;
+#undef SONIC_SAX_CHECK
+#undef SONIC_POS
+  }
+
+  template <typename SAX>
+  sonic_force_inline bool endContainer(SAX &sax) {
+    uint32_t cnt = depth_.back();
+    bool ok = true;
+    if (!skipping_) {
+      ok = (cnt & kArrMask) ? sax.EndArray(cnt & (kArrMask - 1))
+                            : sax.EndObject(cnt);
+    }
+    depth_.pop_back();
+    endValue();
+    return ok;
+  }
+
+  sonic_force_inline void endValue() {
+    if (depth_.empty()) {
+      state_ = kDone;
+      return;
+    }
+    if (skipping_ && depth_.size() == skip_depth_) {
+      // the skipped value is not counted
+      skipping_ = false;
+    } else {
+      depth_.back()++;
+    }
+    state_ = kCommaOrEnd;
+  }
+
+  // `s` is the raw string with the end quote.
+  template <typename SAX>
+  void emitString(const char *s, size_t n, bool is_key, SAX &sax) {
+    using Allocator = typename SAX::Allocator;
+    if (skipping_) {
+      if (is_key) {
+        state_ = kColon;
+      } else {
+        endValue();
+      }
+      return;
+    }
+    // padding for the SIMD loads in parseStringInplace
+    uint8_t *dst = static_cast<uint8_t *>(sax.GetAllocator().Malloc(n + 32));
+    if (sonic_unlikely(dst == nullptr)) {
+      setError(kErrorNoMem, tok_start_);
+      return;
+    }
+    std::memcpy(dst, s, n);
+    uint8_t *src = dst;
+    SonicError err = kErrorNone;
+    size_t len = internal::parseStringInplace<parseFlags>(src, err);
+    if (sonic_unlikely(err != kErrorNone)) {
+      Allocator::Free(static_cast<void *>(dst));
+      setError(err, tok_start_ + 1 + (src - dst));
+      return;
+    }
+    StringView sv(reinterpret_cast<const char *>(dst), len);
+    if (!is_key) {
+      if (sonic_unlikely(!sax.String(sv, true))) {
+        Allocator::Free(static_cast<void *>(dst));
+        setError(kSaxTermination, tok_start_);
+        return;
+      }
+      endValue();
+      return;
+    }
+    state_ = kColon;
+    if (sonic_unlikely(!sax.Key(sv, true))) {
+      Allocator::Free(static_cast<void *>(dst));
+      if constexpr (CheckKeyReturn<SAX>::value) {
+        // skip the value of the unwanted key
+        skipping_ = true;
+        skip_depth_ = depth_.size();
+      } else {
+        setError(kSaxTermination, tok_start_);
+      }
+    }
+  }
+
+  // parse a complete number or literal by the DOM parser
+  template <typename SAX>
+  void emitScalar(const char *s, size_t n, SAX &sax) {
+    if (skipping_) {
+      endValue();
+      return;
+    }
+    // numbers and literals are short, most fit in the stack buffer
+    char buf[kScalarBufSize + SONICJSON_PADDING];
+    char *dst = buf;
+    if (sonic_unlikely(n > kScalarBufSize)) {
+      scratch_.resize(n + SONICJSON_PADDING);
+      dst = &scratch_[0];
+    }
+    std::memcpy(dst, s, n);
+    // the same ending mask as the document buffer
+    dst[n] = 'x';
+    dst[n + 1] = '"';
+    dst[n + 2] = 'x';
+    ParseResult ret = parser_.parseScalar(dst, n, sax);
+    if (sonic_unlikely(ret.Error() != kErrorNone)) {
+      setError(ret.Error(), tok_start_ + ret.Offset());
+      return;
+    }
+    endValue();
+  }
+
+  constexpr static uint32_t kArrMask = 1ull << 31;
+  constexpr static uint32_t kObjMask = 0;
+  constexpr static size_t kScalarBufSize = 64;
+
+  std::vector<uint32_t> depth_{};
+  // the partial token, and the scratch to parse a scalar
+  std::string tok_{};
+  std::string scratch_{};
+  Parser<parseFlags> parser_{};
+  State state_{kValue};
+  Token token_{kNoToken};
+  bool escaped_{false};
+  bool skipping_{false};
+  size_t skip_depth_{0};
+  size_t tok_start_{0};
+  size_t offset_{0};
+  size_t err_pos_{0};
+  SonicError err_{kErrorNone};
+};
+
+/**
+ * @brief GenericDocumentStream builds a document from chunks. The document is
+ * cleared when the stream is created, and holds the result after Finish().
+ */
+template <typename NodeType, ParseFlags parseFlags = ParseFlags::kParseDefault>
+class GenericDocumentStream {
+ public:
+  explicit GenericDocumentStream(GenericDocument<NodeType> &doc)
+      : doc_(doc), sax_(doc.GetAllocator()) {
+    doc_.parseStreamBegin();
+    sax_.interner_ = doc_.template keyInterner<parseFlags>();
+    sax_.map_members_ = doc_.template createMapMembers<parseFlags>();
+    sax_.pack_arrays_ = parseFlags & ParseFlags::kParsePackNumberArrays;
+    setup_ = sax_.SetUp(StringView());
+  }
+
+  GenericDocumentStream(const GenericDocumentStream &) = delete;
+  GenericDocumentStream &operator=(const GenericDocumentStream &) = delete;
+
+  /**
+   * @brief Parse the next chunk, the chunk can be released after return.
+   */
+  ParseResult Feed(const char *data, size_t len) {
+    if (sonic_unlikely(!setup_)) return ParseResult(kErrorNoMem);
+    ParseResult ret = parser_.Feed(data, len, sax_);
+    if (sonic_unlikely(sax_.oom_)) return ParseResult(kErrorNoMem);
+    return ret;
+  }
+
+  ParseResult Feed(StringView chunk) { return Feed(chunk.data(), chunk.size()); }
+
+  /**
+   * @brief Finish the stream and move the result into the document. The
+   * errors can be checked by the document, as after Parse().
+   */
+  GenericDocument<NodeType> &Finish() {
+    if (sonic_unlikely(!setup_)) {
+      return doc_.parseStreamEnd(sax_, ParseResult(kErrorNoMem));
+    }
+    return doc_.parseStreamEnd(sax_, parser_.Finish(sax_));
+  }
+
+ private:
+  GenericDocument<NodeType> &doc_;
+  SAXHandler<NodeType> sax_;
+  StreamParser<parseFlags> parser_{};
+  bool setup_{false};
+};
+
+template <ParseFlags parseFlags = ParseFlags::kParseDefault>
+using DocumentStream =
+    GenericDocumentStream<DNode<SONIC_DEFAULT_ALLOCATOR>, parseFlags>;
+
+}  // namespace sonic_json
@@ -0,0 +1,172 @@
+/*
+ * Copyright 2022 ByteDance Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <map>
+#include <optional>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "sonic/string_view.h"
+
+namespace sonic_json {
+
+/**
+ * @brief StructField describes a registered member of a struct: the JSON key
+ * and the pointer to the member.
+ */
+template <typename Class, typename Member>
+struct StructField {
+  using ClassType = Class;
+  using MemberType = Member;
+
+  StringView name;
+  Member Class::*ptr;
+};
+
+namespace internal {
+
+template <typename Class, typename Member>
+constexpr StructField<Class, Member> MakeStructField(const char *name,
+                                                     Member Class::*ptr) {
+  return StructField<Class, Member>{StringView(name), ptr};
+}
+
+}  // namespace internal
+
+// SONIC_FOR_EACH expands `m(x)` for every argument, separated by commas.
+#define SONIC_EXPAND(x) x
+#define SONIC_FE_1(m, x) m(x)
+#define SONIC_FE_2(m, x, ...) m(x), SONIC_EXPAND(SONIC_FE_1(m, __VA_ARGS__))
+#define SONIC_FE_3(m, x, ...) m(x), SONIC_EXPAND(SONIC_FE_2(m, __VA_ARGS__))
+#define SONIC_FE_4(m, x, ...) m(x), SONIC_EXPAND(SONIC_FE_3(m, __VA_ARGS__))
+#define SONIC_FE_5(m, x, ...) m(x), SONIC_EXPAND(SONIC_FE_4(m, __VA_ARGS__))
+#define SONIC_FE_6(m, x, ...) m(x), SONIC_EXPAND(SONIC_FE_5(m, __VA_ARGS__))
+#define SONIC_FE_7(m, x, ...) m(x), SONIC_EXPAND(SONIC_FE_6(m, __VA_ARGS__))
+#define SONIC_FE_8(m, x, ...) m(x), SONIC_EXPAND(SONIC_FE_7(m, __VA_ARGS__))
+#define SONIC_FE_9(m, x, ...) m(x), SONIC_EXPAND(SONIC_FE_8(m, __VA_ARGS__))
+#define SONIC_FE_10(m, x, ...) m(x), SONIC_EXPAND(SONIC_FE_9(m, __VA_ARGS__))
+#define SONIC_FE_11(m, x, ...) m(x), SONIC_EXPAND(SONIC_FE_10(m, __VA_ARGS__))
+#define SONIC_FE_12(m, x, ...) m(x), SONIC_EXPAND(SONIC_FE_11(m, __VA_ARGS__))
+#define SONIC_FE_13(m, x, ...) m(x), SONIC_EXPAND(SONIC_FE_12(m, __VA_ARGS__))
+#define SONIC_FE_14(m, x, ...) m(x), SONIC_EXPAND(SONIC_FE_13(m, __VA_ARGS__))
+#define SONIC_FE_15(m, x, ...) m(x), SONIC_EXPAND(SONIC_FE_14(m, __VA_ARGS__))
+#define SONIC_FE_16(m, x, ...) m(x), SONIC_EXPAND(SONIC_FE_15(m, __VA_ARGS__))
+#define SONIC_FE_17(m, x, ...) m(x), SONIC_EXPAND(SONIC_FE_16(m, __VA_ARGS__))
+#define SONIC_FE_18(m, x, ...) m(x), SONIC_EXPAND(SONIC_FE_17(m, __VA_ARGS__))
+#define SONIC_FE_19(m, x, ...) m(x), SONIC_EXPAND(SONIC_FE_18(m, __VA_ARGS__))
+#define SONIC_FE_20(m, x, ...) m(x), SONIC_EXPAND(SONIC_FE_19(m, __VA_ARGS__))
+#define SONIC_FE_21(m, x, ...) m(x), SONIC_EXPAND(SONIC_FE_20(m, __VA_ARGS__))
+#define SONIC_FE_22(m, x, ...) m(x), SONIC_EXPAND(SONIC_FE_21(m, __VA_ARGS__))
+#define SONIC_FE_23(m, x, ...) m(x), SONIC_EXPAND(SONIC_FE_22(m, __VA_ARGS__))
+#define SONIC_FE_24(m, x, ...) m(x), SONIC_EXPAND(SONIC_FE_23(m, __VA_ARGS__))
+#define SONIC_FE_25(m, x, ...) m(x), SONIC_EXPAND(SONIC_FE_24(m, __VA_ARGS__))
+#define SONIC_FE_26(m, x, ...) m(x), SONIC_EXPAND(SONIC_FE_25(m, __VA_ARGS__))
+#define SONIC_FE_27(m, x, ...) m(x), SONIC_EXPAND(SONIC_FE_26(m, __VA_ARGS__))
+#define SONIC_FE_28(m, x, ...) m(x), SONIC_EXPAND(SONIC_FE_27(m, __VA_ARGS__))
+#define SONIC_FE_29(m, x, ...) m(x), SONIC_EXPAND(SONIC_FE_28(m, __VA_ARGS__))
+#define SONIC_FE_30(m, x, ...) m(x), SONIC_EXPAND(SONIC_FE_29(m, __VA_ARGS__))
+#define SONIC_FE_31(m, x, ...) m(x), SONIC_EXPAND(SONIC_FE_30(m, __VA_ARGS__))
+#define SONIC_FE_32(m, x, ...) m(x), SONIC_EXPAND(SONIC_FE_31(m, __VA_ARGS__))
+#define SONIC_FE_N(_1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, _13,   \
+                   _14, _15, _16, _17, _18, _19, _20, _21, _22, _23, _24, \
+                   _25, _26, _27, _28, _29, _30, _31, _32, N, ...)        \
+  SONIC_FE_##N
+#define SONIC_FOR_EACH(m, ...)                                             \
+  SONIC_EXPAND(SONIC_FE_N(__VA_ARGS__, 32, 31, 30, 29, 28, 27, 26, 25, 24, \
+                          23, 22, 21, 20, 19, 18, 17, 16, 15, 14, 13, 12,  \
+                          11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1)(m, __VA_ARGS__))
+
+#define SONIC_STRUCT_FIELD(f) \
+  ::sonic_json::internal::MakeStructField(#f, &SonicStructSelf::f)
+
+/**
+ * @brief Register the members of a struct for ParseStruct, up to 32 members.
+ * The JSON keys are the member names. It must be used in the namespace of
+ * the struct, and only the public members can be registered.
+ *
+ *   struct User { int64_t id; std::string name; };
+ *   SONIC_DEFINE_FIELDS(User, id, name)
+ */
+#define SONIC_DEFINE_FIELDS(Type, ...)                                \
+  constexpr auto SonicStructFields(const Type *) {                    \
+    using SonicStructSelf = Type;                                     \
+    return std::make_tuple(                                           \
+        SONIC_FOR_EACH(SONIC_STRUCT_FIELD, __VA_ARGS__));             \
+  }
+
+namespace internal {
+
+// The registered fields are found by ADL on the struct type, this overload
+// only makes the name visible.
+void SonicStructFields() = delete;
+
+template <typename T, typename = void>
+struct IsStruct : std::false_type {};
+
+template <typename T>
+struct IsStruct<T, decltype((void)SonicStructFields(
+                                static_cast<const T *>(nullptr)))>
+    : std::true_type {};
+
+template <typename T>
+struct StructFieldsOf {
+  static constexpr auto kFields =
+      SonicStructFields(static_cast<const T *>(nullptr));
+  static constexpr size_t kSize =
+      std::tuple_size<std::remove_const_t<decltype(kFields)>>::value;
+
+  template <size_t I>
+  using MemberType = typename std::tuple_element_t<
+      I, std::remove_const_t<decltype(kFields)>>::MemberType;
+
+  template <size_t... I>
+  static constexpr std::array<StringView, kSize> names(
+      std::index_sequence<I...>) {
+    return {{std::get<I>(kFields).name...}};
+  }
+
+  static constexpr std::array<StringView, kSize> kNames =
+      names(std::make_index_sequence<kSize>());
+};
+
+template <typename T>
+struct IsOptional : std::false_type {};
+
+template <typename T>
+struct IsOptional<std::optional<T>> : std::true_type {};
+
+template <typename T>
+struct IsVector : std::false_type {};
+
+template <typename T, typename A>
+struct IsVector<std::vector<T, A>> : std::true_type {};
+
+// the maps with std::string keys are JSON objects
+template <typename T>
+struct IsMap : std::false_type {};
+
+template <typename V, typename C, typename A>
+struct IsMap<std::map<std::string, V, C, A>> : std::true_type {};
+
+}  // namespace internal
+}  // namespace sonic_json
@@ -0,0 +1,518 @@
+/*
+ * Copyright 2022 ByteDance Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <map>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "sonic/allocator.h"
+#include "sonic/dom/flags.h"
+#include "sonic/dom/parser.h"
+#include "sonic/dom/struct_fields.h"
+#include "sonic/error.h"
+#include "sonic/string_view.h"
+
+namespace sonic_json {
+
+namespace internal {
+
+// IsStructValue checks the type can be parsed by ParseStruct: bool,
+// integers, floating points, std::string, std::optional, std::vector and
+// std::map of them, and the registered structs.
+template <typename T, typename = void>
+struct IsStructValue : std::false_type {};
+
+template <typename T>
+struct IsStructValue<T, std::enable_if_t<std::is_arithmetic<T>::value ||
+                                         std::is_same<T, std::string>::value ||
+                                         IsStruct<T>::value>>
+    : std::true_type {};
+
+template <typename T>
+struct IsStructValue<std::optional<T>> : IsStructValue<T> {};
+
+template <typename T, typename A>
+struct IsStructValue<std::vector<T, A>> : IsStructValue<T> {};
+
+template <typename V, typename C, typename A>
+struct IsStructValue<std::map<std::string, V, C, A>> : IsStructValue<V> {};
+
+// the elements of std::vector<bool> are not addressable
+template <typename A>
+struct IsStructValue<std::vector<bool, A>> : std::false_type {};
+
+struct StructSinkOps;
+
+// StructSink is the destination of a JSON value.
+struct StructSink {
+  void *ptr;
+  const StructSinkOps *ops;
+};
+
+// StructSinkOps writes the JSON values into a C++ type. The functions return
+// false if the JSON type is not matched.
+struct StructSinkOps {
+  bool (*null)(void *);
+  bool (*boolean)(void *, bool);
+  bool (*uint)(void *, uint64_t);
+  bool (*sint)(void *, int64_t);
+  bool (*real)(void *, double);
+  bool (*string)(void *, StringView);
+  // Start a container, and get the sink of it.
+  bool (*object)(void *, StructSink &);
+  bool (*array)(void *, StructSink &);
+  // Get the sink of the member by key. The key is searched from the `hint`
+  // field, since the keys are mostly in the declared order.
+  bool (*key)(void *, StringView, uint32_t &, StructSink &);
+  // Append an element, and get the sink of it.
+  StructSink (*element)(void *);
+};
+
+template <typename T>
+struct StructSinkOf;
+
+template <typename T>
+struct StructKeys {
+  using Fields = StructFieldsOf<T>;
+  constexpr static uint32_t kSize = Fields::kSize;
+
+  template <size_t I>
+  static StructSink bind(void *p) {
+    using M = typename Fields::template MemberType<I>;
+    static_assert(IsStructValue<M>::value,
+                  "the type of struct member is not supported");
+    return StructSink{&(static_cast<T *>(p)->*std::get<I>(Fields::kFields).ptr),
+                      &StructSinkOf<M>::kOps};
+  }
+
+  template <size_t... I>
+  static constexpr std::array<StructSink (*)(void *), kSize> binders(
+      std::index_sequence<I...>) {
+    return {{&bind<I>...}};
+  }
+
+  static bool Key(void *p, StringView key, uint32_t &hint, StructSink &out) {
+    constexpr static std::array<StructSink (*)(void *), kSize> kBind =
+        binders(std::make_index_sequence<kSize>());
+    uint32_t i = hint < kSize ? hint : 0;
+    for (uint32_t n = 0; n < kSize; n++) {
+      const StringView &name = Fields::kNames[i];
+      uint32_t next = i + 1 == kSize ? 0 : i + 1;
+      if (name.size() == key.size() &&
+          std::memcmp(name.data(), key.data(), key.size()) == 0) {
+        out = kBind[i](p);
+        hint = next;
+        return true;
+      }
+      i = next;
+    }
+    return false;
+  }
+};
+
+template <typename T>
+struct StructSinkOf {
+  using Opt = IsOptional<T>;
+
+  template <typename U>
+  using Inner = StructSinkOf<typename U::value_type>;
+
+  static bool Null(void *p) {
+    if constexpr (Opt::value) {
+      static_cast<T *>(p)->reset();
+      return true;
+    } else {
+      return false;
+    }
+  }
+
+  static bool Bool(void *p, bool v) {
+    T &t = *static_cast<T *>(p);
+    if constexpr (std::is_same<T, bool>::value) {
+      t = v;
+      return true;
+    } else if constexpr (Opt::value) {
+      return Inner<T>::Bool(&t.emplace(), v);
+    } else {
+      return false;
+    }
+  }
+
+  static bool Uint(void *p, uint64_t v) {
+    T &t = *static_cast<T *>(p);
+    if constexpr (std::is_same<T, bool>::value) {
+      return false;
+    } else if constexpr (std::is_integral<T>::value) {
+      if (v > static_cast<uint64_t>(std::numeric_limits<T>::max())) {
+        return false;
+      }
+      t = static_cast<T>(v);
+      return true;
+    } else if constexpr (std::is_floating_point<T>::value) {
+      t = static_cast<T>(v);
+      return true;
+    } else if constexpr (Opt::value) {
+      return Inner<T>::Uint(&t.emplace(), v);
+    } else {
+      return false;
+    }
+  }
+
+  static bool Int(void *p, int64_t v) {
+    T &t = *static_cast<T *>(p);
+    if constexpr (std::is_same<T, bool>::value) {
+      return false;
+    } else if constexpr (std::is_integral<T>::value &&
+                         std::is_signed<T>::value) {
+      if (v < static_cast<int64_t>(std::numeric_limits<T>::min()) ||
+          v > static_cast<int64_t>(std::numeric_limits<T>::max())) {
+        return false;
+      }
+      t = static_cast<T>(v);
+      return true;
+    } else if constexpr (std::is_integral<T>::value) {
+      if (v < 0) return false;
+      return Uint(p, static_cast<uint64_t>(v));
+    } else if constexpr (std::is_floating_point<T>::value) {
+      t = static_cast<T>(v);
+      return true;
+    } else if constexpr (Opt::value) {
+      return Inner<T>::Int(&t.emplace(), v);
+    } else {
+      return false;
+    }
+  }
+
+  static bool Double(void *p, double v) {
+    T &t = *static_cast<T *>(p);
+    if constexpr (std::is_floating_point<T>::value) {
+      t = static_cast<T>(v);
+      return true;
+    } else if constexpr (Opt::value) {
+      return Inner<T>::Double(&t.emplace(), v);
+    } else {
+      return false;
+    }
+  }
+
+  static bool String(void *p, StringView s) {
+    T &t = *static_cast<T *>(p);
+    if constexpr (std::is_same<T, std::string>::value) {
+      t.assign(s.data(), s.size());
+      return true;
+    } else if constexpr (Opt::value) {
+      return Inner<T>::String(&t.emplace(), s);
+    } else {
+      return false;
+    }
+  }
+
+  // The struct members not in JSON are kept, and the maps are cleared.
+  static bool Object(void *p, StructSink &out) {
+    T &t = *static_cast<T *>(p);
+    if constexpr (IsStruct<T>::value) {
+      out = StructSink{p, &kOps};
+      return true;
+    } else if constexpr (IsMap<T>::value) {
+      t.clear();
+      out = StructSink{p, &kOps};
+      return true;
+    } else if constexpr (Opt::value) {
+      return Inner<T>::Object(&t.emplace(), out);
+    } else {
+      return false;
+    }
+  }
+
+  // The elements in the vector are cleared.
+  static bool Array(void *p, StructSink &out) {
+    T &t = *static_cast<T *>(p);
+    if constexpr (IsVector<T>::value) {
+      t.clear();
+      out = StructSink{p, &kOps};
+      return true;
+    } else if constexpr (Opt::value) {
+      return Inner<T>::Array(&t.emplace(), out);
+    } else {
+      return false;
+    }
+  }
+
+  static StructSink Element(void *p) {
+    if constexpr (IsVector<T>::value) {
+      T &t = *static_cast<T *>(p);
+      t.emplace_back();
+      return StructSink{&t.back(), &Inner<T>::kOps};
+    } else {
+      return StructSink{p, nullptr};
+    }
+  }
+
+  static bool Key(void *p, StringView key, uint32_t &hint, StructSink &out) {
+    if constexpr (IsStruct<T>::value) {
+      return StructKeys<T>::Key(p, key, hint, out);
+    } else if constexpr (IsMap<T>::value) {
+      // the last value of the duplicated keys is kept
+      T &t = *static_cast<T *>(p);
+      auto &v = t[std::string(key.data(), key.size())];
+      out = StructSink{&v, &StructSinkOf<typename T::mapped_type>::kOps};
+      return true;
+    } else {
+      return false;
+    }
+  }
+
+  constexpr static StructSinkOps kOps = {
+      &Null,   &Bool,  &Uint, &Int, &Double, &String,
+      &Object, &Array, &Key,  &Element,
+  };
+};
+
+}  // namespace internal
+
+/**
+ * @brief StructHandler is the SAX handler that writes the values into a C++
+ * value directly, without building the DOM. The unknown keys are skipped by
+ * the parser. A JSON value that doesn't match the C++ type stops the parsing
+ * with kParseErrorMismatchType.
+ */
+class StructHandler {
+ public:
+  using Allocator = SimpleAllocator;
+
+  bool oom_{false};
+
+  StructHandler() = default;
+  StructHandler(const StructHandler &) = delete;
+  StructHandler &operator=(const StructHandler &) = delete;
+
+  template <typename T>
+  sonic_force_inline void SetUp(T &root) {
+    static_assert(internal::IsStructValue<T>::value,
+                  "the type is not supported by ParseStruct");
+    st_.clear();
+    root_ = internal::StructSink{&root, &internal::StructSinkOf<T>::kOps};
+    err_ = kErrorNone;
+  }
+
+  sonic_force_inline bool Null() {
+    internal::StructSink s = next();
+    return check(s.ops->null(s.ptr));
+  }
+
+  sonic_force_inline bool Bool(bool val) {
+    internal::StructSink s = next();
+    return check(s.ops->boolean(s.ptr, val));
+  }
+
+  sonic_force_inline bool Uint(uint64_t val) {
+    internal::StructSink s = next();
+    return check(s.ops->uint(s.ptr, val));
+  }
+
+  sonic_force_inline bool Int(int64_t val) {
+    internal::StructSink s = next();
+    return check(s.ops->sint(s.ptr, val));
+  }
+
+  sonic_force_inline bool Double(double val) {
+    internal::StructSink s = next();
+    return check(s.ops->real(s.ptr, val));
+  }
+
+  // The raw and string numbers are not supported.
+  sonic_force_inline bool Raw(const char *, size_t) { return check(false); }
+
+  sonic_force_inline bool NumStr(StringView) { return check(false); }
+
+  sonic_force_inline bool String(StringView s) {
+    internal::StructSink sink = next();
+    return check(sink.ops->string(sink.ptr, s));
+  }
+
+  // Returns false for the unknown keys, so their values are skipped.
+  sonic_force_inline bool Key(StringView s) {
+    Frame &f = st_.back();
+    return f.sink.ops->key(f.sink.ptr, s, f.hint, pending_);
+  }
+
+  // Used when parsing borrowed input, the allocated strings are freed once
+  // accepted.
+  sonic_force_inline bool Key(StringView s, bool allocated) {
+    bool found = Key(s);
+    if (found && allocated) Allocator::Free((void *)(s.data()));
+    return found;
+  }
+
+  sonic_force_inline bool String(StringView s, bool allocated) {
+    bool ok = String(s);
+    if (ok && allocated) Allocator::Free((void *)(s.data()));
+    return ok;
+  }
+
+  sonic_force_inline bool StartObject() {
+    internal::StructSink s = next();
+    Frame f{};
+    if (!s.ops->object(s.ptr, f.sink)) return check(false);
+    st_.push_back(f);
+    return true;
+  }
+
+  sonic_force_inline bool StartArray() {
+    internal::StructSink s = next();
+    Frame f{};
+    if (!s.ops->array(s.ptr, f.sink)) return check(false);
+    f.array = true;
+    st_.push_back(f);
+    return true;
+  }
+
+  sonic_force_inline bool EndObject(uint32_t) {
+    st_.pop_back();
+    return true;
+  }
+
+  sonic_force_inline bool EndArray(uint32_t) {
+    st_.pop_back();
+    return true;
+  }
+
+  static constexpr bool check_key_return = true;
+
+  sonic_force_inline Allocator &GetAllocator() { return alloc_; }
+
+  /**
+   * @brief The error of the handler, kParseErrorMismatchType or kErrorNone.
+   */
+  sonic_force_inline SonicError Error() const { return err_; }
+
+ private:
+  struct Frame {
+    internal::StructSink sink;
+    uint32_t hint;
+    bool array;
+  };
+
+  // The sink of the next value: the root, a new element of the array, or
+  // the member found by the last key.
+  sonic_force_inline internal::StructSink next() {
+    if (sonic_unlikely(st_.empty())) return root_;
+    Frame &f = st_.back();
+    if (f.array) return f.sink.ops->element(f.sink.ptr);
+    return pending_;
+  }
+
+  sonic_force_inline bool check(bool ok) {
+    if (sonic_unlikely(!ok)) err_ = kParseErrorMismatchType;
+    return ok;
+  }
+
+  std::vector<Frame> st_{};
+  internal::StructSink root_{};
+  internal::StructSink pending_{};
+  SonicError err_{kErrorNone};
+  Allocator alloc_{};
+};
+
+/**
+ * @brief StructParser parses JSON into the C++ values registered by
+ * SONIC_DEFINE_FIELDS. The input buffer and the handler stack are kept for
+ * the next parsing.
+ */
+class StructParser {
+ public:
+  StructParser() = default;
+  StructParser(const StructParser &) = delete;
+  StructParser &operator=(const StructParser &) = delete;
+  ~StructParser() { std::free(str_); }
+
+  /**
+   * @brief Parse json into `out`.
+   * @param parseFlags combination of different ParseFlag.
+   * @param json json string
+   * @param out the destination, the struct members not in json are kept,
+   * and the vectors are cleared before appending.
+   * @return the error and offset. The error is kParseErrorMismatchType if a
+   * json value doesn't match the C++ type, `out` may be partially written.
+   * @note With ParseFlags::kParseBorrowInput, `json` is not copied, and it
+   * must be followed by SONICJSON_PADDING readable bytes.
+   */
+  template <ParseFlags parseFlags = ParseFlags::kParseDefault, typename T>
+  ParseResult Parse(StringView json, T &out) {
+    return Parse<parseFlags>(json.data(), json.size(), out);
+  }
+
+  template <ParseFlags parseFlags = ParseFlags::kParseDefault, typename T>
+  ParseResult Parse(const char *data, size_t len, T &out) {
+    Parser<parseFlags> p;
+    ParseResult ret;
+    sax_.SetUp(out);
+    if constexpr (parseFlags & ParseFlags::kParseBorrowInput) {
+      // the parser never writes the borrowed input
+      ret = p.Parse(const_cast<char *>(data), len, sax_);
+    } else {
+      SonicError err = allocateStringBuffer(data, len);
+      if (sonic_unlikely(err != kErrorNone)) return err;
+      ret = p.Parse(str_, len, sax_);
+    }
+    if (sonic_unlikely(sax_.Error() != kErrorNone)) {
+      return ParseResult(sax_.Error(), ret.Offset());
+    }
+    return ret;
+  }
+
+ private:
+  SonicError allocateStringBuffer(const char *json, size_t len) {
+    size_t pad_len = len + 64;
+    if (str_cap_ < pad_len) {
+      std::free(str_);
+      str_ = static_cast<char *>(std::malloc(pad_len));
+      str_cap_ = str_ ? pad_len : 0;
+    }
+    if (str_ == nullptr) return kErrorNoMem;
+    std::memcpy(str_, json, len);
+    // Add ending mask to support parsing invalid json
+    str_[len] = 'x';
+    str_[len + 1] = '"';
+    str_[len + 2] = 'x';
+    return kErrorNone;
+  }
+
+  char *str_{nullptr};
+  size_t str_cap_{0};
+  StructHandler sax_{};
+};
+
+/**
+ * @brief Parse json into a registered struct, without building the DOM.
+ * @see StructParser::Parse
+ */
+template <ParseFlags parseFlags = ParseFlags::kParseDefault, typename T>
+ParseResult ParseStruct(StringView json, T &out) {
+  StructParser p;
+  return p.Parse<parseFlags>(json, out);
+}
+
+}  // namespace sonic_json
@@ -0,0 +1,198 @@
+/*
+ * Copyright 2022 ByteDance Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+#include "sonic/dom/flags.h"
+#include "sonic/dom/serialize.h"
+#include "sonic/dom/struct_fields.h"
+#include "sonic/error.h"
+#include "sonic/internal/arch/simd_quote.h"
+#include "sonic/internal/ftoa.h"
+#include "sonic/internal/itoa.h"
+#include "sonic/string_view.h"
+#include "sonic/writebuffer.h"
+
+namespace sonic_json {
+
+namespace internal {
+
+// StructKey is the quoted key of a struct member with the colon, made at
+// compile time. The member names need no escaping.
+template <typename T, size_t I>
+struct StructKey {
+  constexpr static StringView kName = StructFieldsOf<T>::kNames[I];
+  constexpr static size_t kSize = kName.size() + 3;
+
+  static constexpr std::array<char, kSize> make() {
+    std::array<char, kSize> key{};
+    key[0] = '"';
+    for (size_t i = 0; i < kName.size(); i++) key[i + 1] = kName[i];
+    key[kSize - 2] = '"';
+    key[kSize - 1] = ':';
+    return key;
+  }
+
+  constexpr static std::array<char, kSize> kKey = make();
+};
+
+// StructWriter writes every value with a trailing comma, and the comma is
+// replaced when the container ends, as SerializeImpl.
+template <SerializeFlags serializeFlags>
+struct StructWriter {
+  constexpr static size_t kNumberSize = 33;
+
+  static sonic_force_inline void writeString(const char *s, size_t n,
+                                             WriteBuffer &wb) {
+    wb.Grow(n * 6 + 32 + 3);
+    char *end = wb.End<char>();
+    size_t rn = internal::Quote<serializeFlags>(s, n, end) - end;
+    wb.PushSizeUnsafe<char>(rn);
+  }
+
+  static sonic_force_inline void endContainer(char c, WriteBuffer &wb) {
+    char *top = wb.Top<char>();
+    if (*top == ',') {
+      *top = c;
+    } else {
+      wb.Push<char>(c);
+    }
+    wb.Push<char>(',');
+  }
+
+  template <typename T>
+  static sonic_force_inline SonicError Write(const T &v, WriteBuffer &wb) {
+    if constexpr (std::is_same<T, bool>::value) {
+      wb.Push5_8(v ? "true,   " : "false,  ", 5 + !v);
+    } else if constexpr (std::is_integral<T>::value) {
+      wb.Grow(kNumberSize);
+      char *end = wb.End<char>();
+      size_t rn;
+      if constexpr (std::is_signed<T>::value) {
+        rn = internal::I64toa(end, static_cast<int64_t>(v)) - end;
+      } else {
+        rn = internal::U64toa(end, static_cast<uint64_t>(v)) - end;
+      }
+      wb.PushSizeUnsafe<char>(rn);
+      wb.PushUnsafe<char>(',');
+    } else if constexpr (std::is_floating_point<T>::value) {
+      wb.Grow(kNumberSize);
+      const double d = static_cast<double>(v);
+      ssize_t rn = internal::F64toa<serializeFlags>(wb.End<char>(), d);
+      if (sonic_unlikely(rn <= 0)) {
+        rn = SerializeInfNan<serializeFlags>(wb.End<char>(), d);
+        if (rn <= 0) return kSerErrorInfinity;
+      }
+      wb.PushSizeUnsafe<char>(rn);
+      wb.PushUnsafe<char>(',');
+    } else if constexpr (std::is_same<T, std::string>::value) {
+      writeString(v.data(), v.size(), wb);
+      wb.PushUnsafe<char>(',');
+    } else if constexpr (IsOptional<T>::value) {
+      if (!v.has_value()) {
+        wb.Push5_8("null,   ", 5);
+        return kErrorNone;
+      }
+      return Write(*v, wb);
+    } else if constexpr (IsVector<T>::value) {
+      wb.Push<char>('[');
+      for (const auto &e : v) {
+        SonicError err = Write(e, wb);
+        if (sonic_unlikely(err != kErrorNone)) return err;
+      }
+      endContainer(']', wb);
+    } else if constexpr (IsMap<T>::value) {
+      wb.Push<char>('{');
+      for (const auto &m : v) {
+        writeString(m.first.data(), m.first.size(), wb);
+        wb.PushUnsafe<char>(':');
+        SonicError err = Write(m.second, wb);
+        if (sonic_unlikely(err != kErrorNone)) return err;
+      }
+      endContainer('}', wb);
+    } else if constexpr (IsStruct<T>::value) {
+      wb.Push<char>('{');
+      SonicError err = writeFields(
+          v, wb, std::make_index_sequence<StructFieldsOf<T>::kSize>());
+      if (sonic_unlikely(err != kErrorNone)) return err;
+      endContainer('}', wb);
+    } else {
+      static_assert(IsStruct<T>::value,
+                    "the type is not supported by SerializeStruct");
+    }
+    return kErrorNone;
+  }
+
+  // The empty std::optional members are omitted.
+  template <typename T, size_t I>
+  static sonic_force_inline SonicError writeField(const T &v,
+                                                  WriteBuffer &wb) {
+    const auto &m = v.*(std::get<I>(StructFieldsOf<T>::kFields).ptr);
+    if constexpr (IsOptional<std::decay_t<decltype(m)>>::value) {
+      if (!m.has_value()) return kErrorNone;
+    }
+    using Key = StructKey<T, I>;
+    wb.Push(Key::kKey.data(), Key::kSize);
+    return Write(m, wb);
+  }
+
+  template <typename T, size_t... I>
+  static sonic_force_inline SonicError writeFields(const T &v, WriteBuffer &wb,
+                                                   std::index_sequence<I...>) {
+    SonicError err = kErrorNone;
+    (void)((err = writeField<T, I>(v, wb), err == kErrorNone) && ...);
+    return err;
+  }
+};
+
+}  // namespace internal
+
+/**
+ * @brief Serialize a registered struct into the buffer directly, without
+ * building a Document. The structs registered by SONIC_DEFINE_FIELDS are
+ * objects, std::vector is array, std::map with std::string keys is object,
+ * and the empty std::optional is null. The empty std::optional members of a
+ * struct are omitted.
+ * @param serializeFlags combination of different SerializeFlags.
+ * @param v the value to serialize
+ * @param wb the output buffer, cleared unless kSerializeAppendBuffer is set
+ * @return kErrorNone or kSerErrorInfinity
+ */
+template <SerializeFlags serializeFlags = SerializeFlags::kSerializeDefault,
+          typename T>
+SonicError SerializeStruct(const T &v, WriteBuffer &wb) {
+  if constexpr ((serializeFlags & SerializeFlags::kSerializeAppendBuffer) ==
+                0) {
+    wb.Clear();
+  }
+  size_t start = wb.Size();
+  SonicError err = internal::StructWriter<serializeFlags>::Write(v, wb);
+  if (sonic_unlikely(err != kErrorNone)) {
+    wb.Pop<char>(wb.Size() - start);
+    return err;
+  }
+  // the trailing comma
+  wb.Pop<char>(1);
+  return kErrorNone;
+}
+
+}  // namespace sonic_json
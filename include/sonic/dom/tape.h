@@ -0,0 +1,793 @@
+/*
+ * Copyright 2022 ByteDance Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <string>
+#include <utility>
+
+#include "sonic/dom/flags.h"
+#include "sonic/dom/json_pointer.h"
+#include "sonic/dom/parser.h"
+#include "sonic/dom/serialize.h"
+#include "sonic/dom/type.h"
+#include "sonic/error.h"
+#include "sonic/string_view.h"
+#include "sonic/writebuffer.h"
+
+namespace sonic_json {
+
+namespace internal {
+
+// The tape is a flat array of 8-byte words. The high 8 bits of a word is the
+// type, and the low 56 bits is the payload:
+//   null, true, false: one word.
+//   uint, sint, real: the type word, and the number in the next word.
+//   string, key, raw, number string: the type word with the offset in the
+//     string arena, and the length in the next word.
+//   object, array: the start word with the saturated member count in bits
+//     32..55 and the distance to the word after the end word in bits 0..31,
+//     then the children, then the end word with the distance to the start.
+// The value types are the same as TypeFlag, and keys and end words set the
+// sixth bit, so that GetType() is also `type & kSubTypeMask`.
+enum TapeType : uint8_t {
+  kTapeKey = kString | (1 << 5),
+  kTapeObjectEnd = kObject | (1 << 5),
+  kTapeArrayEnd = kArray | (1 << 5),
+};
+
+constexpr static int kTapeTypeShift = 56;
+constexpr static uint64_t kTapePayloadMask = (uint64_t(1) << 56) - 1;
+constexpr static uint64_t kTapeMaxCount = (uint64_t(1) << 24) - 1;
+constexpr static uint64_t kTapeMaxSkip = UINT32_MAX;
+
+sonic_force_inline uint64_t TapeWord(uint8_t type, uint64_t payload) {
+  return (uint64_t(type) << kTapeTypeShift) | payload;
+}
+
+}  // namespace internal
+
+class TapeDocument;
+class TapeNode;
+class TapeValueIterator;
+class TapeMemberIterator;
+
+/**
+ * @brief TapeHandler is the SAX handler that builds a tape. The containers
+ * are written in place and patched when they end, so there is no memory
+ * allocation per container. The strings are unescaped in place, and the
+ * parsed buffer is the string arena of the tape.
+ */
+class TapeHandler {
+ public:
+  bool oom_{false};
+
+  TapeHandler() = default;
+  TapeHandler(const TapeHandler &) = delete;
+  TapeHandler &operator=(const TapeHandler &) = delete;
+  TapeHandler(TapeHandler &&rhs) noexcept { swap(rhs); }
+  TapeHandler &operator=(TapeHandler &&rhs) noexcept {
+    swap(rhs);
+    return *this;
+  }
+  ~TapeHandler() { std::free(tape_); }
+
+  sonic_force_inline bool SetUp(const char *arena, size_t len) {
+    // most JSON texts need fewer words than an eighth of their bytes
+    size_t cap = len / 8 + 16;
+    if (!tape_ || cap_ < cap) {
+      if (!reserve(cap)) return false;
+    }
+    arena_ = arena;
+    np_ = 0;
+    parent_ = 0;
+    oom_ = false;
+    return true;
+  }
+
+  sonic_force_inline bool Null() { return push(internal::TapeWord(kNull, 0)); }
+
+  sonic_force_inline bool Bool(bool val) {
+    return push(internal::TapeWord(val ? kTrue : kFalse, 0));
+  }
+
+  sonic_force_inline bool Uint(uint64_t val) {
+    return push2(internal::TapeWord(kUint, 0), val);
+  }
+
+  sonic_force_inline bool Int(int64_t val) {
+    return push2(internal::TapeWord(kSint, 0), static_cast<uint64_t>(val));
+  }
+
+  sonic_force_inline bool Double(double val) {
+    uint64_t bits;
+    std::memcpy(&bits, &val, sizeof(bits));
+    return push2(internal::TapeWord(kReal, 0), bits);
+  }
+
+  sonic_force_inline bool Key(StringView s) {
+    return stringImpl(s.data(), s.size(), internal::kTapeKey);
+  }
+
+  sonic_force_inline bool String(StringView s) {
+    return stringImpl(s.data(), s.size(), kStringCopy);
+  }
+
+  sonic_force_inline bool NumStr(StringView s) {
+    return stringImpl(s.data(), s.size(), kNumStr);
+  }
+
+  sonic_force_inline bool Raw(const char *data, size_t len) {
+    return stringImpl(data, len, kRaw);
+  }
+
+  // The start word links to the parent container until the container ends.
+  sonic_force_inline bool StartObject() {
+    if (!push(internal::TapeWord(kObject, parent_))) return false;
+    parent_ = np_ - 1;
+    return true;
+  }
+
+  sonic_force_inline bool StartArray() {
+    if (!push(internal::TapeWord(kArray, parent_))) return false;
+    parent_ = np_ - 1;
+    return true;
+  }
+
+  sonic_force_inline bool EndObject(uint32_t pairs) {
+    return endImpl(kObject, internal::kTapeObjectEnd, pairs);
+  }
+
+  sonic_force_inline bool EndArray(uint32_t count) {
+    return endImpl(kArray, internal::kTapeArrayEnd, count);
+  }
+
+ private:
+  friend class TapeDocument;
+
+  void swap(TapeHandler &rhs) noexcept {
+    std::swap(oom_, rhs.oom_);
+    std::swap(tape_, rhs.tape_);
+    std::swap(np_, rhs.np_);
+    std::swap(cap_, rhs.cap_);
+    std::swap(parent_, rhs.parent_);
+    std::swap(arena_, rhs.arena_);
+  }
+
+  bool reserve(size_t cap) {
+    uint64_t *tape =
+        static_cast<uint64_t *>(std::realloc(tape_, sizeof(uint64_t) * cap));
+    if (!tape) return false;
+    tape_ = tape;
+    cap_ = cap;
+    return true;
+  }
+
+  sonic_force_inline bool room(size_t n) {
+    if (sonic_likely(np_ + n <= cap_)) return true;
+    if (reserve(cap_ * 2 + n)) return true;
+    oom_ = true;
+    return false;
+  }
+
+  sonic_force_inline bool push(uint64_t w) {
+    if (!room(1)) return false;
+    tape_[np_++] = w;
+    return true;
+  }
+
+  sonic_force_inline bool push2(uint64_t w0, uint64_t w1) {
+    if (!room(2)) return false;
+    tape_[np_] = w0;
+    tape_[np_ + 1] = w1;
+    np_ += 2;
+    return true;
+  }
+
+  // The strings are unescaped in place, so only the offset is kept.
+  sonic_force_inline bool stringImpl(const char *data, size_t len,
+                                     uint8_t type) {
+    return push2(internal::TapeWord(type, data - arena_), len);
+  }
+
+  sonic_force_inline bool endImpl(uint8_t type, uint8_t end_type,
+                                  uint32_t count) {
+    size_t start = parent_;
+    size_t skip = np_ + 1 - start;
+    if (sonic_unlikely(skip > internal::kTapeMaxSkip)) {
+      oom_ = true;
+      return false;
+    }
+    if (!push(internal::TapeWord(end_type, skip))) return false;
+    parent_ = tape_[start] & internal::kTapePayloadMask;
+    uint64_t cnt = count < internal::kTapeMaxCount ? count
+                                                   : internal::kTapeMaxCount;
+    tape_[start] = internal::TapeWord(type, (cnt << 32) | skip);
+    return true;
+  }
+
+  uint64_t *tape_{nullptr};
+  size_t np_{0};
+  size_t cap_{0};
+  size_t parent_{0};
+  const char *arena_{nullptr};
+};
+
+/**
+ * @brief TapeNode is a read-only handle of a value in the TapeDocument. It is
+ * only valid while the document is alive and not parsed again. A missing
+ * value, e.g. the result of FindMember with a not exist key, is an invalid
+ * node that behaves like null.
+ */
+class TapeNode {
+ public:
+  TapeNode() = default;
+
+  /**
+   * @brief Check this node refers to an existing value.
+   */
+  sonic_force_inline bool IsValid() const noexcept { return w_ != &kMissing; }
+
+  sonic_force_inline TypeFlag GetType() const noexcept {
+    return static_cast<TypeFlag>(type() & kSubTypeMask);
+  }
+
+  sonic_force_inline bool IsNull() const noexcept {
+    return basicType() == kNull;
+  }
+  sonic_force_inline bool IsBool() const noexcept {
+    return basicType() == kBool;
+  }
+  sonic_force_inline bool IsString() const noexcept {
+    return basicType() == kString;
+  }
+  sonic_force_inline bool IsRaw() const noexcept { return basicType() == kRaw; }
+  sonic_force_inline bool IsNumber() const noexcept {
+    return basicType() == kNumber;
+  }
+  sonic_force_inline bool IsArray() const noexcept {
+    return basicType() == kArray;
+  }
+  sonic_force_inline bool IsObject() const noexcept {
+    return basicType() == kObject;
+  }
+  sonic_force_inline bool IsTrue() const noexcept { return GetType() == kTrue; }
+  sonic_force_inline bool IsFalse() const noexcept {
+    return GetType() == kFalse;
+  }
+  sonic_force_inline bool IsDouble() const noexcept {
+    return GetType() == kReal;
+  }
+  sonic_force_inline bool IsStringNumber() const noexcept {
+    return GetType() == kNumStr;
+  }
+  sonic_force_inline bool IsInt64() const noexcept {
+    return GetType() == kSint ||
+           (GetType() == kUint && w_[1] <= uint64_t(INT64_MAX));
+  }
+  sonic_force_inline bool IsUint64() const noexcept {
+    return GetType() == kUint;
+  }
+  sonic_force_inline bool IsContainer() const noexcept {
+    return (type() & kContainerMask) == kContainerMask;
+  }
+
+  sonic_force_inline bool GetBool() const noexcept {
+    sonic_assert(IsBool());
+    return GetType() == kTrue;
+  }
+  sonic_force_inline int64_t GetInt64() const noexcept {
+    sonic_assert(IsInt64());
+    return static_cast<int64_t>(w_[1]);
+  }
+  sonic_force_inline uint64_t GetUint64() const noexcept {
+    sonic_assert(IsUint64());
+    return w_[1];
+  }
+  sonic_force_inline double GetDouble() const noexcept {
+    sonic_assert(IsNumber() && !IsStringNumber());
+    if (IsUint64()) return static_cast<double>(w_[1]);
+    if (GetType() == kSint) return static_cast<double>(GetInt64());
+    double d;
+    std::memcpy(&d, &w_[1], sizeof(d));
+    return d;
+  }
+
+  /**
+   * @brief Get the string view of this node, won't copy the string.
+   */
+  sonic_force_inline StringView GetStringView() const noexcept {
+    sonic_assert(IsString() || IsStringNumber() || IsRaw());
+    return StringView(strs_ + (*w_ & internal::kTapePayloadMask), w_[1]);
+  }
+  sonic_force_inline std::string GetString() const {
+    sonic_assert(IsString() || IsStringNumber());
+    return std::string(GetStringView().data(), GetStringView().size());
+  }
+  sonic_force_inline StringView GetStringNumber() const noexcept {
+    sonic_assert(IsStringNumber());
+    return GetStringView();
+  }
+  sonic_force_inline StringView GetRaw() const noexcept {
+    sonic_assert(IsRaw());
+    return GetStringView();
+  }
+
+  /**
+   * @brief Get the member count of an object, the element count of an array
+   * or the length of a string.
+   * @note the count is stored up to 2^24 - 1, the larger containers are
+   * counted by iteration.
+   */
+  size_t Size() const noexcept;
+
+  sonic_force_inline bool Empty() const noexcept {
+    if (IsContainer()) return skip() == 2;
+    sonic_assert(IsString() || IsStringNumber() || IsRaw());
+    return w_[1] == 0;
+  }
+
+  TapeValueIterator Begin() const noexcept;
+  TapeValueIterator End() const noexcept;
+  TapeMemberIterator MemberBegin() const noexcept;
+  TapeMemberIterator MemberEnd() const noexcept;
+
+  /**
+   * @brief Find a member by key. Return MemberEnd() if not found.
+   */
+  TapeMemberIterator FindMember(StringView key) const noexcept;
+  TapeMemberIterator FindMember(const char *key, size_t len) const noexcept;
+  bool HasMember(StringView key) const noexcept;
+
+  /**
+   * @brief Get the value by key, or an invalid node if not found or this
+   * node is not an object.
+   */
+  TapeNode operator[](StringView key) const noexcept;
+
+  /**
+   * @brief Get the idx-th element of an array, or an invalid node if out of
+   * range or this node is not an array.
+   * @note the elements are visited from the start, it is O(idx). Iterate the
+   * array with Begin() and End() instead.
+   */
+  TapeNode operator[](size_t idx) const noexcept;
+
+  /**
+   * @brief Get the value by json pointer, or an invalid node if not found.
+   */
+  template <typename StringType>
+  TapeNode AtPointer(const GenericJsonPointer<StringType> &pointer) const {
+    TapeNode re = *this;
+    for (auto &node : pointer) {
+      if (node.IsStr()) {
+        if (!re.IsObject()) return TapeNode();
+        re = re[StringView(node.GetStr())];
+      } else {
+        if (!re.IsArray() || node.GetNum() < 0) return TapeNode();
+        re = re[static_cast<size_t>(node.GetNum())];
+      }
+      if (!re.IsValid()) return re;
+    }
+    return re;
+  }
+
+  sonic_force_inline TapeNode AtPointer() const { return *this; }
+
+  template <typename... Args>
+  TapeNode AtPointer(size_t idx, Args... args) const {
+    if (!IsArray()) return TapeNode();
+    TapeNode re = (*this)[idx];
+    return re.IsValid() ? re.AtPointer(args...) : re;
+  }
+
+  template <typename... Args>
+  TapeNode AtPointer(StringView key, Args... args) const {
+    if (!IsObject()) return TapeNode();
+    TapeNode re = (*this)[key];
+    return re.IsValid() ? re.AtPointer(args...) : re;
+  }
+
+  /**
+   * @brief serialize this node as json string.
+   * @param serializeFlags combination of different SerializeFlag.
+   * @param wb write buffer where you want to store json string.
+   * @return SonicError
+   */
+  template <SerializeFlags serializeFlags = SerializeFlags::kSerializeDefault>
+  SonicError Serialize(WriteBuffer &wb) const {
+    using namespace internal;
+    constexpr size_t kNumberSize = 33;
+    if constexpr ((serializeFlags & SerializeFlags::kSerializeAppendBuffer) ==
+                  0) {
+      wb.Clear();
+    }
+    const uint64_t *p = w_;
+    const uint64_t *end = w_ + width();
+    wb.Reserve(wb.Size() + (end - p) * 8 + 64);
+    // Every value is followed by a comma and every key by a colon. The last
+    // comma in a container is replaced by the close bracket.
+    while (p < end) {
+      uint8_t t = static_cast<uint8_t>(*p >> kTapeTypeShift);
+      ssize_t rn = 0;
+      switch (t) {
+        case kNull:
+          wb.Push5_8("null,   ", 5);
+          p++;
+          break;
+        case kTrue:
+          wb.Push5_8("true,   ", 5);
+          p++;
+          break;
+        case kFalse:
+          wb.Push5_8("false,  ", 6);
+          p++;
+          break;
+        case kUint:
+        case kSint:
+        case kReal: {
+          wb.Grow(kNumberSize);
+          if (t == kUint) {
+            rn = U64toa(wb.End<char>(), p[1]) - wb.End<char>();
+          } else if (t == kSint) {
+            rn = I64toa(wb.End<char>(), static_cast<int64_t>(p[1])) -
+                 wb.End<char>();
+          } else {
+            double d;
+            std::memcpy(&d, &p[1], sizeof(d));
+            rn = F64toa<serializeFlags>(wb.End<char>(), d);
+            if (sonic_unlikely(rn <= 0)) {
+              rn = SerializeInfNan<serializeFlags>(wb.End<char>(), d);
+              if (rn <= 0) return kSerErrorInfinity;
+            }
+          }
+          wb.PushSizeUnsafe<char>(rn);
+          wb.PushUnsafe<char>(',');
+          p += 2;
+          break;
+        }
+        case kStringCopy:
+        case kTapeKey: {
+          size_t len = p[1];
+          wb.Grow(len * 6 + 32 + 3);
+          const char *s = strs_ + (*p & kTapePayloadMask);
+          rn = Quote<serializeFlags>(s, len, wb.End<char>()) - wb.End<char>();
+          wb.PushSizeUnsafe<char>(rn);
+          wb.PushUnsafe<char>(t == kTapeKey ? ':' : ',');
+          p += 2;
+          break;
+        }
+        case kNumStr:
+        case kRaw: {
+          size_t len = p[1];
+          wb.Grow(len + 1);
+          wb.PushUnsafe(strs_ + (*p & kTapePayloadMask), len);
+          wb.PushUnsafe<char>(',');
+          p += 2;
+          break;
+        }
+        case kObject:
+        case kArray:
+          wb.Push<char>('[' | (uint8_t)(t == kObject) << 5);
+          p++;
+          break;
+        case kTapeObjectEnd:
+        case kTapeArrayEnd:
+          wb.Grow(2);
+          if (*wb.Top<char>() == ',') wb.Pop<char>(1);
+          wb.PushUnsafe<char>(']' | (uint8_t)(t == kTapeObjectEnd) << 5);
+          wb.PushUnsafe<char>(',');
+          p++;
+          break;
+        default:
+          return kSerErrorUnsupportedType;
+      }
+    }
+    wb.Pop<char>(1);
+    return kErrorNone;
+  }
+
+ protected:
+  friend class TapeValueIterator;
+  friend class TapeMemberIterator;
+
+  TapeNode(const uint64_t *w, const char *strs) : w_(w), strs_(strs) {}
+
+  sonic_force_inline uint8_t type() const noexcept {
+    return static_cast<uint8_t>(*w_ >> internal::kTapeTypeShift);
+  }
+  sonic_force_inline uint8_t basicType() const noexcept {
+    return type() & kBasicTypeMask;
+  }
+  sonic_force_inline size_t skip() const noexcept {
+    return static_cast<uint32_t>(*w_);
+  }
+  // the number of words of this value, branchless for the iteration
+  sonic_force_inline size_t width() const noexcept {
+    uint64_t w = *w_;
+    uint8_t t = static_cast<uint8_t>(w >> internal::kTapeTypeShift) &
+                kBasicTypeMask;
+    size_t scalar = t >= kNumber ? 2 : 1;
+    return t >= kObject ? static_cast<uint32_t>(w) : scalar;
+  }
+
+  inline static const uint64_t kNullTape[1] = {0};
+  inline static const uint64_t kMissing = 0;
+
+  const uint64_t *w_{&kMissing};
+  const char *strs_{nullptr};
+};
+
+struct TapeMember {
+  TapeNode name;
+  TapeNode value;
+};
+
+class TapeValueIterator {
+ public:
+  using iterator_category = std::forward_iterator_tag;
+  using value_type = TapeNode;
+  using difference_type = std::ptrdiff_t;
+  using pointer = const TapeNode *;
+  using reference = const TapeNode &;
+
+  TapeValueIterator() = default;
+  explicit TapeValueIterator(TapeNode node) : node_(node) {}
+
+  reference operator*() const { return node_; }
+  pointer operator->() const { return &node_; }
+  TapeValueIterator &operator++() {
+    node_.w_ += node_.width();
+    return *this;
+  }
+  TapeValueIterator operator++(int) {
+    TapeValueIterator re = *this;
+    ++(*this);
+    return re;
+  }
+  bool operator==(const TapeValueIterator &rhs) const {
+    return node_.w_ == rhs.node_.w_;
+  }
+  bool operator!=(const TapeValueIterator &rhs) const {
+    return !(*this == rhs);
+  }
+
+ private:
+  TapeNode node_{};
+};
+
+class TapeMemberIterator {
+ public:
+  using iterator_category = std::forward_iterator_tag;
+  using value_type = TapeMember;
+  using difference_type = std::ptrdiff_t;
+  using pointer = const TapeMember *;
+  using reference = const TapeMember &;
+
+  TapeMemberIterator() = default;
+  explicit TapeMemberIterator(TapeNode name) : m_{name, name} {
+    m_.value.w_ += 2;
+  }
+
+  reference operator*() const { return m_; }
+  pointer operator->() const { return &m_; }
+  TapeMemberIterator &operator++() {
+    m_.name.w_ = m_.value.w_ + m_.value.width();
+    m_.value.w_ = m_.name.w_ + 2;
+    return *this;
+  }
+  TapeMemberIterator operator++(int) {
+    TapeMemberIterator re = *this;
+    ++(*this);
+    return re;
+  }
+  bool operator==(const TapeMemberIterator &rhs) const {
+    return m_.name.w_ == rhs.m_.name.w_;
+  }
+  bool operator!=(const TapeMemberIterator &rhs) const {
+    return !(*this == rhs);
+  }
+
+ private:
+  TapeMember m_{};
+};
+
+inline size_t TapeNode::Size() const noexcept {
+  if (!IsContainer()) {
+    sonic_assert(IsString() || IsStringNumber() || IsRaw());
+    return w_[1];
+  }
+  size_t cnt = (*w_ >> 32) & internal::kTapeMaxCount;
+  if (sonic_likely(cnt < internal::kTapeMaxCount)) return cnt;
+  cnt = 0;
+  if (IsObject()) {
+    for (auto m = MemberBegin(), e = MemberEnd(); m != e; ++m) cnt++;
+  } else {
+    for (auto i = Begin(), e = End(); i != e; ++i) cnt++;
+  }
+  return cnt;
+}
+
+inline TapeValueIterator TapeNode::Begin() const noexcept {
+  sonic_assert(IsArray());
+  return TapeValueIterator(TapeNode(w_ + 1, strs_));
+}
+
+inline TapeValueIterator TapeNode::End() const noexcept {
+  sonic_assert(IsArray());
+  return TapeValueIterator(TapeNode(w_ + skip() - 1, strs_));
+}
+
+inline TapeMemberIterator TapeNode::MemberBegin() const noexcept {
+  sonic_assert(IsObject());
+  return TapeMemberIterator(TapeNode(w_ + 1, strs_));
+}
+
+inline TapeMemberIterator TapeNode::MemberEnd() const noexcept {
+  sonic_assert(IsObject());
+  return TapeMemberIterator(TapeNode(w_ + skip() - 1, strs_));
+}
+
+inline TapeMemberIterator TapeNode::FindMember(
+    StringView key) const noexcept {
+  auto m = MemberBegin(), e = MemberEnd();
+  for (; m != e; ++m) {
+    const TapeNode &name = m->name;
+    // compare the length in the tape before touching the string arena
+    if (name.w_[1] == key.size() &&
+        std::memcmp(strs_ + (*name.w_ & internal::kTapePayloadMask),
+                    key.data(), key.size()) == 0) {
+      break;
+    }
+  }
+  return m;
+}
+
+inline TapeMemberIterator TapeNode::FindMember(const char *key,
+                                               size_t len) const noexcept {
+  return FindMember(StringView(key, len));
+}
+
+inline bool TapeNode::HasMember(StringView key) const noexcept {
+  return FindMember(key) != MemberEnd();
+}
+
+inline TapeNode TapeNode::operator[](StringView key) const noexcept {
+  if (!IsObject()) return TapeNode();
+  auto m = FindMember(key);
+  return m != MemberEnd() ? m->value : TapeNode();
+}
+
+inline TapeNode TapeNode::operator[](size_t idx) const noexcept {
+  if (!IsArray()) return TapeNode();
+  auto i = Begin(), e = End();
+  for (; i != e && idx > 0; ++i, idx--) {
+  }
+  return i != e ? *i : TapeNode();
+}
+
+/**
+ * @brief TapeDocument is a read-only document parsed into a tape. It is
+ * cheaper to parse than GenericDocument, and the values are stored in the
+ * document order, so that iteration and serialization are sequential memory
+ * accesses. The document is the root node.
+ */
+class TapeDocument : public TapeNode {
+ public:
+  TapeDocument() : TapeNode(kNullTape, nullptr) {}
+  TapeDocument(const TapeDocument &) = delete;
+  TapeDocument &operator=(const TapeDocument &) = delete;
+  TapeDocument(TapeDocument &&rhs) noexcept : TapeNode(kNullTape, nullptr) {
+    swap(rhs);
+  }
+  TapeDocument &operator=(TapeDocument &&rhs) noexcept {
+    swap(rhs);
+    return *this;
+  }
+  ~TapeDocument() { std::free(str_); }
+
+  /**
+   * @brief Parse by std::string or StringView. The input is copied, and the
+   * tape and strings are kept in the document.
+   * @param parseFlags combination of different ParseFlag. Borrowed input is
+   * not supported, the strings are unescaped in the copy of the input.
+   * @param json json string
+   * @return TapeDocument& reference to this document
+   */
+  template <ParseFlags parseFlags = ParseFlags::kParseDefault>
+  TapeDocument &Parse(StringView json) {
+    return Parse<parseFlags>(json.data(), json.size());
+  }
+
+  template <ParseFlags parseFlags = ParseFlags::kParseDefault>
+  TapeDocument &Parse(const char *data, size_t len) {
+    static_assert(!(parseFlags & ParseFlags::kParseBorrowInput),
+                  "TapeDocument does not support borrowed input");
+    w_ = kNullTape;
+    strs_ = nullptr;
+    parse_result_ = allocateStringBuffer(data, len);
+    if (sonic_unlikely(HasParseError())) return *this;
+    if (!sax_.SetUp(str_, len)) {
+      parse_result_ = kErrorNoMem;
+      return *this;
+    }
+    Parser<parseFlags> p;
+    parse_result_ = p.Parse(str_, len, sax_);
+    if (sonic_unlikely(sax_.oom_)) {
+      parse_result_ = kErrorNoMem;
+      return *this;
+    }
+    if (sonic_unlikely(HasParseError())) return *this;
+    w_ = sax_.tape_;
+    strs_ = str_;
+    return *this;
+  }
+
+  sonic_force_inline bool HasParseError() const {
+    return parse_result_.Error() != kErrorNone;
+  }
+  sonic_force_inline SonicError GetParseError() const {
+    return parse_result_.Error();
+  }
+  sonic_force_inline size_t GetErrorOffset() const {
+    return parse_result_.Offset();
+  }
+
+  /**
+   * @brief The number of 8-byte words in the tape.
+   */
+  sonic_force_inline size_t TapeSize() const {
+    return w_ == kNullTape ? 0 : sax_.np_;
+  }
+
+ private:
+  void swap(TapeDocument &rhs) noexcept {
+    std::swap(w_, rhs.w_);
+    std::swap(strs_, rhs.strs_);
+    std::swap(parse_result_, rhs.parse_result_);
+    std::swap(str_, rhs.str_);
+    std::swap(str_cap_, rhs.str_cap_);
+    sax_.swap(rhs.sax_);
+  }
+
+  SonicError allocateStringBuffer(const char *json, size_t len) {
+    size_t pad_len = len + 64;
+    if (str_cap_ < pad_len) {
+      std::free(str_);
+      str_ = static_cast<char *>(std::malloc(pad_len));
+      str_cap_ = str_ ? pad_len : 0;
+    }
+    if (str_ == nullptr) return kErrorNoMem;
+    std::memcpy(str_, json, len);
+    // Add ending mask to support parsing invalid json
+    str_[len] = 'x';
+    str_[len + 1] = '"';
+    str_[len + 2] = 'x';
+    return kErrorNone;
+  }
+
+  ParseResult parse_result_{};
+  char *str_{nullptr};
+  size_t str_cap_{0};
+  TapeHandler sax_{};
+};
+
+}  // namespace sonic_json
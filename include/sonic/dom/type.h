@@ -66,6 +66,22 @@ enum TypeInfo {
   // - DNode can still know whether sv.p/raw.p needs Allocator::Free()
   kOwnedStringMask = 1 << 5,
 
+  // Set with kReal by kParseLazyNumbers: sv.p and the length are the text of
+  // the number, which is decoded when accessed.
+  kLazyNumberMask = 1 << 6,
+
+  // Set with kStringCopy by kParseLazyStrings: sv.p and the length are the
+  // escaped text of the string, which is unescaped in place when accessed.
+  // The node keeps the flag, the parsed buffer keeps whether it is unescaped.
+  kEscapedStringMask = 1 << 7,
+
+  // Set with kArray by kParsePackNumberArrays: the children are the plain
+  // values after MetaNode, which keeps the allocator to unpack them.
+  kPackedArrayMask = 1 << 6,
+  // Set with kPackedArrayMask if the values are int64_t rather than double.
+  // Not 1 << 7, which is checked by Size() for the escaped strings.
+  kPackedIntMask = 1 << 5,
+
   // Others
   kInfoBits = 8,
   kInfoMask = (1 << 8) - 1,
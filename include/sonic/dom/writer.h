@@ -0,0 +1,240 @@
+/*
+ * Copyright 2022 ByteDance Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <string>
+
+#include "sonic/allocator.h"
+#include "sonic/dom/flags.h"
+#include "sonic/dom/serialize.h"
+#include "sonic/internal/arch/simd_quote.h"
+#include "sonic/internal/ftoa.h"
+#include "sonic/internal/itoa.h"
+#include "sonic/string_view.h"
+#include "sonic/writebuffer.h"
+
+namespace sonic_json {
+
+/**
+ * @brief GenericWriter writes JSON into a WriteBuffer by events, without
+ * building the DOM. The commas and colons are added by the writer: every
+ * value in a container is followed by a comma, which is replaced by the
+ * closing bracket when the container ends.
+ *
+ *   Writer w(wb);
+ *   w.StartObject();
+ *   w.Key("a");
+ *   w.Int(1);
+ *   w.EndObject();  // {"a":1}
+ *
+ * It has the same methods as a SAX handler, so it can be driven by Parser to
+ * minify or transcode JSON. The events must be a valid JSON, they are only
+ * checked by assertions.
+ */
+template <SerializeFlags serializeFlags = SerializeFlags::kSerializeDefault>
+class GenericWriter {
+ public:
+  using Allocator = SimpleAllocator;
+
+  /**
+   * @brief Write into `wb`. The buffer is cleared unless
+   * kSerializeAppendBuffer is set.
+   */
+  explicit GenericWriter(WriteBuffer &wb) : wb_(wb) {
+    if constexpr ((serializeFlags & SerializeFlags::kSerializeAppendBuffer) ==
+                  0) {
+      wb_.Clear();
+    }
+  }
+
+  GenericWriter(const GenericWriter &) = delete;
+  GenericWriter &operator=(const GenericWriter &) = delete;
+
+  /**
+   * @brief Clear the buffer and the state to write a new JSON.
+   */
+  void Reset() {
+    if constexpr ((serializeFlags & SerializeFlags::kSerializeAppendBuffer) ==
+                  0) {
+      wb_.Clear();
+    }
+    depth_ = 0;
+  }
+
+  /**
+   * @brief Check a complete JSON value is written.
+   */
+  sonic_force_inline bool IsComplete() const {
+    return depth_ == 0 && !wb_.Empty();
+  }
+
+  sonic_force_inline bool Null() {
+    wb_.Push5_8("null,   ", 4 + (depth_ != 0));
+    return true;
+  }
+
+  sonic_force_inline bool Bool(bool val) {
+    if (val) {
+      wb_.Push5_8("true,   ", 4 + (depth_ != 0));
+    } else {
+      wb_.Push5_8("false,  ", 5 + (depth_ != 0));
+    }
+    return true;
+  }
+
+  sonic_force_inline bool Int(int64_t val) {
+    wb_.Grow(kNumberSize);
+    char *end = wb_.End<char>();
+    wb_.PushSizeUnsafe<char>(internal::I64toa(end, val) - end);
+    return comma();
+  }
+
+  sonic_force_inline bool Uint(uint64_t val) {
+    wb_.Grow(kNumberSize);
+    char *end = wb_.End<char>();
+    wb_.PushSizeUnsafe<char>(internal::U64toa(end, val) - end);
+    return comma();
+  }
+
+  /**
+   * @brief Write a double. Returns false for infinity and NaN, unless
+   * kSerializeInfNan is set.
+   */
+  sonic_force_inline bool Double(double val) {
+    wb_.Grow(kNumberSize);
+    ssize_t rn = internal::F64toa<serializeFlags>(wb_.End<char>(), val);
+    if (sonic_unlikely(rn <= 0)) {
+      rn = internal::SerializeInfNan<serializeFlags>(wb_.End<char>(), val);
+      if (rn <= 0) return false;
+    }
+    wb_.PushSizeUnsafe<char>(rn);
+    return comma();
+  }
+
+  sonic_force_inline bool String(StringView s) {
+    quote(s);
+    return comma();
+  }
+
+  sonic_force_inline bool Key(StringView s) {
+    sonic_assert(depth_ != 0);
+    quote(s);
+    wb_.PushUnsafe<char>(':');
+    return true;
+  }
+
+  /**
+   * @brief Write the text as it is, e.g. a number string or a serialized
+   * JSON value.
+   */
+  sonic_force_inline bool Raw(const char *data, size_t len) {
+    wb_.Push(data, len);
+    return comma();
+  }
+
+  sonic_force_inline bool NumStr(StringView s) {
+    return Raw(s.data(), s.size());
+  }
+
+  // The text of a real number by kParseLazyNumbers is written as it is.
+  sonic_force_inline bool LazyDouble(StringView s) {
+    return Raw(s.data(), s.size());
+  }
+
+  // The escaped text of a string by kParseLazyStrings is written as it is,
+  // unless the emoji must be escaped.
+  sonic_force_inline bool LazyString(StringView s) {
+    if constexpr (serializeFlags & SerializeFlags::kSerializeEscapeEmoji) {
+      size_t len = internal::DecodeLazyString(const_cast<char *>(s.data()));
+      return String(StringView(s.data(), len));
+    }
+    wb_.Grow(s.size() + 3);
+    wb_.PushUnsafe<char>('"');
+    wb_.PushUnsafe(s.data(), s.size());
+    wb_.PushUnsafe<char>('"');
+    return comma();
+  }
+
+  sonic_force_inline bool StartObject() {
+    wb_.Push<char>('{');
+    depth_++;
+    return true;
+  }
+
+  sonic_force_inline bool StartArray() {
+    wb_.Push<char>('[');
+    depth_++;
+    return true;
+  }
+
+  // The counts are only for the SAX interface.
+  sonic_force_inline bool EndObject(uint32_t = 0) { return end('}'); }
+
+  sonic_force_inline bool EndArray(uint32_t = 0) { return end(']'); }
+
+  // Used when parsing borrowed input, the allocated strings are freed.
+  sonic_force_inline bool Key(StringView s, bool allocated) {
+    Key(s);
+    if (allocated) Allocator::Free((void *)(s.data()));
+    return true;
+  }
+
+  sonic_force_inline bool String(StringView s, bool allocated) {
+    String(s);
+    if (allocated) Allocator::Free((void *)(s.data()));
+    return true;
+  }
+
+  sonic_force_inline Allocator &GetAllocator() { return alloc_; }
+
+ private:
+  constexpr static size_t kNumberSize = 33;
+
+  sonic_force_inline void quote(StringView s) {
+    // reserve one more byte for the comma or colon
+    wb_.Grow(s.size() * 6 + 32 + 3);
+    char *end = wb_.End<char>();
+    wb_.PushSizeUnsafe<char>(
+        internal::Quote<serializeFlags>(s.data(), s.size(), end) - end);
+  }
+
+  sonic_force_inline bool comma() {
+    if (sonic_likely(depth_ != 0)) wb_.Push<char>(',');
+    return true;
+  }
+
+  sonic_force_inline bool end(char c) {
+    sonic_assert(depth_ != 0);
+    char *top = wb_.Top<char>();
+    if (*top == ',') {
+      *top = c;
+    } else {
+      wb_.Push<char>(c);
+    }
+    depth_--;
+    return comma();
+  }
+
+  WriteBuffer &wb_;
+  uint32_t depth_{0};
+  Allocator alloc_{};
+};
+
+using Writer = GenericWriter<SerializeFlags::kSerializeDefault>;
+
+}  // namespace sonic_json
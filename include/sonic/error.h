@@ -58,6 +58,7 @@ enum SonicError {
   kUnmatchedTypeInJsonPath =
       19,                  ///< JsonPath: The type of node is not matched.
   kErrorNoneNoMatch = 20,  ///< JsonPath: No node is matched by the json path.
+  kErrorOpenFile = 21,     ///< ParseFile: Failed to open or map the file.
   kErrorNums,
 };
 
@@ -97,6 +98,7 @@ inline const char* ErrorMsg(SonicError error) noexcept {
       {kNotFoundByJsonPath, "JsonPath: Not found the target by json path."},
       {kUnmatchedTypeInJsonPath, "JsonPath: The type of node is not matched."},
       {kErrorNoneNoMatch, "JsonPath: no match."},
+      {kErrorOpenFile, "ParseFile: Failed to open or map the file."},
 
   };
   static_assert(sizeof(kErrorMsg) / sizeof(kErrorMsg[0]) == kErrorNums,
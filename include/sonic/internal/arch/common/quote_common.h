@@ -42,13 +42,21 @@ template <ParseFlags parseFlags = ParseFlags::kParseDefault>
 sonic_force_inline size_t parseStringInplace(uint8_t*& src, SonicError& err) {
   constexpr bool kAllowUnescapedControlChars =
       (parseFlags & ParseFlags::kParseAllowUnescapedControlChars) != 0;
+  // the escaped string is only checked, and kept with the closing quote
+  constexpr bool kLazyStrings =
+      (parseFlags & ParseFlags::kParseLazyStrings) != 0;
 
   err = kErrorNone;
   uint8_t* dst = src;
   uint8_t* sdst = src;
+  bool escaped = false;
   while (true) {
     const uint8_t c = *src;
     if (c == '"') {
+      if (kLazyStrings && escaped) {
+        ++src;
+        return static_cast<size_t>(src - sdst - 1);
+      }
       *dst = '\0';
       ++src;
       return static_cast<size_t>(dst - sdst);
@@ -58,12 +66,21 @@ sonic_force_inline size_t parseStringInplace(uint8_t*& src, SonicError& err) {
       return 0;
     }
     if (sonic_likely(c != '\\')) {
-      *dst++ = *src++;
+      if (kLazyStrings && escaped) {
+        ++src;
+      } else {
+        *dst++ = *src++;
+      }
       continue;
     }
 
-    // Escape sequence.
+    // Escape sequence. The lazy strings are unescaped into buf and dropped.
     const uint8_t escape_char = src[1];
+    uint8_t buf[4];
+    if (kLazyStrings) {
+      escaped = true;
+      dst = buf;
+    }
     if (sonic_unlikely(escape_char == 'u')) {
       const uint8_t* src_ptr = src;
       uint8_t* dst_ptr = dst;
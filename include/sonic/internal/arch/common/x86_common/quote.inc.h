@@ -61,12 +61,55 @@
 
 using common::handle_unicode_codepoint;
 
+// Check the rest of a string from the first backslash without unescaping it,
+// and move src after the closing quote.
+template <ParseFlags parseFlags>
+sonic_force_inline bool checkEscapedString(uint8_t *&src, SonicError &err) {
+  while (1) {
+    uint8_t escape_char = src[1];
+    if (sonic_unlikely(escape_char == 'u')) {
+      uint8_t buf[4];
+      uint8_t *dst = buf;
+      if (!handle_unicode_codepoint(const_cast<const uint8_t **>(&src), &dst)) {
+        err = kParseErrorEscapedUnicode;
+        return false;
+      }
+    } else {
+      if (sonic_unlikely(kEscapedMap[escape_char] == 0u)) {
+        err = kParseErrorEscapedFormat;
+        return false;
+      }
+      src += 2;
+    }
+    // fast path for continuous escaped chars
+    if (*src == '\\') continue;
+    while (1) {
+      auto block = StringBlock::Find(src);
+      if (block.HasQuoteFirst<parseFlags>()) {
+        src += block.QuoteIndex() + 1;
+        return true;
+      }
+      if (block.HasUnescaped()) {
+        err = kParseErrorUnEscaped;
+        return false;
+      }
+      if (block.HasBackslash()) {
+        src += block.BsIndex();
+        break;
+      }
+      src += VEC_LEN;
+    }
+  }
+}
+
 template <ParseFlags parseFlags = ParseFlags::kParseDefault>
 sonic_force_inline size_t parseStringInplace(uint8_t *&src, SonicError &err) {
 #define SONIC_REPEAT8(v) \
   { v v v v v v v v }
   constexpr bool kAllowUnescapedControlChars =
       (parseFlags & ParseFlags::kParseAllowUnescapedControlChars) != 0;
+  constexpr bool kLazyStrings =
+      (parseFlags & ParseFlags::kParseLazyStrings) != 0;
   uint8_t *dst = src;
   uint8_t *sdst = src;
   while (1) {
@@ -92,6 +135,11 @@ sonic_force_inline size_t parseStringInplace(uint8_t *&src, SonicError &err) {
     /* find out where the backspace is */
     auto bs_dist = block.BsIndex();
     src += bs_dist;
+    if constexpr (kLazyStrings) {
+      // the escaped string is kept with the closing quote
+      if (!checkEscapedString<parseFlags>(src, err)) return 0;
+      return src - sdst - 1;
+    }
     dst = src;
   cont:
     uint8_t escape_char = src[1];
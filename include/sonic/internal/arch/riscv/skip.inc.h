@@ -37,6 +37,145 @@ sonic_force_inline uint64_t GetStringBits(const uint8_t *data,
   return in_string;
 }
 
+// index_newlines writes the positions of the newlines outside strings into
+// index, and returns the count. index should have space for len positions at
+// least.
+template <typename T>
+sonic_force_inline size_t index_newlines(const uint8_t *data, size_t len,
+                                         uint32_t *index) {
+  uint64_t prev_instring = 0, prev_escaped = 0;
+  uint32_t *out = index;
+  uint8_t buf[64];
+  for (size_t pos = 0; pos < len; pos += 64) {
+    const uint8_t *p = data + pos;
+    if (pos + 64 > len) {
+      std::memset(buf, ' ', sizeof(buf));
+      std::memcpy(buf, p, len - pos);
+      p = buf;
+    }
+    uint64_t in_string = GetStringBits<T>(p, prev_instring, prev_escaped);
+    uint64_t bits = T(p).eq('\n') & ~in_string;
+    while (bits) {
+      *out++ = static_cast<uint32_t>(pos + TrailingZeroes(bits));
+      bits = ClearLowestBit(bits);
+    }
+  }
+  return out - index;
+}
+
+// split_array finds the commas in the outermost container that starts at
+// data[0]. The first comma after every `step` bytes is picked, so the
+// container is split into slices of `step` bytes at least. It writes the comma
+// positions into splits, and returns the count, at most max.
+template <typename T>
+sonic_force_inline size_t split_array(const uint8_t *data, size_t len,
+                                      size_t step, size_t *splits, size_t max) {
+  uint64_t prev_instring = 0, prev_escaped = 0;
+  size_t cnt = 0, next = step;
+  int64_t depth = 0;
+  uint8_t buf[64];
+  for (size_t pos = 0; pos < len && cnt < max; pos += 64) {
+    const uint8_t *p = data + pos;
+    if (pos + 64 > len) {
+      std::memset(buf, ' ', sizeof(buf));
+      std::memcpy(buf, p, len - pos);
+      p = buf;
+    }
+    uint64_t in_string = GetStringBits<T>(p, prev_instring, prev_escaped);
+    const T v(p);
+    uint64_t open = (v.eq('[') | v.eq('{')) & ~in_string;
+    uint64_t close = (v.eq(']') | v.eq('}')) & ~in_string;
+    if (pos + 64 <= next) {
+      // no split in this block, only the depth is needed
+      depth += CountOnes(open) - CountOnes(close);
+      continue;
+    }
+    uint64_t bits = open | close | (v.eq(',') & ~in_string);
+    while (bits) {
+      uint64_t bit = bits & (0 - bits);
+      size_t at = pos + TrailingZeroes(bits);
+      if (open & bit) {
+        depth++;
+      } else if (close & bit) {
+        // the outermost container is closed
+        if (--depth == 0) return cnt;
+      } else if (depth == 1 && at >= next) {
+        splits[cnt++] = at;
+        if (cnt == max) break;
+        next = at + step;
+      }
+      bits = ClearLowestBit(bits);
+    }
+  }
+  return cnt;
+}
+
+// index_key_candidates finds the strings which may be the key of n bytes, to
+// jump between them instead of parsing the json. The candidates are the
+// strings starting with key[0] and ending after n bytes, and the strings
+// having backslashes, since the escaped chars are not compared here. It writes
+// the positions of the opening quotes into index, and returns the count, at
+// most max. The strings are not checked to be keys.
+template <typename T>
+sonic_force_inline size_t index_key_candidates(const uint8_t *data, size_t len,
+                                               const uint8_t *key, size_t n,
+                                               uint32_t *index, size_t max) {
+  uint64_t prev_instring = 0, prev_escaped = 0;
+  // the last opening quote before the block, and whether it is written
+  size_t last_open = 0;
+  bool last_written = true;
+  size_t cnt = 0;
+  const uint8_t first = n ? key[0] : '"';
+  // only check the closing quote in the next block
+  const bool check_close = n + 1 < 64;
+  uint8_t buf[128];
+  for (size_t pos = 0; pos < len && cnt < max; pos += 64) {
+    const uint8_t *p = data + pos;
+    if (pos + 128 > len) {
+      // the bytes after json are seen as spaces
+      std::memset(buf, ' ', sizeof(buf));
+      std::memcpy(buf, p, len - pos);
+      p = buf;
+    }
+    uint64_t before = prev_instring & 1;
+    uint64_t in_string = GetStringBits<T>(p, prev_instring, prev_escaped);
+    uint64_t shifted = (in_string << 1) | before;
+    uint64_t open = in_string & ~shifted;
+    uint64_t close = ~in_string & shifted;
+    uint64_t cand = open & T(p + 1).eq(first);
+    if (check_close) {
+      cand &= T(p + n + 1).eq('"');
+    }
+    uint64_t bs = T(p).eq('\\') & in_string;
+    while (bs) {
+      uint64_t below = bs ^ (bs - 1);
+      uint64_t owner = open & below;
+      if (owner) {
+        cand |= uint64_t(1) << (63 - LeadingZeroes(owner));
+      } else if (!last_written) {
+        // the string is opened in the previous blocks
+        index[cnt++] = static_cast<uint32_t>(last_open);
+        last_written = true;
+        if (cnt == max) return cnt;
+      }
+      // skip the other backslashes in the same string
+      uint64_t end = close & ~below;
+      bs = end ? bs & ~((end & (0 - end)) - 1) : 0;
+    }
+    if (open) {
+      int last = 63 - LeadingZeroes(open);
+      last_open = pos + last;
+      last_written = (cand >> last) & 1;
+    }
+    while (cand) {
+      index[cnt++] = static_cast<uint32_t>(pos + TrailingZeroes(cand));
+      if (cnt == max) break;
+      cand = ClearLowestBit(cand);
+    }
+  }
+  return cnt;
+}
+
 // GetNextToken find the next characters in tokens and update the position to
 // it.
 template <size_t N>
@@ -26,5 +26,14 @@ namespace internal {
 SONIC_USING_ARCH_FUNC(parseStringInplace);
 SONIC_USING_ARCH_FUNC(Quote);
 
+// Unescape the text of a string kept by kParseLazyStrings in place. The text
+// was checked when parsing, and is followed by the closing quote.
+inline size_t DecodeLazyString(char *data) {
+  uint8_t *src = reinterpret_cast<uint8_t *>(data);
+  SonicError err = kErrorNone;
+  return parseStringInplace<ParseFlags::kParseAllowUnescapedControlChars>(src,
+                                                                         err);
+}
+
 }  // namespace internal
 }  // namespace sonic_json
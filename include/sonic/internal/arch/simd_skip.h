@@ -24,6 +24,7 @@
 #include "simd_dispatch.h"
 #include "sonic/dom/flags.h"
 #include "sonic/error.h"
+#include "sonic/internal/skip_index.h"
 #include "sonic/jsonpath/jsonpath.h"
 
 #include INCLUDE_ARCH_FILE(skip.h)
@@ -40,6 +41,9 @@ SONIC_USING_ARCH_FUNC(SkipString);
 SONIC_USING_ARCH_FUNC(SkipContainer);
 SONIC_USING_ARCH_FUNC(skip_space);
 SONIC_USING_ARCH_FUNC(skip_space_safe);
+SONIC_USING_ARCH_FUNC(IndexNewlines);
+SONIC_USING_ARCH_FUNC(SplitArray);
+SONIC_USING_ARCH_FUNC(IndexKeyCandidates);
 
 #define RETURN_FALSE_IF_PARSE_ERROR(x) \
   do {                                 \
@@ -155,15 +159,17 @@ class SkipScanner {
     return start;
   }
 
-  sonic_force_inline bool matchKey(const uint8_t *data, size_t &pos, size_t len,
-                                   StringView key, std::vector<uint8_t> &kbuf,
-                                   SonicError &err) {
+  // scanKey skips the key string after the quote, and returns the unescaped
+  // key, which is in kbuf if it has escaped chars.
+  sonic_force_inline StringView scanKey(const uint8_t *data, size_t &pos,
+                                        size_t len, std::vector<uint8_t> &kbuf,
+                                        SonicError &err) {
     auto start = data + pos;
     auto status = SkipString(data, pos, len);
     // has errors
     if (!status) {
       err = SonicError::kParseErrorInvalidChar;
-      return false;
+      return StringView();
     }
 
     auto slen = data + pos - 1 - start;
@@ -178,52 +184,56 @@ class SkipScanner {
       slen = parseStringInplace<ParseFlags::kParseDefault>(nsrc, err);
       if (err) {
         pos = (start - data) + (nsrc - &kbuf[0]);
-        return false;
+        return StringView();
       }
       start = &kbuf[0];
     }
+    return StringView(reinterpret_cast<const char *>(start), slen);
+  }
+
+  // SkipOne by the container ends recorded in the index, and record the ends
+  // of the skipped containers.
+  sonic_force_inline long SkipOne(const uint8_t *data, size_t &pos, size_t len,
+                                  SkipIndex &index) {
+    uint8_t c = SkipSpaceSafe(data, pos, len);
+    size_t start = pos - 1;
+    bool is_container = c == '{' || c == '[';
+    if (is_container) {
+      uint32_t end = index.End(start);
+      if (end != 0) {
+        pos = end;
+        return start;
+      }
+    }
+    pos = start;
+    long ret = SkipOne(data, pos, len);
+    if (is_container && ret >= 0) index.SetEnd(start, pos);
+    return ret;
+  }
 
+  sonic_force_inline bool matchKey(const uint8_t *data, size_t &pos, size_t len,
+                                   StringView key, std::vector<uint8_t> &kbuf,
+                                   SonicError &err) {
+    StringView s = scanKey(data, pos, len, kbuf, err);
+    if (err) return false;
     // compare the key
-    return slen == static_cast<long>(key.size()) &&
-           std::memcmp(start, key.data(), slen) == 0;
+    return s.size() == key.size() &&
+           std::memcmp(s.data(), key.data(), s.size()) == 0;
   }
   sonic_force_inline int matchKeys(const uint8_t *data, size_t &pos, size_t len,
                                    const std::vector<StringView> &keys,
                                    std::vector<uint8_t> &kbuf,
                                    SonicError &err) {
-    auto start = data + pos;
-    auto status = SkipString(data, pos, len);
-    // has errors
-    if (!status) {
-      err = SonicError::kParseErrorInvalidChar;
-      return -1;
-    }
-
-    auto slen = data + pos - 1 - start;
-    // has escaped char
-    if (status == 2) {
-      // parse escaped key
-      kbuf.resize(slen + 32);
-      uint8_t *nsrc = &kbuf[0];
-
-      // parseStringInplace need `"` as the end
-      std::memcpy(nsrc, start, slen + 1);
-      slen = parseStringInplace<ParseFlags::kParseDefault>(nsrc, err);
-      if (err) {
-        pos = (start - data) + (nsrc - &kbuf[0]);
-        return -1;
-      }
-      start = &kbuf[0];
-    }
-
+    StringView s = scanKey(data, pos, len, kbuf, err);
+    if (err) return -1;
+    // compare the key
     for (size_t i = 0; i < keys.size(); i++) {
       const auto &key = keys[i];
-      if (slen == static_cast<long>(key.size()) &&
-          std::memcmp(start, key.data(), slen) == 0) {
+      if (s.size() == key.size() &&
+          std::memcmp(s.data(), key.data(), s.size()) == 0) {
         return i;
       }
     }
-    // compare the key
     return -1;
   }
 
@@ -323,10 +333,247 @@ class SkipScanner {
   uint64_t nonspace_bits_{0};
 };
 
+// PointerTrieScanner gets the targets of all json pointers in a trie by one
+// scan. The values out of the trie are skipped, and the scan stops when all
+// targets are found.
+class PointerTrieScanner {
+ public:
+  // GetOnDemand sets targets[i] to the raw json field of the i-th pointer, or
+  // leaves it empty if not found, and updates the position. Returns the
+  // negative error if the json is invalid.
+  long GetOnDemand(StringView json, size_t &pos, const JsonPointerTrie &trie,
+                   StringView *targets) {
+    data_ = reinterpret_cast<const uint8_t *>(json.data());
+    len_ = json.size();
+    trie_ = &trie;
+    targets_ = targets;
+    remaining_ = trie.TargetNodes();
+    found_.assign(trie.NodeCount(), 0);
+    if (remaining_ == 0) return 0;
+    long ret = scanNode(pos, 0);
+    return ret < 0 ? ret : 0;
+  }
+
+ private:
+  // scanNode scans the value at pos for the trie node. Returns the negative
+  // error, 1 if all targets are found, or 0.
+  long scanNode(size_t &pos, uint32_t id) {
+    const JsonPointerTrie::Node &node = trie_->GetNode(id);
+    long start;
+    if (!node.HasChildren()) {
+      start = scan_.SkipOne(data_, pos, len_);
+      if (start < 0) return start;
+    } else {
+      uint8_t c = scan_.SkipSpaceSafe(data_, pos, len_);
+      start = pos - 1;
+      long ret;
+      if (c == '{' && !node.keys.empty()) {
+        ret = scanObject(pos, node);
+      } else if (c == '[' && !node.indexes.empty()) {
+        ret = scanArray(pos, node);
+      } else {
+        // the children are not in this type
+        pos--;
+        ret = scan_.SkipOne(data_, pos, len_);
+        if (ret > 0) ret = 0;
+      }
+      if (ret != 0) return ret;
+    }
+    if (node.targets.empty()) return 0;
+    StringView v(reinterpret_cast<const char *>(data_) + start, pos - start);
+    for (uint32_t t : node.targets) targets_[t] = v;
+    return --remaining_ == 0;
+  }
+
+  long scanObject(size_t &pos, const JsonPointerTrie::Node &node) {
+    size_t pending = node.keys.size();
+    SonicError err = kErrorNone;
+    uint8_t c = scan_.SkipSpaceSafe(data_, pos, len_);
+    if (c == '}') return 0;
+    while (true) {
+      if (c != '"') goto err_invalid_char;
+      {
+        StringView key = scan_.scanKey(data_, pos, len_, kbuf_, err);
+        if (err) return -err;
+        if (scan_.SkipSpaceSafe(data_, pos, len_) != ':') goto err_invalid_char;
+        uint32_t child = 0;
+        for (size_t i = 0; i < node.keys.size(); i++) {
+          if (key == StringView(node.keys[i])) {
+            child = node.key_nodes[i];
+            break;
+          }
+        }
+        // only the first one of the duplicated keys is matched
+        if (child != 0 && !found_[child]) {
+          found_[child] = 1;
+          long ret = scanNode(pos, child);
+          if (ret != 0) return ret;
+          if (--pending == 0) {
+            // skip the rest members
+            if (!SkipObject(data_, pos, len_)) goto err_invalid_char;
+            return 0;
+          }
+        } else {
+          long ret = scan_.SkipOne(data_, pos, len_);
+          if (ret < 0) return ret;
+        }
+      }
+      c = scan_.SkipSpaceSafe(data_, pos, len_);
+      if (c == '}') return 0;
+      if (c != ',') goto err_invalid_char;
+      c = scan_.SkipSpaceSafe(data_, pos, len_);
+    }
+  err_invalid_char:
+    pos -= 1;
+    return -kParseErrorInvalidChar;
+  }
+
+  long scanArray(size_t &pos, const JsonPointerTrie::Node &node) {
+    size_t next = 0;
+    int idx = 0;
+    uint8_t c = scan_.SkipSpaceSafe(data_, pos, len_);
+    if (c == ']') return 0;
+    pos--;
+    // the negative indexes never match
+    while (next < node.indexes.size() && node.indexes[next] < 0) next++;
+    if (next == node.indexes.size()) {
+      if (!SkipArray(data_, pos, len_)) goto err_invalid_char;
+      return 0;
+    }
+    while (true) {
+      if (idx == node.indexes[next]) {
+        long ret = scanNode(pos, node.index_nodes[next]);
+        if (ret != 0) return ret;
+        if (++next == node.indexes.size()) {
+          // skip the rest elements
+          if (!SkipArray(data_, pos, len_)) goto err_invalid_char;
+          return 0;
+        }
+      } else {
+        long ret = scan_.SkipOne(data_, pos, len_);
+        if (ret < 0) return ret;
+      }
+      c = scan_.SkipSpaceSafe(data_, pos, len_);
+      if (c == ']') return 0;
+      if (c != ',') goto err_invalid_char;
+      idx++;
+    }
+  err_invalid_char:
+    pos -= 1;
+    return -kParseErrorInvalidChar;
+  }
+
+  SkipScanner scan_;
+  const uint8_t *data_{nullptr};
+  size_t len_{0};
+  const JsonPointerTrie *trie_{nullptr};
+  StringView *targets_{nullptr};
+  size_t remaining_{0};
+  // the visited children, to skip the duplicated keys
+  std::vector<uint8_t> found_;
+  std::vector<uint8_t> kbuf_;
+};
+
+// FilterScanner tests the jsonpath filters on the raw json values. The fields
+// used by a filter are got by one scan of the value, and only they are
+// decoded. The numbers are decoded and the containers are compared by the dom,
+// through the json generator.
+class FilterScanner {
+ public:
+  /**
+   * @brief Test the filter on the json value at pos, the pos is not changed.
+   * @return false if not matched, or the json is invalid and err is set.
+   */
+  template <typename Generator>
+  bool Match(const uint8_t *data, size_t pos, size_t len,
+             const JsonPathFilter &filter, Generator *gen, SonicError &err) {
+    size_t n = filter.Queries().size();
+    targets_.assign(n, StringView());
+    values_.resize(n);
+    if (bufs_.size() < n) bufs_.resize(n);
+    if (n != 0) {
+      long ret = trie_scan_.GetOnDemand(
+          StringView(reinterpret_cast<const char *>(data), len), pos,
+          filter.QueryTrie(), targets_.data());
+      if (ret < 0) {
+        err = SonicError(-ret);
+        return false;
+      }
+    }
+    for (size_t i = 0; i < n; i++) {
+      if (!decode(targets_[i], values_[i], bufs_[i], gen, err)) return false;
+    }
+    bool matched = filter.Eval(
+        values_.data(), [&](const FilterValue &a, const FilterValue &b) {
+          bool equal = false;
+          SonicError e = gen->isEqualJson(a.str, b.str, equal);
+          if (e != kErrorNone) err = e;
+          return equal;
+        });
+    return matched && err == kErrorNone;
+  }
+
+ private:
+  template <typename Generator>
+  bool decode(StringView raw, FilterValue &v, std::vector<uint8_t> &buf,
+              Generator *gen, SonicError &err) {
+    // the skipped scalars may have the trailing spaces
+    while (!raw.empty() && IsSpace(static_cast<uint8_t>(raw.back()))) {
+      raw.remove_suffix(1);
+    }
+    v = FilterValue();
+    if (raw.empty()) return true;
+    const uint8_t *p = reinterpret_cast<const uint8_t *>(raw.data());
+    switch (p[0]) {
+      case '"': {
+        size_t pos = 1;
+        v.kind = FilterValue::kString;
+        v.str = SkipScanner().scanKey(p, pos, raw.size(), buf, err);
+        return err == kErrorNone;
+      }
+      case '{':
+      case '[':
+        v.kind = FilterValue::kContainer;
+        v.str = raw;
+        return true;
+      case 't':
+        v.kind = FilterValue::kTrue;
+        return raw == "true" || invalid(err);
+      case 'f':
+        v.kind = FilterValue::kFalse;
+        return raw == "false" || invalid(err);
+      case 'n':
+        v.kind = FilterValue::kNull;
+        return raw == "null" || invalid(err);
+      default:
+        v.kind = FilterValue::kNumber;
+        // the same error as parsing the number by the dom
+        err = gen->decodeNumber(raw, v.num);
+        return err == kErrorNone;
+    }
+  }
+
+  static bool invalid(SonicError &err) {
+    err = kParseErrorInvalidChar;
+    return false;
+  }
+
+  PointerTrieScanner trie_scan_;
+  std::vector<StringView> targets_;
+  std::vector<FilterValue> values_;
+  // the buffers of the escaped strings
+  std::vector<std::vector<uint8_t>> bufs_;
+};
+
 class SkipScanner2 {
  public:
+  sonic_force_inline long skipValue() {
+    return index_ ? scanner_.SkipOne(data_, pos_, len_, *index_)
+                  : scanner_.SkipOne(data_, pos_, len_);
+  }
+
   sonic_force_inline StringView getOne() {
-    long start = scanner_.SkipOne(data_, pos_, len_);
+    long start = skipValue();
     if (start < 0) {
       setError(SonicError(-start));
       return "";
@@ -336,7 +583,7 @@ class SkipScanner2 {
   }
 
   sonic_force_inline SonicError skipOne() {
-    long start = scanner_.SkipOne(data_, pos_, len_);
+    long start = skipValue();
     if (start < 0) {
       setError(SonicError(-start));
       return error_;
@@ -344,6 +591,17 @@ class SkipScanner2 {
     return SonicError::kErrorNone;
   }
 
+  // Skip the key of an object member and the colon before its value.
+  sonic_force_inline bool skipMemberKey() {
+    RETURN_FALSE_IF_PARSE_ERROR(consume('"'));
+    if (!SkipString(data_, pos_, len_)) {
+      setError(SonicError::kParseErrorInvalidChar);
+      return false;
+    }
+    RETURN_FALSE_IF_PARSE_ERROR(consume(':'));
+    return true;
+  }
+
   sonic_force_inline uint8_t peek() {
     if (sonic_unlikely(pos_ >= len_)) {
       setError(SonicError::kParseErrorEof);
@@ -663,6 +921,11 @@ class SkipScanner2 {
     virtual bool writeComma() = 0;
     virtual bool isEmpty() = 0;
     virtual bool isBeginArray() = 0;
+    // The filters decode the numbers and compare the containers by the dom.
+    // Return the parse error of the dom if the json is invalid.
+    virtual SonicError decodeNumber(StringView raw, double &num) = 0;
+    virtual SonicError isEqualJson(StringView a, StringView b,
+                                   bool &equal) = 0;
     virtual ~JsonGeneratorInterface() {}
   };
   template <SerializeFlags serializeFlags>
@@ -753,6 +1016,259 @@ class SkipScanner2 {
 
     return result;
   }
+  // Consume the key of the child i of the container, and match the child by
+  // the node as the dom: the keys select the members of the objects, and the
+  // indexes select the elements of the arrays.
+  template <typename Generator>
+  inline bool matchChild(const JsonPath &path, const JsonPathNode &node,
+                         bool is_obj, int64_t i, int64_t idx, Generator *gen,
+                         bool &matched) {
+    matched = node.is_wildcard();
+    if (is_obj) {
+      RETURN_FALSE_IF_PARSE_ERROR(consume('"'));
+      if (node.is_key()) {
+        matched =
+            scanner_.matchKey(data_, pos_, len_, node.key(), kbuf_, error_);
+        if (hasError()) return false;
+      } else if (!SkipString(data_, pos_, len_)) {
+        setError(SonicError::kParseErrorInvalidChar);
+        return false;
+      }
+      RETURN_FALSE_IF_PARSE_ERROR(consume(':'));
+    } else if (node.is_index()) {
+      matched = i == idx;
+    }
+    if (node.is_filter()) {
+      matched =
+          filter_.Match(data_, pos_, len_, path.filter(node), gen, error_);
+      if (hasError()) return false;
+    }
+    return true;
+  }
+
+  // Append the values selected by path[index:] from the value at pos_ to vals
+  // in the document order, as the dom selects the nodes, and skip the value.
+  template <typename Generator>
+  inline bool collectJsonPath(const JsonPath &path, size_t index,
+                              std::vector<StringView> &vals, Generator *gen) {
+    if (index >= path.size()) {
+      const auto sv = getOne();
+      if (hasError()) return false;
+      vals.push_back(sv);
+      return true;
+    }
+    const JsonPathNode &node = path[index];
+    if (node.is_descendant()) {
+      return collectDescendants(path, index + 1, vals, gen);
+    }
+    const auto c = peek();
+    if (hasError()) return false;
+    const bool is_obj = c == '{';
+    // select nothing from the primitive value, the key from the array, or the
+    // index from the object
+    if ((!is_obj && c != '[') || (node.is_key() && !is_obj) ||
+        (node.is_index() && !node.is_key() && is_obj)) {
+      return skipOne() == kErrorNone;
+    }
+    const uint8_t close = is_obj ? '}' : ']';
+    RETURN_FALSE_IF_PARSE_ERROR(consume(c));
+    int64_t idx = node.is_index() ? node.index() : 0;
+    if (idx < 0) {
+      // count the elements for the negative index
+      const size_t start = pos_;
+      for (int64_t n = 0; peek() != close; n++) {
+        if (hasError()) return false;
+        if (n > 0) RETURN_FALSE_IF_PARSE_ERROR(consume(','));
+        RETURN_FALSE_IF_PARSE_ERROR(skipOne());
+        idx++;
+      }
+      if (hasError()) return false;
+      pos_ = start;
+    }
+    // the first member of the key is selected
+    bool found = false;
+    for (int64_t i = 0; peek() != close; i++) {
+      if (hasError()) return false;
+      if (i > 0) RETURN_FALSE_IF_PARSE_ERROR(consume(','));
+      bool matched = false;
+      if (found) {
+        if (!skipMemberKey()) return false;
+      } else if (!matchChild(path, node, is_obj, i, idx, gen, matched)) {
+        return false;
+      }
+      if (matched) {
+        found = node.is_key();
+        if (!collectJsonPath(path, index + 1, vals, gen)) return false;
+      } else {
+        RETURN_FALSE_IF_PARSE_ERROR(skipOne());
+      }
+    }
+    if (hasError()) return false;
+    RETURN_FALSE_IF_PARSE_ERROR(consume(close));
+    return true;
+  }
+
+  // Select the keys in the json text of [start, pos_) by path[index], which is
+  // after `..`, and collect the rest of the path on their values. The keys are
+  // found by the SIMD prefilter, so the containers are not parsed.
+  template <typename Generator>
+  inline bool collectDescendantKeys(size_t start, const JsonPath &path,
+                                    size_t index,
+                                    std::vector<StringView> &vals,
+                                    Generator *gen) {
+    const StringView key = path[index].key();
+    const uint8_t *kp = reinterpret_cast<const uint8_t *>(key.data());
+    const size_t n = key.size();
+    // the raw text equals the key if it has no escaped chars
+    const bool raw_key = std::memchr(key.data(), '\\', n) == nullptr &&
+                         std::memchr(key.data(), '"', n) == nullptr;
+    constexpr size_t kBatch = 64;
+    uint32_t cands[kBatch];
+    const size_t end = pos_;
+    size_t from = start;
+    size_t last = end;
+    while (from < end) {
+      size_t cnt =
+          IndexKeyCandidates(data_ + from, end - from, kp, n, cands, kBatch);
+      for (size_t i = 0; i < cnt; i++) {
+        size_t p = from + cands[i];
+        // the first candidate after resuming is the last one
+        if (p == last) continue;
+        last = p++;
+        bool matched = raw_key && p + n < end && data_[p + n] == '"' &&
+                       KeyEqual(reinterpret_cast<const char *>(data_ + p),
+                                key.data(), n);
+        if (matched) {
+          p += n + 1;
+        } else {
+          matched = scanner_.matchKey(data_, p, end, key, kbuf_, error_);
+          if (hasError()) return false;
+          if (!matched) continue;
+        }
+        while (p < end && IsSpace(data_[p])) p++;
+        // a string value
+        if (p >= end || data_[p] != ':') continue;
+        p++;
+        while (p < end && IsSpace(data_[p])) p++;
+        if (p >= end) {
+          setError(kParseErrorInvalidChar);
+          return false;
+        }
+        if (data_[p] == 'n') continue;
+        pos_ = p;
+        if (!collectJsonPath(path, index + 1, vals, gen)) return false;
+      }
+      if (cnt < kBatch) break;
+      from += cands[kBatch - 1];
+    }
+    pos_ = end;
+    return true;
+  }
+
+  // Select the children of the value at pos_ and its descendants by
+  // path[index], which is after `..`, in the document order, and collect the
+  // rest of the path on them. The containers are walked by an explicit stack,
+  // as the json may be nested deeply.
+  template <typename Generator>
+  inline bool collectDescendants(const JsonPath &path, size_t index,
+                                 std::vector<StringView> &vals,
+                                 Generator *gen) {
+    const JsonPathNode &node = path[index];
+    if (node.is_index() && node.index() < 0) {
+      setError(SonicError::kUnsupportedJsonPath);
+      return false;
+    }
+    if (node.is_key() && !node.is_index()) {
+      long start = skipValue();
+      if (start < 0) {
+        setError(SonicError(-start));
+        return false;
+      }
+      return collectDescendantKeys(size_t(start), path, index, vals, gen);
+    }
+    struct Level {
+      uint8_t close;
+      int64_t next;
+    };
+    std::vector<Level> levels;
+    auto c = peek();
+    if (hasError()) return false;
+    if (c != '{' && c != '[') {
+      return skipOne() == kErrorNone;
+    }
+    RETURN_FALSE_IF_PARSE_ERROR(consume(c));
+    levels.push_back({c == '{' ? uint8_t('}') : uint8_t(']'), 0});
+    while (!levels.empty()) {
+      Level &top = levels.back();
+      c = peek();
+      if (hasError()) return false;
+      if (c == top.close) {
+        RETURN_FALSE_IF_PARSE_ERROR(consume(c));
+        levels.pop_back();
+        continue;
+      }
+      const bool is_obj = top.close == '}';
+      const int64_t i = top.next++;
+      if (i > 0) RETURN_FALSE_IF_PARSE_ERROR(consume(','));
+      bool matched = false;
+      if (!matchChild(path, node, is_obj, i, node.is_index() ? node.index() : 0,
+                      gen, matched)) {
+        return false;
+      }
+      c = peek();
+      if (hasError()) return false;
+      if (matched && c != 'n') {
+        const size_t child = pos_;
+        if (!collectJsonPath(path, index + 1, vals, gen)) return false;
+        pos_ = child;
+      }
+      if (c == '{' || c == '[') {
+        RETURN_FALSE_IF_PARSE_ERROR(consume(c));
+        levels.push_back({c == '{' ? uint8_t('}') : uint8_t(']'), 0});
+      } else {
+        RETURN_FALSE_IF_PARSE_ERROR(skipOne());
+      }
+    }
+    return true;
+  }
+
+  // The paths with `..` or filters select the values as the dom: the values
+  // are in a flat list in the document order, without the nulls, and a single
+  // value is not wrapped in an array.
+  template <SerializeFlags serializeFlags = kSerializeJavaStyleFlag>
+  inline bool getJsonPathFlat(
+      const JsonPath &path,
+      JsonGeneratorInterface<serializeFlags> *jsonGenerator) {
+    std::vector<StringView> vals;
+    if (!collectJsonPath(path, 1, vals, jsonGenerator)) {
+      return false;
+    }
+    size_t cnt = 0;
+    for (const auto &v : vals) {
+      if (v[0] != 'n') vals[cnt++] = v;
+    }
+    if (cnt == 0) {
+      return false;
+    }
+    if (cnt == 1) {
+      if (!jsonGenerator->copyCurrentStructureSingleResult(vals[0])) {
+        setError(kParseErrorUnexpect);
+        return false;
+      }
+      return true;
+    }
+    jsonGenerator->writeStartArray();
+    for (size_t i = 0; i < cnt; i++) {
+      if (i > 0) jsonGenerator->writeComma();
+      if (!jsonGenerator->copyCurrentStructure(vals[i])) {
+        setError(kParseErrorUnexpect);
+        return false;
+      }
+    }
+    jsonGenerator->writeEndArray();
+    return true;
+  }
+
   template <WriteStyle style,
             SerializeFlags serializeFlags = kSerializeJavaStyleFlag>
   inline bool getJsonPath(
@@ -827,6 +1343,12 @@ class SkipScanner2 {
       return true;
     }
 
+    // the paths with `..` or filters are selected by getJsonPathFlat
+    if (path[index].is_descendant() || path[index].is_filter()) {
+      setError(SonicError::kUnsupportedJsonPath);
+      return false;
+    }
+
     if (c == '{' && path[index].is_key()) {
       RETURN_FALSE_IF_PARSE_ERROR(consume('{'));
       bool dirty = false;
@@ -930,8 +1452,13 @@ class SkipScanner2 {
       while (peek() != ']') {
         const auto index_plus_one = index + 1;
 
+        size_t pos_before = pos_;
         dirty |= getJsonPath<QUOTE, serializeFlags>(
             path, index_plus_one, jsonGenerator, jsonGeneratorFactory);
+        if (pos_ == pos_before) {
+          // the primitive value is not consumed if it doesn't match the path
+          RETURN_FALSE_IF_PARSE_ERROR(skipOne());
+        }
         RETURN_FALSE_IF_PARSE_ERROR(skipIfPresent(','));
       }
       RETURN_FALSE_IF_PARSE_ERROR(consume(']'));
@@ -983,6 +1510,7 @@ class SkipScanner2 {
       if (c == '{') {
         RETURN_FALSE_IF_PARSE_ERROR(consume('{'));
         while (peek() != '}') {
+          RETURN_FALSE_IF_PARSE_ERROR(consume('"'));
           // SkipString returns a status (0/1/2) but doesn't set error_.
           // Don't use RETURN_FALSE_IF_PARSE_ERROR here.
           if (!SkipString(data_, pos_, len_)) {
@@ -1102,6 +1630,9 @@ class SkipScanner2 {
   SonicError error_ = SonicError::kErrorNone;
   std::vector<uint8_t> kbuf_ = {};
   bool isFieldName = false;
+  // the containers skipped by the previous scans of the same json
+  SkipIndex *index_ = nullptr;
+  FilterScanner filter_;
 };
 }  // namespace internal
 }  // namespace sonic_json
@@ -42,6 +42,25 @@ sonic_force_inline bool SkipContainer(const uint8_t *data, size_t &pos,
       data, pos, len, left, right);
 }
 
+sonic_force_inline size_t IndexNewlines(const uint8_t *data, size_t len,
+                                        uint32_t *index) {
+  return index_newlines<sonic_json::internal::neon::simd8x64<uint8_t>>(
+      data, len, index);
+}
+
+sonic_force_inline size_t SplitArray(const uint8_t *data, size_t len,
+                                     size_t step, size_t *splits, size_t max) {
+  return split_array<sonic_json::internal::neon::simd8x64<uint8_t>>(
+      data, len, step, splits, max);
+}
+
+sonic_force_inline size_t IndexKeyCandidates(const uint8_t *data, size_t len,
+                                             const uint8_t *key, size_t n,
+                                             uint32_t *index, size_t max) {
+  return index_key_candidates<sonic_json::internal::neon::simd8x64<uint8_t>>(
+      data, len, key, n, index, max);
+}
+
 // TODO: optimize by removing bound checking.
 sonic_force_inline uint8_t skip_space(const uint8_t *data, size_t &pos,
                                       size_t &, uint64_t &) {
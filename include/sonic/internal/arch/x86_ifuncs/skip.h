@@ -41,6 +41,26 @@ __attribute__((target("default"))) inline bool SkipContainer(const uint8_t*,
   return 0;
 }
 
+__attribute__((target("default"))) inline size_t IndexNewlines(const uint8_t*,
+                                                               size_t,
+                                                               uint32_t*) {
+  // TODO static_assert(!!!"Not Implemented!");
+  return 0;
+}
+
+__attribute__((target("default"))) inline size_t SplitArray(const uint8_t*,
+                                                            size_t, size_t,
+                                                            size_t*, size_t) {
+  // TODO static_assert(!!!"Not Implemented!");
+  return 0;
+}
+
+__attribute__((target("default"))) inline size_t IndexKeyCandidates(
+    const uint8_t*, size_t, const uint8_t*, size_t, uint32_t*, size_t) {
+  // TODO static_assert(!!!"Not Implemented!");
+  return 0;
+}
+
 __attribute__((target("default"))) inline uint8_t skip_space(const uint8_t*,
                                                              size_t&, size_t&,
                                                              uint64_t&) {
@@ -64,6 +84,22 @@ __attribute__((target(SONIC_WESTMERE))) inline bool SkipContainer(
   return sse::SkipContainer(data, pos, len, left, right);
 }
 
+__attribute__((target(SONIC_WESTMERE))) inline size_t IndexNewlines(
+    const uint8_t* data, size_t len, uint32_t* index) {
+  return sse::IndexNewlines(data, len, index);
+}
+
+__attribute__((target(SONIC_WESTMERE))) inline size_t SplitArray(
+    const uint8_t* data, size_t len, size_t step, size_t* splits, size_t max) {
+  return sse::SplitArray(data, len, step, splits, max);
+}
+
+__attribute__((target(SONIC_WESTMERE))) inline size_t IndexKeyCandidates(
+    const uint8_t* data, size_t len, const uint8_t* key, size_t n,
+    uint32_t* index, size_t max) {
+  return sse::IndexKeyCandidates(data, len, key, n, index, max);
+}
+
 __attribute__((target(SONIC_WESTMERE))) inline uint8_t skip_space(
     const uint8_t* data, size_t& pos, size_t& nonspace_bits_end,
     uint64_t& nonspace_bits) {
@@ -86,6 +122,22 @@ __attribute__((target(SONIC_HASWELL))) inline bool SkipContainer(
   return avx2::SkipContainer(data, pos, len, left, right);
 }
 
+__attribute__((target(SONIC_HASWELL))) inline size_t IndexNewlines(
+    const uint8_t* data, size_t len, uint32_t* index) {
+  return avx2::IndexNewlines(data, len, index);
+}
+
+__attribute__((target(SONIC_HASWELL))) inline size_t SplitArray(
+    const uint8_t* data, size_t len, size_t step, size_t* splits, size_t max) {
+  return avx2::SplitArray(data, len, step, splits, max);
+}
+
+__attribute__((target(SONIC_HASWELL))) inline size_t IndexKeyCandidates(
+    const uint8_t* data, size_t len, const uint8_t* key, size_t n,
+    uint32_t* index, size_t max) {
+  return avx2::IndexKeyCandidates(data, len, key, n, index, max);
+}
+
 __attribute__((target(SONIC_HASWELL))) inline uint8_t skip_space(
     const uint8_t* data, size_t& pos, size_t& nonspace_bits_end,
     uint64_t& nonspace_bits) {
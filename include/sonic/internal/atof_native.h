@@ -8,6 +8,7 @@
 #pragma once
 
 #include <cstdint>
+#include <cstring>
 
 #include "sonic/internal/arch/simd_base.h"
 
@@ -883,6 +884,22 @@ static sonic_force_inline bool AtofEiselLemire64(uint64_t mant, int exp10,
 
 static sonic_force_inline bool is_digit(char c) { return '0' <= c && c <= '9'; }
 
+// Return the position of the first non-digit from s[i], by 8 bytes a time.
+// The buffer must be padded, as the parsed JSON.
+static sonic_force_inline size_t SkipDigits(const char *s, size_t i) {
+  while (true) {
+    uint64_t v;
+    std::memcpy(&v, s + i, 8);
+    // the digits are 0 ~ 9 after xor, and the others have the high bit set
+    // after adding 0x76.
+    uint64_t x = v ^ 0x3030303030303030ULL;
+    uint64_t m = (((x & 0x7F7F7F7F7F7F7F7FULL) + 0x7676767676767676ULL) | x) &
+                 0x8080808080808080ULL;
+    if (m != 0) return i + (TrailingZeroes(m) >> 3);
+    i += 8;
+  }
+}
+
 #define DECIMAL_MAX_DNUM 800
 /* decimal shift without overflow, e.g. 9 << 61 overflow */
 #define MAX_SHIFT 60
@@ -770,6 +770,17 @@ static sonic_force_inline unsigned Ctz10(const uint64_t v) {
 // Format Significand trimmed the trailing zeros.
 static sonic_force_inline char* FormatSignificand(uint64_t sig, char* out,
                                                   int cnt) {
+  /* the long significands are written by the SIMD kernel, 16 digits at once,
+     and have no trailing zeros to trim */
+  if (cnt >= 16) {
+    char* p = out;
+    if (cnt == 17) {
+      *p++ = (char)('0' + sig / 10000000000000000ull);
+      sig %= 10000000000000000ull;
+    }
+    Utoa_16(sig, p);
+    return out + cnt;
+  }
   char* p = out + cnt;
   int ctz = 0;
 
@@ -900,7 +911,16 @@ static sonic_force_inline char* FormatDecimal(F64Decimal v, char* out,
   /* insert point or add trailing zeros */
   int digs = end - p;
   if (digs > point) {
-    std::memmove(p + point + 1, p + point, digs - point);
+    /* move the fraction by fixed-size copies, it has at most 16 digits, and
+       at most 8 if point > 8 */
+    char tmp[16];
+    if (digs - point <= 8) {
+      std::memcpy(tmp, p + point, 8);
+      std::memcpy(p + point + 1, tmp, 8);
+    } else {
+      std::memcpy(tmp, p + point, 16);
+      std::memcpy(p + point + 1, tmp, 16);
+    }
     p[point] = '.';
     end++;
   } else {
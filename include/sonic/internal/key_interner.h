@@ -0,0 +1,149 @@
+/*
+ * Copyright 2022 ByteDance Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include "sonic/internal/arch/simd_base.h"
+#include "sonic/macro.h"
+#include "sonic/string_view.h"
+
+namespace sonic_json {
+namespace internal {
+
+// KeyInterner maps the object keys to their first occurrences while parsing.
+// It is an open addressing table probed by groups of 8 slots. Every slot has
+// a control byte, 0 for empty or 0x80 with 7 bits of the hash, and the 8
+// control bytes of a group are compared at once in a 64-bit word. The table
+// is small: long keys and the keys after kMaxKeys distinct ones are not
+// interned, since they are unlikely to repeat.
+class KeyInterner {
+ public:
+  KeyInterner() = default;
+
+  // Return the canonical copy of the key if it has been seen. Otherwise,
+  // return nullptr, and record the key as canonical if `insert` is true.
+  sonic_force_inline const char *Intern(StringView key, bool insert = true) {
+    size_t len = key.size();
+    if (sonic_unlikely(len > kMaxKeyLen)) return nullptr;
+    if (sonic_unlikely(ctrl_.empty())) grow();
+    uint64_t h = hash(key.data(), len);
+    uint64_t tag = 0x80 | (h >> 57);
+    size_t mask = ctrl_.size() - 1;
+    size_t g = h & mask;
+    while (true) {
+      uint64_t group = ctrl_[g];
+      // the zero bytes of x are the slots with the same tag, there may be
+      // false positives but no false negatives.
+      uint64_t x = group ^ (tag * kLsb);
+      uint64_t match = (x - kLsb) & ~x & kMsb;
+      while (match) {
+        size_t i = g * 8 + (TrailingZeroes(match) >> 3);
+        const StringView &s = slots_[i];
+        if (s.size() == len && std::memcmp(s.data(), key.data(), len) == 0) {
+          return s.data();
+        }
+        match &= match - 1;
+      }
+      uint64_t empty = ~group & kMsb;
+      if (empty) {
+        if (insert && size_ < kMaxKeys) {
+          size_t b = TrailingZeroes(empty) >> 3;
+          ctrl_[g] |= tag << (b * 8);
+          slots_[g * 8 + b] = key;
+          if (++size_ * 2 > ctrl_.size() * 8) grow();
+        }
+        return nullptr;
+      }
+      g = (g + 1) & mask;
+    }
+  }
+
+  // Forget the keys and keep the table memory.
+  void Reset() {
+    std::fill(ctrl_.begin(), ctrl_.end(), 0);
+    size_ = 0;
+    saved_ = 0;
+  }
+
+  // Record the bytes of a repeated key copy which is freed.
+  void AddSavedBytes(size_t n) { saved_ += n; }
+
+  // The total length of the repeated key copies which were freed.
+  size_t SavedBytes() const { return saved_; }
+
+  size_t Size() const { return size_; }
+
+ private:
+  constexpr static uint64_t kLsb = 0x0101010101010101ULL;
+  constexpr static uint64_t kMsb = 0x8080808080808080ULL;
+  constexpr static size_t kMaxKeys = 1024;
+  constexpr static size_t kMaxKeyLen = 128;
+  constexpr static size_t kInitGroups = 8;
+
+  static sonic_force_inline uint64_t load(const char *p, size_t n) {
+    uint64_t v = 0;
+    std::memcpy(&v, p, n);
+    return v;
+  }
+
+  // hash the head and tail 8 bytes and the length, the keys are short
+  static sonic_force_inline uint64_t hash(const char *p, size_t len) {
+    uint64_t a, b;
+    if (len >= 8) {
+      a = load(p, 8);
+      b = load(p + len - 8, 8);
+    } else if (len >= 4) {
+      a = load(p, 4);
+      b = load(p + len - 4, 4);
+    } else {
+      a = len ? load(p, len) : 0;
+      b = 0;
+    }
+    uint64_t h = (a ^ len) * 0x9E3779B97F4A7C15ULL;
+    h = (h ^ (h >> 29) ^ b) * 0xBF58476D1CE4E5B9ULL;
+    return h ^ (h >> 32);
+  }
+
+  void grow() {
+    size_t groups = ctrl_.empty() ? kInitGroups : ctrl_.size() * 2;
+    std::vector<uint64_t> ctrl(groups, 0);
+    std::vector<StringView> slots(groups * 8);
+    ctrl_.swap(ctrl);
+    slots_.swap(slots);
+    size_t n = size_;
+    size_ = 0;
+    for (size_t g = 0; g < ctrl.size() && n; g++) {
+      for (uint64_t full = ctrl[g] & kMsb; full; full &= full - 1) {
+        size_t i = g * 8 + (TrailingZeroes(full) >> 3);
+        Intern(slots[i]);
+        n--;
+      }
+    }
+  }
+
+  std::vector<uint64_t> ctrl_{};
+  std::vector<StringView> slots_{};
+  size_t size_{0};
+  size_t saved_{0};
+};
+
+}  // namespace internal
+}  // namespace sonic_json
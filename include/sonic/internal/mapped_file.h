@@ -0,0 +1,155 @@
+/*
+ * Copyright 2022 ByteDance Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "sonic/error.h"
+#include "sonic/macro.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define SONIC_HAS_MMAP 1
+#endif
+
+namespace sonic_json {
+namespace internal {
+
+// MappedFile maps a file into memory as read-only, followed by
+// SONICJSON_PADDING zero bytes at least. The zero bytes after the file are
+// anonymous pages reserved together with the mapping, so the file is neither
+// copied nor duplicated in page cache. The file must not be truncated while
+// it is mapped. Without mmap, the file is read into a padded buffer.
+class MappedFile {
+ public:
+  MappedFile() = default;
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+  MappedFile(MappedFile &&rhs) noexcept
+      : data_(rhs.data_), size_(rhs.size_), cap_(rhs.cap_) {
+    rhs.data_ = nullptr;
+    rhs.size_ = 0;
+    rhs.cap_ = 0;
+  }
+  MappedFile &operator=(MappedFile &&rhs) noexcept {
+    if (this != &rhs) {
+      Close();
+      data_ = rhs.data_;
+      size_ = rhs.size_;
+      cap_ = rhs.cap_;
+      rhs.data_ = nullptr;
+      rhs.size_ = 0;
+      rhs.cap_ = 0;
+    }
+    return *this;
+  }
+  ~MappedFile() { Close(); }
+
+  /**
+   * @brief Map the file, the mapped file before is closed.
+   * @return kErrorOpenFile if the file can't be opened or mapped.
+   */
+  SonicError Open(const char *path) {
+    Close();
+#ifdef SONIC_HAS_MMAP
+    int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return kErrorOpenFile;
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+      ::close(fd);
+      return kErrorOpenFile;
+    }
+    size_t len = static_cast<size_t>(st.st_size);
+    size_t page = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+    size_t cap = (len + SONICJSON_PADDING + page - 1) / page * page;
+    // reserve the zero pages, and then map the file over the beginning. The
+    // rest of the last file page is zero-filled by the kernel.
+    void *base = ::mmap(nullptr, cap, PROT_READ, MAP_PRIVATE | MAP_ANONYMOUS,
+                        -1, 0);
+    if (base == MAP_FAILED) {
+      ::close(fd);
+      return kErrorNoMem;
+    }
+    if (len > 0) {
+      void *p = ::mmap(base, len, PROT_READ, MAP_PRIVATE | MAP_FIXED, fd, 0);
+      if (p == MAP_FAILED) {
+        ::munmap(base, cap);
+        ::close(fd);
+        return kErrorOpenFile;
+      }
+      ::madvise(base, len, MADV_SEQUENTIAL);
+    }
+    ::close(fd);
+    data_ = static_cast<char *>(base);
+#else
+    std::FILE *fp = std::fopen(path, "rb");
+    if (fp == nullptr) return kErrorOpenFile;
+    long end = -1;
+    if (std::fseek(fp, 0, SEEK_END) == 0) end = std::ftell(fp);
+    if (end < 0 || std::fseek(fp, 0, SEEK_SET) != 0) {
+      std::fclose(fp);
+      return kErrorOpenFile;
+    }
+    size_t len = static_cast<size_t>(end);
+    size_t cap = len + SONICJSON_PADDING;
+    data_ = static_cast<char *>(std::calloc(cap, 1));
+    if (data_ == nullptr) {
+      std::fclose(fp);
+      return kErrorNoMem;
+    }
+    size_t n = std::fread(data_, 1, len, fp);
+    std::fclose(fp);
+    if (n != len) {
+      std::free(data_);
+      data_ = nullptr;
+      return kErrorOpenFile;
+    }
+#endif
+    size_ = len;
+    cap_ = cap;
+    return kErrorNone;
+  }
+
+  void Close() {
+    if (data_ == nullptr) return;
+#ifdef SONIC_HAS_MMAP
+    ::munmap(data_, cap_);
+#else
+    std::free(data_);
+#endif
+    data_ = nullptr;
+    size_ = 0;
+    cap_ = 0;
+  }
+
+  sonic_force_inline const char *Data() const { return data_; }
+  sonic_force_inline size_t Size() const { return size_; }
+
+ private:
+  char *data_{nullptr};
+  size_t size_{0};
+  size_t cap_{0};
+};
+
+}  // namespace internal
+}  // namespace sonic_json
@@ -0,0 +1,223 @@
+/*
+ * Copyright 2022 ByteDance Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <new>
+
+#include "sonic/internal/arch/simd_base.h"
+#include "sonic/internal/utils.h"
+#include "sonic/macro.h"
+#include "sonic/string_view.h"
+
+namespace sonic_json {
+namespace internal {
+
+// MemberIndex is the hash index of the object members, which maps the keys to
+// the positions of members. It is an open addressing table probed by groups
+// of 8 slots, as KeyInterner. Every slot has a control byte: 0 for empty,
+// kDeleted for erased, or 0x80 with 7 bits of the hash. The slots only keep
+// the 32-bit positions, and the keys are compared with the members.
+//
+// The header, control bytes and positions are in one block from the node
+// allocator. The new entries are never put into the erased slots, so the
+// duplicated keys are found in the order they are added.
+class MemberIndex {
+ public:
+  /**
+   * @brief Build the index for n keys, `key(i)` returns the i-th key.
+   * @return nullptr if no memory can be allocated.
+   */
+  template <typename Allocator, typename GetKey>
+  static MemberIndex *Build(size_t n, GetKey &&key, Allocator &alloc) {
+    size_t groups = 1;
+    while (groups * kGroupLimit < n + 1) groups *= 2;
+    void *mem = alloc.Malloc(allocSize(groups));
+    if (sonic_unlikely(mem == nullptr)) return nullptr;
+    MemberIndex *index = new (mem) MemberIndex(groups);
+    std::memset(static_cast<void *>(index->ctrl()), 0,
+                groups * sizeof(uint64_t));
+    for (size_t i = 0; i < n; i++) {
+      index->insert(Hash(key(i)), static_cast<uint32_t>(i));
+    }
+    return index;
+  }
+
+  /**
+   * @brief Find the first added entry of the key.
+   * @return the position slot, or nullptr if not found.
+   */
+  template <typename GetKey>
+  sonic_force_inline uint32_t *Find(StringView key, GetKey &&key_at) {
+    uint64_t h = Hash(key);
+    uint64_t tag = 0x80 | (h >> 57);
+    size_t g = h & mask_;
+    while (true) {
+      uint64_t group = ctrl()[g];
+      // the zero bytes of x are the slots with the same tag, there may be
+      // false positives but no false negatives.
+      uint64_t x = group ^ (tag * kLsb);
+      uint64_t match = (x - kLsb) & ~x & kMsb;
+      while (match) {
+        uint32_t *slot = slots() + g * 8 + (TrailingZeroes(match) >> 3);
+        StringView s = key_at(*slot);
+        if (s.size() == key.size() &&
+            KeyEqual(s.data(), key.data(), key.size())) {
+          return slot;
+        }
+        match &= match - 1;
+      }
+      if (hasEmpty(group)) return nullptr;
+      g = (g + 1) & mask_;
+    }
+  }
+
+  /**
+   * @brief Find the entry of the key at position `pos`.
+   */
+  sonic_force_inline uint32_t *FindPos(StringView key, uint32_t pos) {
+    uint64_t h = Hash(key);
+    uint64_t tag = 0x80 | (h >> 57);
+    size_t g = h & mask_;
+    while (true) {
+      uint64_t group = ctrl()[g];
+      uint64_t x = group ^ (tag * kLsb);
+      uint64_t match = (x - kLsb) & ~x & kMsb;
+      while (match) {
+        uint32_t *slot = slots() + g * 8 + (TrailingZeroes(match) >> 3);
+        if (*slot == pos) return slot;
+        match &= match - 1;
+      }
+      if (hasEmpty(group)) return nullptr;
+      g = (g + 1) & mask_;
+    }
+  }
+
+  /**
+   * @brief Add an entry for the member at `pos`.
+   * @retval false the index is full and should be rebuilt.
+   */
+  sonic_force_inline bool Add(StringView key, uint32_t pos) {
+    if (sonic_unlikely(used_ + 1 > (mask_ + 1) * kGroupLimit)) return false;
+    insert(Hash(key), pos);
+    return true;
+  }
+
+  /**
+   * @brief Erase the entry returned by Find or FindPos.
+   */
+  sonic_force_inline void Erase(uint32_t *slot) {
+    size_t i = slot - slots();
+    uint64_t shift = (i & 7) * 8;
+    uint64_t &group = ctrl()[i >> 3];
+    group = (group & ~(uint64_t(0xFF) << shift)) | (kDeleted << shift);
+    size_--;
+  }
+
+  size_t Size() const { return size_; }
+
+  static sonic_force_inline uint64_t Hash(StringView key) {
+    const char *p = key.data();
+    size_t len = key.size();
+    uint64_t h = len * 0x9E3779B97F4A7C15ULL;
+    uint64_t tail;
+    if (len >= 8) {
+      for (; len > 8; len -= 8, p += 8) {
+        h = (h ^ load<8>(p)) * 0xBF58476D1CE4E5B9ULL;
+        h ^= h >> 31;
+      }
+      // the last 8 bytes, overlapped with the previous ones
+      tail = load<8>(p + len - 8);
+    } else if (len >= 4) {
+      tail = load<4>(p) | (load<4>(p + len - 4) << 32);
+    } else if (len > 0) {
+      tail = uint8_t(p[0]) | (uint64_t(uint8_t(p[len / 2])) << 8) |
+             (uint64_t(uint8_t(p[len - 1])) << 16);
+    } else {
+      tail = 0;
+    }
+    h = (h ^ tail) * 0x94D049BB133111EBULL;
+    h ^= h >> 29;
+    h *= 0xBF58476D1CE4E5B9ULL;
+    return h ^ (h >> 32);
+  }
+
+ private:
+  constexpr static uint64_t kLsb = 0x0101010101010101ULL;
+  constexpr static uint64_t kMsb = 0x8080808080808080ULL;
+  constexpr static uint64_t kDeleted = 0x01;
+  // at most 7 of 8 slots are used, including the erased ones
+  constexpr static size_t kGroupLimit = 7;
+
+  explicit MemberIndex(size_t groups)
+      : mask_(static_cast<uint32_t>(groups - 1)) {}
+
+  static size_t allocSize(size_t groups) {
+    return sizeof(MemberIndex) + groups * sizeof(uint64_t) +
+           groups * 8 * sizeof(uint32_t);
+  }
+
+  // the fixed size copies are single loads
+  template <size_t N>
+  static sonic_force_inline uint64_t load(const char *p) {
+    uint64_t v = 0;
+    std::memcpy(&v, p, N);
+    return v;
+  }
+
+  // The lowest zero byte is found exactly, and the erased slots are not
+  // zero.
+  static sonic_force_inline bool hasEmpty(uint64_t group) {
+    return ((group - kLsb) & ~group & kMsb) != 0;
+  }
+
+  sonic_force_inline uint64_t *ctrl() {
+    return reinterpret_cast<uint64_t *>(this + 1);
+  }
+
+  sonic_force_inline uint32_t *slots() {
+    return reinterpret_cast<uint32_t *>(ctrl() + mask_ + 1);
+  }
+
+  sonic_force_inline void insert(uint64_t h, uint32_t pos) {
+    uint64_t tag = 0x80 | (h >> 57);
+    size_t g = h & mask_;
+    while (true) {
+      uint64_t group = ctrl()[g];
+      uint64_t empty = (group - kLsb) & ~group & kMsb;
+      if (empty) {
+        size_t b = TrailingZeroes(empty) >> 3;
+        ctrl()[g] = group | (tag << (b * 8));
+        slots()[g * 8 + b] = pos;
+        size_++;
+        used_++;
+        return;
+      }
+      g = (g + 1) & mask_;
+    }
+  }
+
+  uint32_t mask_;
+  uint32_t size_{0};
+  // the entries and the erased slots
+  uint32_t used_{0};
+  uint32_t reserved_{0};
+};
+
+}  // namespace internal
+}  // namespace sonic_json
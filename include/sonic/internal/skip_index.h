@@ -0,0 +1,146 @@
+/*
+ * Copyright 2022 ByteDance Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "sonic/allocator.h"
+#include "sonic/internal/member_index.h"
+#include "sonic/macro.h"
+#include "sonic/string_view.h"
+
+namespace sonic_json {
+namespace internal {
+
+// SkipIndex records the structure of a json found by the on-demand scans, so
+// the later scans of the same json jump over the known parts. It has the end
+// of every skipped container, and the members of every container which is
+// looked up, with a MemberIndex for the large objects. The positions are the
+// offsets of the first char of the values. It is built lazily, only the
+// visited parts of the json are indexed.
+class SkipIndex {
+ public:
+  struct Member {
+    // the unescaped key, empty for the array elements
+    StringView key;
+    uint32_t value;
+  };
+
+  struct Container {
+    // the offset after the closing bracket
+    uint32_t end{0};
+    // the members are members_[first, first + count) when scanned
+    uint32_t first{0};
+    uint32_t count{kNotScanned};
+    MemberIndex *map{nullptr};
+  };
+
+  constexpr static uint32_t kNotScanned = UINT32_MAX;
+  // the objects with more members are looked up by a MemberIndex
+  constexpr static uint32_t kMapThreshold = 16;
+
+  SkipIndex() = default;
+  SkipIndex(const SkipIndex &) = delete;
+  SkipIndex &operator=(const SkipIndex &) = delete;
+  ~SkipIndex() { Clear(); }
+
+  void Clear() {
+    for (auto &c : containers_) {
+      if (c.second.map) SimpleAllocator::Free(c.second.map);
+    }
+    containers_.clear();
+    members_.clear();
+    keys_.clear();
+  }
+
+  // The end of the container at `start`, or 0 if unknown.
+  sonic_force_inline uint32_t End(size_t start) const {
+    auto it = containers_.find(static_cast<uint32_t>(start));
+    return it == containers_.end() ? 0 : it->second.end;
+  }
+
+  sonic_force_inline void SetEnd(size_t start, size_t end) {
+    containers_[static_cast<uint32_t>(start)].end =
+        static_cast<uint32_t>(end);
+  }
+
+  sonic_force_inline Container &Get(size_t start) {
+    return containers_[static_cast<uint32_t>(start)];
+  }
+
+  // The members of a scanned container.
+  sonic_force_inline const Member *Members(const Container &c) const {
+    return members_.data() + c.first;
+  }
+
+  // Add a member of the container being scanned, the members of a container
+  // are added together.
+  sonic_force_inline void AddMember(StringView key, size_t value) {
+    members_.push_back(Member{key, static_cast<uint32_t>(value)});
+  }
+
+  // Keep a copy of the unescaped key.
+  StringView SaveKey(StringView key) {
+    keys_.emplace_back(key.data(), key.size());
+    return StringView(keys_.back());
+  }
+
+  sonic_force_inline size_t MemberCount() const { return members_.size(); }
+
+  // Discard the members added after `n`, when the scan failed.
+  sonic_force_inline void DropMembers(size_t n) { members_.resize(n); }
+
+  // Finish the scan of the container with the members after `first`.
+  void SetScanned(Container &c, size_t first, size_t end, bool is_obj) {
+    c.first = static_cast<uint32_t>(first);
+    c.count = static_cast<uint32_t>(members_.size() - first);
+    c.end = static_cast<uint32_t>(end);
+    if (is_obj && c.count > kMapThreshold) {
+      SimpleAllocator alloc;
+      const Member *m = Members(c);
+      c.map = MemberIndex::Build(
+          c.count, [m](size_t i) { return m[i].key; }, alloc);
+    }
+  }
+
+  // The first member with the key in a scanned object, or nullptr.
+  const Member *FindKey(const Container &c, StringView key) const {
+    const Member *m = Members(c);
+    if (c.map) {
+      uint32_t *slot =
+          c.map->Find(key, [m](uint32_t i) { return m[i].key; });
+      return slot ? m + *slot : nullptr;
+    }
+    for (uint32_t i = 0; i < c.count; i++) {
+      if (m[i].key == key) return m + i;
+    }
+    return nullptr;
+  }
+
+ private:
+  std::unordered_map<uint32_t, Container> containers_;
+  std::vector<Member> members_;
+  // the unescaped keys, their addresses are stable in a deque
+  std::deque<std::string> keys_;
+};
+
+}  // namespace internal
+}  // namespace sonic_json
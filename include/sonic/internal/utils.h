@@ -17,6 +17,9 @@
 #pragma once
 
 #include <cstdint>
+#include <cstring>
+
+#include "sonic/macro.h"
 
 namespace sonic_json {
 namespace internal {
@@ -25,5 +28,33 @@ static sonic_force_inline bool IsSpace(uint8_t ch) {
   return ch == ' ' || ch == '\r' || ch == '\n' || ch == '\t';
 }
 
+// KeyEqual compares the short strings of the same length, such as the object
+// keys. It only reads the bytes of the strings: the head and tail words
+// overlap for the strings not longer than 16 bytes.
+static sonic_force_inline bool KeyEqual(const char *a, const char *b,
+                                        size_t n) {
+  if (a == b) return true;
+  if (n >= 8) {
+    uint64_t x, y;
+    std::memcpy(&x, a, 8);
+    std::memcpy(&y, b, 8);
+    if (x != y) return false;
+    if (n > 16) return std::memcmp(a + 8, b + 8, n - 8) == 0;
+    std::memcpy(&x, a + n - 8, 8);
+    std::memcpy(&y, b + n - 8, 8);
+    return x == y;
+  }
+  if (n >= 4) {
+    uint32_t x, y, u, v;
+    std::memcpy(&x, a, 4);
+    std::memcpy(&y, b, 4);
+    std::memcpy(&u, a + n - 4, 4);
+    std::memcpy(&v, b + n - 4, 4);
+    return x == y && u == v;
+  }
+  if (n == 0) return true;
+  return a[0] == b[0] && a[n >> 1] == b[n >> 1] && a[n - 1] == b[n - 1];
+}
+
 }  // namespace internal
 }  // namespace sonic_json
@@ -6,8 +6,9 @@
 
 namespace sonic_json {
 
+template <typename PathType>
 sonic_force_inline std::tuple<std::string, SonicError> GetByJsonPathInternal(
-    Document& dom, StringView jsonpath) {
+    Document& dom, const PathType& jsonpath) {
   // get the nodes
   auto result = dom.AtJsonPath(jsonpath);
   if (result.error != kErrorNone) {
@@ -69,6 +70,17 @@ sonic_force_inline std::tuple<std::string, SonicError> GetByJsonPath(
   return GetByJsonPathInternal(dom, jsonpath);
 }
 
+// Same as GetByJsonPath(json, plan.GetJsonPath()) without parsing the path.
+sonic_force_inline std::tuple<std::string, SonicError> GetByJsonPath(
+    StringView json, const JsonPathPlan& plan) {
+  Document dom;
+  dom.Parse(json);
+  if (dom.HasParseError()) {
+    return std::make_tuple("", dom.GetParseError());
+  }
+  return GetByJsonPathInternal(dom, plan);
+}
+
 sonic_force_inline
     std::tuple<std::vector<std::tuple<std::string, SonicError>>, SonicError>
     GetByJsonPaths(StringView json, const std::vector<StringView>& jsonpaths) {
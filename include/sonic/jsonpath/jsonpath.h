@@ -6,12 +6,15 @@
 #include <cinttypes>
 #include <cstdint>
 #include <cstring>
+#include <limits>
 #include <sstream>
 #include <stack>
 #include <string>
 #include <vector>
 
+#include "sonic/dom/json_pointer.h"
 #include "sonic/internal/arch/common/unicode_common.h"
+#include "sonic/internal/atof_native.h"
 #include "sonic/string_view.h"
 
 namespace sonic_json {
@@ -23,6 +26,9 @@ static constexpr char ROOT = '$';
 static constexpr char IS_KEY = '\x01';
 static constexpr char IS_INDEX = '\x02';
 static constexpr char KEY_OR_INDEX = '\x03';
+static constexpr char FILTER = '?';
+// `..`, the descendants are selected by the next node
+static constexpr char DESCENDANT = '.';
 
 class JsonPathNode {
  public:
@@ -32,6 +38,8 @@ class JsonPathNode {
   JsonPathNode(StringView key, int64_t index) noexcept
       : index_(index), key_(key), token_(KEY_OR_INDEX) {}
   JsonPathNode(char token) noexcept : token_(token) {}
+  JsonPathNode(char token, int64_t index) noexcept
+      : index_(index), token_(token) {}
   ~JsonPathNode() = default;
 
  public:
@@ -47,6 +55,16 @@ class JsonPathNode {
 
   bool is_none() const noexcept { return token_ == NONE; }
 
+  bool is_filter() const noexcept { return token_ == FILTER; }
+
+  bool is_descendant() const noexcept { return token_ == DESCENDANT; }
+
+  // the id of the filter in the JsonPath
+  size_t filter() const noexcept {
+    sonic_assert(is_filter());
+    return static_cast<size_t>(index_);
+  }
+
   bool is_root() const noexcept { return token_ == ROOT; }
 
   StringView key() const noexcept {
@@ -80,6 +98,14 @@ class JsonPathNode {
         ss << "ROOT($)";
         break;
 
+      case FILTER:
+        ss << "FILTER(" << index_ << ")";
+        break;
+
+      case DESCENDANT:
+        ss << "DESCENDANT(..)";
+        break;
+
       case IS_KEY:
         ss << "KEY(\"";
         for (char c : key_) {
@@ -141,9 +167,162 @@ sonic_force_inline std::string paddingJsonPath(StringView path) {
   return padded;
 }
 
+// FilterValue is a json value compared by the filters.
+struct FilterValue {
+  enum Kind : uint8_t {
+    kNothing,  // the query selects nothing
+    kNull,
+    kTrue,
+    kFalse,
+    kNumber,
+    kString,
+    kContainer,  // an object or array, compared by the engine
+  };
+
+  Kind kind = kNothing;
+  double num = 0;
+  // the unescaped string, or the raw text of a container
+  StringView str;
+  // the node of a container in the dom
+  const void* node = nullptr;
+};
+
+/**
+ * JsonPathFilter is a filter selector such as `[?(@.price > 10 && @.id)]`. It
+ * is a logical expression (||, &&, !) of the comparisons and existence tests,
+ * whose operands are the literals or the singular queries relative to the
+ * current value, such as `@.a.b` or `@[0]`. The engines get the values of the
+ * queries, and Eval() tests them as RFC 9535.
+ */
+class JsonPathFilter {
+ public:
+  enum Op : uint8_t { kOr, kAnd, kNot, kExist, kEq, kNe, kLt, kLe, kGt, kGe };
+
+  struct Expr {
+    Op op;
+    // the sub-expressions of ||, && and !, or the operands of the others
+    uint32_t lhs;
+    uint32_t rhs;
+  };
+
+  struct Operand {
+    // the id of the query, or -1 for a literal
+    int32_t query = -1;
+    FilterValue literal;
+  };
+
+  // The relative queries without the leading '@'.
+  const std::vector<JsonPointerView>& Queries() const { return queries_; }
+
+  // The trie of the queries, to get all of them by one scan.
+  const JsonPointerTrie& QueryTrie() const { return trie_; }
+
+  /**
+   * @brief Test the values of the queries, `values[i]` is the value of the
+   * i-th query. `equal(a, b)` compares two containers.
+   */
+  template <typename ContainerEqual>
+  bool Eval(const FilterValue* values, ContainerEqual&& equal) const {
+    return eval(root_, values, equal);
+  }
+
+  uint32_t AddQuery(JsonPointerView&& query) {
+    trie_.Add(query);
+    queries_.emplace_back(std::move(query));
+    return static_cast<uint32_t>(queries_.size() - 1);
+  }
+
+  uint32_t AddOperand(const Operand& operand) {
+    operands_.push_back(operand);
+    return static_cast<uint32_t>(operands_.size() - 1);
+  }
+
+  uint32_t AddExpr(Op op, uint32_t lhs, uint32_t rhs) {
+    exprs_.push_back(Expr{op, lhs, rhs});
+    return static_cast<uint32_t>(exprs_.size() - 1);
+  }
+
+  void SetRoot(uint32_t expr) { root_ = expr; }
+
+ private:
+  template <typename ContainerEqual>
+  bool eval(uint32_t id, const FilterValue* values,
+            ContainerEqual& equal) const {
+    const Expr& e = exprs_[id];
+    switch (e.op) {
+      case kOr:
+        return eval(e.lhs, values, equal) || eval(e.rhs, values, equal);
+      case kAnd:
+        return eval(e.lhs, values, equal) && eval(e.rhs, values, equal);
+      case kNot:
+        return !eval(e.lhs, values, equal);
+      case kExist:
+        return operand(e.lhs, values).kind != FilterValue::kNothing;
+      default:
+        break;
+    }
+    const FilterValue& a = operand(e.lhs, values);
+    const FilterValue& b = operand(e.rhs, values);
+    switch (e.op) {
+      case kEq:
+        return isEqual(a, b, equal);
+      case kNe:
+        return !isEqual(a, b, equal);
+      case kLt:
+        return isLess(a, b);
+      case kLe:
+        return isLess(a, b) || isEqual(a, b, equal);
+      case kGt:
+        return isLess(b, a);
+      default:
+        return isLess(b, a) || isEqual(a, b, equal);
+    }
+  }
+
+  const FilterValue& operand(uint32_t id, const FilterValue* values) const {
+    const Operand& o = operands_[id];
+    return o.query >= 0 ? values[o.query] : o.literal;
+  }
+
+  // Nothing is only equal to Nothing.
+  template <typename ContainerEqual>
+  static bool isEqual(const FilterValue& a, const FilterValue& b,
+                      ContainerEqual& equal) {
+    if (a.kind != b.kind) return false;
+    switch (a.kind) {
+      case FilterValue::kNumber:
+        return a.num == b.num;
+      case FilterValue::kString:
+        return a.str == b.str;
+      case FilterValue::kContainer:
+        return equal(a, b);
+      default:
+        return true;
+    }
+  }
+
+  // Only the numbers and the strings are ordered.
+  static bool isLess(const FilterValue& a, const FilterValue& b) {
+    if (a.kind != b.kind) return false;
+    if (a.kind == FilterValue::kNumber) return a.num < b.num;
+    if (a.kind == FilterValue::kString) return a.str < b.str;
+    return false;
+  }
+
+  std::vector<JsonPointerView> queries_;
+  JsonPointerTrie trie_;
+  std::vector<Operand> operands_;
+  std::vector<Expr> exprs_;
+  uint32_t root_{0};
+};
+
 /**
  * Represent a JSON path. RFC is https://datatracker.ietf.org/doc/rfc9535/.
- * NOTE: descendant, slice, filter and current node not support.
+ * NOTE: slice not support. The descendant `..` must be followed by a name,
+ * `*` or a bracketed selector, such as `$..id` or `$..[0]`, and selects in
+ * the document order. The filters only support the comparisons, existence
+ * tests and logical operators, and the queries in the filters must be singular
+ * queries relative to the current node.
  */
 class JsonPath : public std::vector<JsonPathNode> {
  private:
@@ -151,6 +330,10 @@ class JsonPath : public std::vector<JsonPathNode> {
   // - parseQuotedName() can do in-place unescaping safely
   // - unescape_with_padding() can read past logical end without OOB
   std::string padded_;
+  std::vector<JsonPathFilter> filters_;
+
+  // limit the nesting of the filter expressions
+  static constexpr int kMaxFilterDepth = 64;
 
   // Parse using a caller-provided padded, writable buffer.
   // The caller must ensure `padded.data()` points to a buffer that has at least
@@ -171,8 +354,14 @@ class JsonPath : public std::vector<JsonPathNode> {
     while (i < p.size()) {
       valid = false;
 
-      if (i + 2 < p.size() && p[i] == '.' && p[i + 1] == '.') {
-        return false;
+      if (i + 1 < p.size() && p[i] == '.' && p[i + 1] == '.') {
+        // the selector after `..` is parsed as a child segment
+        this->emplace_back(JsonPathNode(DESCENDANT));
+        i++;
+        if (i + 1 < p.size() && p[i + 1] == '[') {
+          i++;
+          continue;
+        }
       }
 
       if (p[i] == '.') {
@@ -202,7 +391,9 @@ class JsonPath : public std::vector<JsonPathNode> {
           return false;
         }
 
-        if (p[i] == '\'' || p[i] == '"') {
+        if (p[i] == '?') {
+          valid = parseFilter(p, i, node);
+        } else if (p[i] == '\'' || p[i] == '"') {
           valid = parseQuotedName(p, i, node);
         } else if ((p[i] >= '0' && p[i] <= '9') || p[i] == '-') {
           valid = parseBracketedIndex(p, i, node);
@@ -292,6 +483,23 @@ class JsonPath : public std::vector<JsonPathNode> {
   // case as ['abc']  or ["abc"]
   sonic_force_inline bool parseQuotedName(StringView path, size_t& index,
                                           JsonPathNode& node) {
+    StringView name;
+    if (!parseQuotedString(path, index, name)) {
+      return false;
+    }
+    node = JsonPathNode(name);
+    // Expect ']' after the closing quote.
+    if (index >= path.size() || path[index] != ']') {
+      return false;
+    }
+    index++;
+    return true;
+  }
+
+  // case as 'abc' or "abc", unescaped inplace, the index is after the closing
+  // quote.
+  sonic_force_inline bool parseQuotedString(StringView path, size_t& index,
+                                            StringView& str) {
     if (index >= path.size()) {
       return false;
     }
@@ -335,15 +543,268 @@ class JsonPath : public std::vector<JsonPathNode> {
     }
     len = static_cast<size_t>(dst - (base + start));
 
-    const size_t quote_pos = static_cast<size_t>(src - base);
-    node = JsonPathNode(path.substr(start, len));
-    // Expect closing quote then ']'.
-    if (quote_pos + 1 >= n || base[quote_pos + 1] != ']') {
+    str = path.substr(start, len);
+    index = static_cast<size_t>(src - base) + 1;
+    return true;
+  }
+
+  static sonic_force_inline void skipBlank(StringView path, size_t& index) {
+    while (index < path.size() &&
+           (path[index] == ' ' || path[index] == '\t' || path[index] == '\n' ||
+            path[index] == '\r')) {
+      index++;
+    }
+  }
+
+  static sonic_force_inline bool matchToken(StringView path, size_t& index,
+                                            StringView token) {
+    if (path.substr(index, token.size()) != token) {
+      return false;
+    }
+    index += token.size();
+    return true;
+  }
+
+  // case as [?(@.a > 1)] or [?@.a > 1], the index is at '?'
+  bool parseFilter(StringView path, size_t& index, JsonPathNode& node) {
+    index++;
+    JsonPathFilter filter;
+    uint32_t root = 0;
+    if (!parseFilterOr(path, index, filter, root, 0)) {
+      return false;
+    }
+    skipBlank(path, index);
+    if (index >= path.size() || path[index] != ']') {
+      return false;
+    }
+    index++;
+    filter.SetRoot(root);
+    node = JsonPathNode(FILTER, static_cast<int64_t>(filters_.size()));
+    filters_.push_back(std::move(filter));
+    return true;
+  }
+
+  bool parseFilterOr(StringView path, size_t& index, JsonPathFilter& filter,
+                     uint32_t& expr, int depth) {
+    if (depth > kMaxFilterDepth ||
+        !parseFilterAnd(path, index, filter, expr, depth)) {
       return false;
     }
+    while (true) {
+      skipBlank(path, index);
+      if (!matchToken(path, index, "||")) {
+        return true;
+      }
+      uint32_t rhs = 0;
+      if (!parseFilterAnd(path, index, filter, rhs, depth)) {
+        return false;
+      }
+      expr = filter.AddExpr(JsonPathFilter::kOr, expr, rhs);
+    }
+  }
 
-    index = quote_pos + 2;
+  bool parseFilterAnd(StringView path, size_t& index, JsonPathFilter& filter,
+                      uint32_t& expr, int depth) {
+    if (!parseFilterUnary(path, index, filter, expr, depth)) {
+      return false;
+    }
+    while (true) {
+      skipBlank(path, index);
+      if (!matchToken(path, index, "&&")) {
+        return true;
+      }
+      uint32_t rhs = 0;
+      if (!parseFilterUnary(path, index, filter, rhs, depth)) {
+        return false;
+      }
+      expr = filter.AddExpr(JsonPathFilter::kAnd, expr, rhs);
+    }
+  }
 
+  // case as !expr, (expr), @.a == 1 or @.a
+  bool parseFilterUnary(StringView path, size_t& index, JsonPathFilter& filter,
+                        uint32_t& expr, int depth) {
+    skipBlank(path, index);
+    if (index >= path.size() || depth > kMaxFilterDepth) {
+      return false;
+    }
+    if (path[index] == '!') {
+      index++;
+      uint32_t sub = 0;
+      if (!parseFilterUnary(path, index, filter, sub, depth + 1)) {
+        return false;
+      }
+      expr = filter.AddExpr(JsonPathFilter::kNot, sub, 0);
+      return true;
+    }
+    if (path[index] == '(') {
+      index++;
+      if (!parseFilterOr(path, index, filter, expr, depth + 1)) {
+        return false;
+      }
+      skipBlank(path, index);
+      if (index >= path.size() || path[index] != ')') {
+        return false;
+      }
+      index++;
+      return true;
+    }
+
+    JsonPathFilter::Operand lhs, rhs;
+    if (!parseFilterOperand(path, index, filter, lhs)) {
+      return false;
+    }
+    skipBlank(path, index);
+    JsonPathFilter::Op op;
+    if (matchToken(path, index, "==")) {
+      op = JsonPathFilter::kEq;
+    } else if (matchToken(path, index, "!=")) {
+      op = JsonPathFilter::kNe;
+    } else if (matchToken(path, index, "<=")) {
+      op = JsonPathFilter::kLe;
+    } else if (matchToken(path, index, ">=")) {
+      op = JsonPathFilter::kGe;
+    } else if (matchToken(path, index, "<")) {
+      op = JsonPathFilter::kLt;
+    } else if (matchToken(path, index, ">")) {
+      op = JsonPathFilter::kGt;
+    } else {
+      // existence test of the query
+      if (lhs.query < 0) {
+        return false;
+      }
+      expr = filter.AddExpr(JsonPathFilter::kExist, filter.AddOperand(lhs), 0);
+      return true;
+    }
+    skipBlank(path, index);
+    if (!parseFilterOperand(path, index, filter, rhs)) {
+      return false;
+    }
+    expr = filter.AddExpr(op, filter.AddOperand(lhs), filter.AddOperand(rhs));
+    return true;
+  }
+
+  // case as @.a['b'][0], 'str', -1.5e3, true, false or null
+  bool parseFilterOperand(StringView path, size_t& index,
+                          JsonPathFilter& filter,
+                          JsonPathFilter::Operand& operand) {
+    if (index >= path.size()) {
+      return false;
+    }
+    FilterValue& v = operand.literal;
+    char c = path[index];
+    if (c == '@') {
+      index++;
+      JsonPointerView query;
+      if (!parseRelativeQuery(path, index, query)) {
+        return false;
+      }
+      operand.query = static_cast<int32_t>(filter.AddQuery(std::move(query)));
+      return true;
+    }
+    if (c == '\'' || c == '"') {
+      v.kind = FilterValue::kString;
+      return parseQuotedString(path, index, v.str);
+    }
+    if (c == '-' || (c >= '0' && c <= '9')) {
+      v.kind = FilterValue::kNumber;
+      return parseNumberLiteral(path, index, v.num);
+    }
+    if (matchToken(path, index, "true")) {
+      v.kind = FilterValue::kTrue;
+    } else if (matchToken(path, index, "false")) {
+      v.kind = FilterValue::kFalse;
+    } else if (matchToken(path, index, "null")) {
+      v.kind = FilterValue::kNull;
+    } else {
+      // the absolute queries and functions are not supported
+      return false;
+    }
+    return true;
+  }
+
+  // case as .a, ['a'] or [0] after '@'
+  bool parseRelativeQuery(StringView path, size_t& index,
+                          JsonPointerView& query) {
+    while (index < path.size()) {
+      if (path[index] == '.') {
+        size_t start = ++index;
+        while (index < path.size() && isNameChar(path[index])) {
+          index++;
+        }
+        if (index == start) {
+          return false;
+        }
+        query.emplace_back(path.substr(start, index - start));
+      } else if (path[index] == '[') {
+        index++;
+        if (index < path.size() && path[index] >= '0' && path[index] <= '9') {
+          uint64_t sum = 0;
+          if (!parseNumber(path, index, sum) ||
+              sum > static_cast<uint64_t>(std::numeric_limits<int>::max())) {
+            return false;
+          }
+          query.emplace_back(static_cast<int>(sum));
+        } else {
+          StringView name;
+          if (!parseQuotedString(path, index, name)) {
+            return false;
+          }
+          query.emplace_back(name);
+        }
+        if (index >= path.size() || path[index] != ']') {
+          return false;
+        }
+        index++;
+      } else {
+        break;
+      }
+    }
+    return true;
+  }
+
+  static sonic_force_inline bool isNameChar(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+           (c >= '0' && c <= '9') || c == '_' ||
+           static_cast<unsigned char>(c) >= 0x80;
+  }
+
+  static sonic_force_inline bool isDigit(StringView path, size_t index) {
+    return index < path.size() && path[index] >= '0' && path[index] <= '9';
+  }
+
+  // the json number, as -1.5e3
+  bool parseNumberLiteral(StringView path, size_t& index, double& num) {
+    size_t start = index;
+    if (path[index] == '-') {
+      index++;
+    }
+    if (!isDigit(path, index)) {
+      return false;
+    }
+    if (path[index] == '0') {
+      index++;
+    } else {
+      while (isDigit(path, index)) index++;
+    }
+    if (index < path.size() && path[index] == '.') {
+      index++;
+      if (!isDigit(path, index)) {
+        return false;
+      }
+      while (isDigit(path, index)) index++;
+    }
+    if (index < path.size() && (path[index] == 'e' || path[index] == 'E')) {
+      index++;
+      if (index < path.size() && (path[index] == '+' || path[index] == '-')) {
+        index++;
+      }
+      if (!isDigit(path, index)) {
+        return false;
+      }
+      while (isDigit(path, index)) index++;
+    }
+    num = AtofNative(path.data() + start, static_cast<int>(index - start));
     return true;
   }
 
@@ -354,16 +815,23 @@ class JsonPath : public std::vector<JsonPathNode> {
                                       size_t logical_len) noexcept {
     this->clear();
     padded_.clear();
+    filters_.clear();
     return ParsePaddedInternal(padded, logical_len);
   }
 
   sonic_force_inline bool Parse(StringView path) noexcept {
     this->clear();
+    filters_.clear();
     padded_ = paddingJsonPath(path);
     return ParsePaddedInternal(StringView(padded_.data(), padded_.size()),
                                path.size());
   }
 
+  // The filter of a filter node.
+  const JsonPathFilter& filter(const JsonPathNode& node) const {
+    return filters_[node.filter()];
+  }
+
   std::string to_string() const {
     std::stringstream ss;
     ss << "[";
@@ -376,4 +844,43 @@ class JsonPath : public std::vector<JsonPathNode> {
 };
 
 }  // namespace internal
+
+/**
+ * @brief JsonPathPlan is a compiled jsonpath, which is parsed once and used by
+ * many queries, such as GetByJsonPathOnDemand(json, plan). The nodes refer to
+ * the plan's own buffer, so a copy of the plan compiles the path again.
+ */
+class JsonPathPlan {
+ public:
+  JsonPathPlan() = default;
+  explicit JsonPathPlan(StringView jsonpath) { Compile(jsonpath); }
+  JsonPathPlan(const JsonPathPlan& rhs) { Compile(rhs.text_); }
+  JsonPathPlan& operator=(const JsonPathPlan& rhs) {
+    if (this != &rhs) Compile(rhs.text_);
+    return *this;
+  }
+
+  /**
+   * @brief Parse the jsonpath into the plan.
+   * @return false if the jsonpath is invalid or not supported.
+   */
+  bool Compile(StringView jsonpath) {
+    text_.assign(jsonpath.data(), jsonpath.size());
+    valid_ = path_.Parse(jsonpath);
+    return valid_;
+  }
+
+  bool IsValid() const noexcept { return valid_; }
+
+  // The source text of the jsonpath.
+  StringView GetJsonPath() const noexcept { return text_; }
+
+  const internal::JsonPath& GetNodes() const noexcept { return path_; }
+
+ private:
+  std::string text_;
+  internal::JsonPath path_;
+  bool valid_{false};
+};
+
 }  // namespace sonic_json
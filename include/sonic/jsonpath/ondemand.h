@@ -35,8 +35,7 @@ class JsonGenerator
   JsonGenerator(Document& dom_doc, WriteBuffer& wb)
       : dom_doc_(dom_doc), wb_(wb) {}
   bool writeRaw(StringView raw) override {
-    dom_doc_.template Parse<ParseFlags::kParseAllowUnescapedControlChars |
-                            ParseFlags::kParseIntegerAsRaw>(raw);
+    parse(raw);
     auto n = &dom_doc_;
     // check parse error
     if (dom_doc_.HasParseError()) {
@@ -63,8 +62,7 @@ class JsonGenerator
     return true;
   }
   bool copyCurrentStructure(StringView raw) override {
-    dom_doc_.template Parse<ParseFlags::kParseAllowUnescapedControlChars |
-                            ParseFlags::kParseIntegerAsRaw>(raw);
+    parse(raw);
     // check parse error
     if (dom_doc_.HasParseError()) {
       return false;
@@ -80,8 +78,7 @@ class JsonGenerator
     return true;
   }
   bool copyCurrentStructureSingleResult(StringView raw) override {
-    dom_doc_.template Parse<ParseFlags::kParseAllowUnescapedControlChars |
-                            ParseFlags::kParseIntegerAsRaw>(raw);
+    parse(raw);
     if (dom_doc_.HasParseError()) {
       return false;
     }
@@ -105,8 +102,7 @@ class JsonGenerator
       std::vector<std::optional<std::string>>& result,
       internal::SkipScanner2::JsonValueType type) override {
     wb_.Clear();
-    dom_doc_.template Parse<ParseFlags::kParseAllowUnescapedControlChars |
-                            ParseFlags::kParseIntegerAsRaw>(raw);
+    parse(raw);
     // check parse error
     if (dom_doc_.HasParseError()) {
       return false;
@@ -134,34 +130,81 @@ class JsonGenerator
     this->wb_.PushStr(sv);
     return true;
   }
+  SonicError decodeNumber(StringView raw, double& num) override {
+    return internal::DecodeDouble(raw.data(), raw.size(), num);
+  }
+  SonicError isEqualJson(StringView a, StringView b, bool& equal) override {
+    // parse as GetByJsonPath, to compare the containers as the dom filters
+    dom_doc_.ReParse(a);
+    if (dom_doc_.HasParseError()) {
+      return dom_doc_.GetParseError();
+    }
+    // the memory is released by the next parsing of dom_doc_
+    Document other(&dom_doc_.GetAllocator());
+    other.Parse(b);
+    if (other.HasParseError()) {
+      return other.GetParseError();
+    }
+    equal = static_cast<const Node&>(dom_doc_) == other;
+    return kErrorNone;
+  }
   ~JsonGenerator() override = default;
 
  private:
+  // The values are parsed one after another, reuse the memory of the last one.
+  void parse(StringView raw) {
+    dom_doc_.template ReParse<ParseFlags::kParseAllowUnescapedControlChars |
+                              ParseFlags::kParseIntegerAsRaw>(raw);
+  }
+
   Document& dom_doc_;
   WriteBuffer& wb_;
 };
 
-template <SerializeFlags serializeFlags = SerializeFlags::kSerializeDefault>
-sonic_force_inline std::tuple<std::string, SonicError> GetByJsonPathOnDemand(
-    StringView json, StringView jsonpath) {
-  internal::SkipScanner2 scan;
+namespace internal {
 
-  scan.data_ = reinterpret_cast<const uint8_t*>(json.data());
-  scan.len_ = json.size();
-  internal::JsonPath path;
-
-  // padding some buffers
-  std::string pathpadd = internal::paddingJsonPath(jsonpath);
-  // Only parse the logical jsonpath length; the extra '\0' bytes are for safe
-  // lookahead during unescaping.
-  if (!path.ParsePadded(StringView(pathpadd.data(), pathpadd.size()),
-                        jsonpath.size())) {
-    return std::make_tuple("", kUnsupportedJsonPath);
-  }
+// The document and the buffer reused by the on-demand queries of a thread, so
+// that a query does not allocate them on every call. They are dropped when a
+// query grows them beyond kKeepBytes, so a thread keeps at most about
+// 2 * kKeepBytes after a large json.
+struct OnDemandScratch {
+  static constexpr size_t kKeepBytes = 1 << 20;
 
   Document dom_doc;
   WriteBuffer wb;
 
+  static OnDemandScratch& ThreadLocal() {
+    static thread_local OnDemandScratch scratch;
+    return scratch;
+  }
+
+  void Trim() {
+    if (wb.Capacity() > kKeepBytes) {
+      wb = WriteBuffer();
+    }
+    if (dom_doc.ReuseCapacity() > kKeepBytes) {
+      dom_doc = Document();
+    }
+  }
+};
+
+// The scan uses and updates the index if it is not null.
+template <SerializeFlags serializeFlags>
+sonic_force_inline std::tuple<std::string, SonicError> getByJsonPathOnDemand(
+    StringView json, const JsonPath& path, SkipIndex* index) {
+  SkipScanner2 scan;
+
+  scan.data_ = reinterpret_cast<const uint8_t*>(json.data());
+  scan.len_ = json.size();
+  scan.index_ = index;
+
+  OnDemandScratch& scratch = OnDemandScratch::ThreadLocal();
+  Document& dom_doc = scratch.dom_doc;
+  WriteBuffer& wb = scratch.wb;
+  wb.Clear();
+
+  // The generators of the wildcard and recursive steps write into their own
+  // buffers, only these steps allocate the generators.
   const internal::SkipScanner2::JsonGeneratorFactory<serializeFlags>
       jsonGeneratorFactory = [&](WriteBuffer& local_wb) {
         std::shared_ptr<
@@ -171,20 +214,82 @@ sonic_force_inline std::tuple<std::string, SonicError> GetByJsonPathOnDemand(
         return local_ret;
       };
 
-  auto rootJsonGenerator = jsonGeneratorFactory(wb);
+  JsonGenerator<serializeFlags> rootJsonGenerator(dom_doc, wb);
+  // the paths with `..` or filters select the values as the dom
+  bool flat = false;
+  for (size_t i = 1; i < path.size(); i++) {
+    flat |= path[i].is_descendant() || path[i].is_filter();
+  }
   const bool matched =
-      scan.getJsonPath<internal::SkipScanner2::WriteStyle::RAW, serializeFlags>(
-          path, 1, rootJsonGenerator.get(), jsonGeneratorFactory);
+      flat
+          ? scan.getJsonPathFlat<serializeFlags>(path, &rootJsonGenerator)
+          : scan.getJsonPath<internal::SkipScanner2::WriteStyle::RAW,
+                             serializeFlags>(path, 1, &rootJsonGenerator,
+                                             jsonGeneratorFactory);
+  std::tuple<std::string, SonicError> ret;
   if (matched) {
-    return std::make_tuple(std::string(wb.ToStringView()), kErrorNone);
+    ret = std::make_tuple(std::string(wb.ToStringView()), kErrorNone);
+  } else if (!scan.hasError()) {
+    // if no match, it could be because valid json, just no path.
+    ret = std::make_tuple("", kErrorNoneNoMatch);
+  } else {
+    // or parse error caused premature path match termination, hence no match.
+    // In this case, return whatever that's been written to buffer.
+    ret = std::make_tuple(std::string(wb.ToStringView()), scan.error_);
   }
-  // if no match, it could be because valid json, just no path.
-  if (!scan.hasError()) {
-    return std::make_tuple("", kErrorNoneNoMatch);
+  scratch.Trim();
+  return ret;
+}
+
+template <SerializeFlags serializeFlags>
+sonic_force_inline std::tuple<std::string, SonicError> getByJsonPathOnDemand(
+    StringView json, StringView jsonpath, SkipIndex* index) {
+  internal::JsonPath path;
+
+  // padding some buffers
+  std::string pathpadd = internal::paddingJsonPath(jsonpath);
+  // Only parse the logical jsonpath length; the extra '\0' bytes are for safe
+  // lookahead during unescaping.
+  if (!path.ParsePadded(StringView(pathpadd.data(), pathpadd.size()),
+                        jsonpath.size())) {
+    return std::make_tuple("", kUnsupportedJsonPath);
   }
-  // or parse error caused premature path match termination, hence no match.
-  // In this case, return whatever that's been written to buffer.
-  return std::make_tuple(std::string(wb.ToStringView()), scan.error_);
+  return getByJsonPathOnDemand<serializeFlags>(json, path, index);
+}
+
+template <SerializeFlags serializeFlags>
+sonic_force_inline std::tuple<std::string, SonicError> getByJsonPathOnDemand(
+    StringView json, const JsonPathPlan& plan, SkipIndex* index) {
+  if (!plan.IsValid()) {
+    return std::make_tuple("", kUnsupportedJsonPath);
+  }
+  return getByJsonPathOnDemand<serializeFlags>(json, plan.GetNodes(), index);
+}
+
+}  // namespace internal
+
+/**
+ * @brief Get the json of the jsonpath by scanning the json, without parsing
+ * all of it.
+ * @note The queries of a thread reuse one document and buffer, so the thread
+ * keeps up to about 2MB of them between the queries. A query that needs more
+ * frees the extra memory when it returns.
+ */
+template <SerializeFlags serializeFlags = SerializeFlags::kSerializeDefault>
+sonic_force_inline std::tuple<std::string, SonicError> GetByJsonPathOnDemand(
+    StringView json, StringView jsonpath) {
+  return internal::getByJsonPathOnDemand<serializeFlags>(json, jsonpath,
+                                                         nullptr);
+}
+
+/**
+ * @brief Get the json of a compiled jsonpath, the same as
+ * GetByJsonPathOnDemand(json, plan.GetJsonPath()) without parsing the path.
+ */
+template <SerializeFlags serializeFlags = SerializeFlags::kSerializeDefault>
+sonic_force_inline std::tuple<std::string, SonicError> GetByJsonPathOnDemand(
+    StringView json, const JsonPathPlan& plan) {
+  return internal::getByJsonPathOnDemand<serializeFlags>(json, plan, nullptr);
 }
 
 template <SerializeFlags serializeFlags = SerializeFlags::kSerializeDefault>
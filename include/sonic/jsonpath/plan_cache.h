@@ -0,0 +1,107 @@
+/*
+ * Copyright 2022 ByteDance Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <unordered_map>
+
+#include "sonic/internal/member_index.h"
+#include "sonic/jsonpath/jsonpath.h"
+#include "sonic/macro.h"
+#include "sonic/string_view.h"
+
+namespace sonic_json {
+
+/**
+ * @brief JsonPathPlanCache keeps the recently used JsonPathPlans by the
+ * jsonpath text, and drops the least recently used one when it is full. A hit
+ * only looks up the text, so a query of a repeated jsonpath doesn't parse or
+ * allocate. The cache is not thread-safe, ThreadLocal() returns a cache of
+ * the current thread.
+ */
+class JsonPathPlanCache {
+ public:
+  using PlanPtr = std::shared_ptr<const JsonPathPlan>;
+
+  constexpr static size_t kDefaultCapacity = 64;
+
+  explicit JsonPathPlanCache(size_t capacity = kDefaultCapacity)
+      : capacity_(capacity ? capacity : 1) {}
+
+  JsonPathPlanCache(const JsonPathPlanCache &) = delete;
+  JsonPathPlanCache &operator=(const JsonPathPlanCache &) = delete;
+
+  /**
+   * @brief Get the plan of the jsonpath, compile it if not cached. The plan of
+   * an invalid jsonpath is also cached, check it by IsValid(). The returned
+   * plan is still valid after it is evicted.
+   */
+  PlanPtr Get(StringView jsonpath) {
+    auto it = map_.find(jsonpath);
+    if (it != map_.end()) {
+      hits_++;
+      lru_.splice(lru_.begin(), lru_, it->second);
+      return *it->second;
+    }
+    misses_++;
+    if (map_.size() >= capacity_) {
+      map_.erase(lru_.back()->GetJsonPath());
+      lru_.pop_back();
+    }
+    lru_.push_front(std::make_shared<const JsonPathPlan>(jsonpath));
+    // the key refers to the text in the plan
+    map_.emplace(lru_.front()->GetJsonPath(), lru_.begin());
+    return lru_.front();
+  }
+
+  void Clear() {
+    map_.clear();
+    lru_.clear();
+  }
+
+  size_t Size() const { return map_.size(); }
+  size_t Capacity() const { return capacity_; }
+  size_t Hits() const { return hits_; }
+  size_t Misses() const { return misses_; }
+
+  // The cache of the current thread.
+  static JsonPathPlanCache &ThreadLocal() {
+    static thread_local JsonPathPlanCache cache;
+    return cache;
+  }
+
+ private:
+  struct TextHash {
+    size_t operator()(StringView s) const {
+      return static_cast<size_t>(internal::MemberIndex::Hash(s));
+    }
+  };
+
+  using List = std::list<PlanPtr>;
+
+  // the front is the most recently used
+  List lru_;
+  std::unordered_map<StringView, List::iterator, TextHash> map_;
+  size_t capacity_;
+  size_t hits_{0};
+  size_t misses_{0};
+};
+
+}  // namespace sonic_json
@@ -0,0 +1,224 @@
+/*
+ * Copyright 2022 ByteDance Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "sonic/dom/json_pointer.h"
+#include "sonic/dom/parser.h"
+#include "sonic/error.h"
+#include "sonic/internal/skip_index.h"
+#include "sonic/jsonpath/ondemand.h"
+#include "sonic/string_view.h"
+
+namespace sonic_json {
+
+/**
+ * @brief PreparedJson runs many on-demand queries on the same json. The
+ * structure found by a query is kept in an index: the ends of the skipped
+ * containers, and the members of the objects and arrays on the query paths.
+ * The later queries jump over the indexed parts, so a repeated query doesn't
+ * scan the json again.
+ *
+ * The json is not copied and must outlive the PreparedJson, its size must be
+ * less than 4GB. It is not thread-safe, since the queries update the index.
+ */
+class PreparedJson {
+ public:
+  explicit PreparedJson(StringView json) : json_(json) {}
+
+  PreparedJson(const PreparedJson &) = delete;
+  PreparedJson &operator=(const PreparedJson &) = delete;
+
+  StringView GetJson() const { return json_; }
+
+  /**
+   * @brief Get the raw json field of the json pointer, as GetOnDemand. The
+   * error offset is the start of the container where the path fails.
+   */
+  template <typename JPStringType = SONIC_JSON_POINTER_NODE_STRING_DEFAULT_TYPE>
+  ParseResult GetOnDemand(const GenericJsonPointer<JPStringType> &path,
+                          StringView &target) {
+    target = "";
+    long pos = root();
+    for (size_t i = 0; i < path.size() && pos >= 0; i++) {
+      if (path[i].IsStr()) {
+        pos = findKey(pos, StringView(path[i].Data(), path[i].Size()));
+      } else {
+        pos = findIndex(pos, path[i].GetNum());
+      }
+    }
+    if (pos < 0) return ParseResult(error_, err_pos_);
+    internal::SkipScanner scan;
+    size_t end = pos;
+    long start = scan.SkipOne(data(), end, json_.size(), index_);
+    if (start < 0) return ParseResult(SonicError(-start), end);
+    target = StringView(json_.data() + start, end - start);
+    return ParseResult(kErrorNone, end);
+  }
+
+  /**
+   * @brief Parse the json field of the json pointer into the document, as
+   * ParseOnDemand.
+   */
+  template <ParseFlags parseFlags = ParseFlags::kParseDefault,
+            typename DocType,
+            typename JPStringType = SONIC_JSON_POINTER_NODE_STRING_DEFAULT_TYPE>
+  ParseResult ParseOnDemand(DocType &doc,
+                            const GenericJsonPointer<JPStringType> &path) {
+    StringView target;
+    ParseResult ret = GetOnDemand(path, target);
+    if (ret.Error() != kErrorNone) return ret;
+    doc.template Parse<parseFlags>(target.data(), target.size());
+    return ParseResult(doc.GetParseError(), doc.GetErrorOffset());
+  }
+
+  /**
+   * @brief Get the json of the jsonpath, as GetByJsonPathOnDemand.
+   */
+  template <SerializeFlags serializeFlags = SerializeFlags::kSerializeDefault>
+  std::tuple<std::string, SonicError> GetByJsonPath(StringView jsonpath) {
+    return internal::getByJsonPathOnDemand<serializeFlags>(json_, jsonpath,
+                                                           &index_);
+  }
+
+  template <SerializeFlags serializeFlags = SerializeFlags::kSerializeDefault>
+  std::tuple<std::string, SonicError> GetByJsonPath(const JsonPathPlan &plan) {
+    return internal::getByJsonPathOnDemand<serializeFlags>(json_, plan,
+                                                           &index_);
+  }
+
+  // Discard the index, e.g. to free the memory.
+  void ClearIndex() {
+    index_.Clear();
+    root_ = -1;
+  }
+
+ private:
+  using Container = internal::SkipIndex::Container;
+  using Member = internal::SkipIndex::Member;
+
+  const uint8_t *data() const {
+    return reinterpret_cast<const uint8_t *>(json_.data());
+  }
+
+  long fail(SonicError err, size_t pos) {
+    error_ = err;
+    err_pos_ = pos;
+    return -1;
+  }
+
+  // The offset of the root value.
+  long root() {
+    if (root_ < 0) {
+      internal::SkipScanner scan;
+      size_t pos = 0;
+      scan.SkipSpaceSafe(data(), pos, json_.size());
+      root_ = pos - 1;
+    }
+    return root_;
+  }
+
+  // Find the member of the object at pos, returns the offset of the value or
+  // -1 if failed.
+  long findKey(size_t pos, StringView key) {
+    if (pos >= json_.size() || json_[pos] != '{') {
+      return fail(kParseErrorMismatchType, pos);
+    }
+    Container &c = index_.Get(pos);
+    if (c.count == internal::SkipIndex::kNotScanned && !scanMembers(pos, c, true)) {
+      return -1;
+    }
+    const Member *m = index_.FindKey(c, key);
+    if (m == nullptr) return fail(kParseErrorUnknownObjKey, pos);
+    return m->value;
+  }
+
+  long findIndex(size_t pos, int idx) {
+    if (pos >= json_.size() || json_[pos] != '[') {
+      return fail(kParseErrorMismatchType, pos);
+    }
+    Container &c = index_.Get(pos);
+    if (c.count == internal::SkipIndex::kNotScanned && !scanMembers(pos, c, false)) {
+      return -1;
+    }
+    if (idx < 0 || static_cast<uint32_t>(idx) >= c.count) {
+      return fail(kParseErrorArrIndexOutOfRange, pos);
+    }
+    return index_.Members(c)[idx].value;
+  }
+
+  // Record the members of the container at `start`, the values are skipped by
+  // the index.
+  bool scanMembers(size_t start, Container &c, bool is_obj) {
+    internal::SkipScanner scan;
+    const uint8_t *p = data();
+    size_t len = json_.size();
+    size_t pos = start + 1;
+    size_t first = index_.MemberCount();
+    SonicError err = kErrorNone;
+    uint8_t close = is_obj ? '}' : ']';
+    uint8_t c0 = scan.SkipSpaceSafe(p, pos, len);
+    if (c0 != close) {
+      pos--;
+      while (true) {
+        StringView key;
+        if (is_obj) {
+          if (scan.SkipSpaceSafe(p, pos, len) != '"') goto err_invalid_char;
+          key = scan.scanKey(p, pos, len, kbuf_, err);
+          if (err) {
+            index_.DropMembers(first);
+            fail(err, pos);
+            return false;
+          }
+          if (!kbuf_.empty() &&
+              key.data() == reinterpret_cast<const char *>(kbuf_.data())) {
+            key = index_.SaveKey(key);
+          }
+          if (scan.SkipSpaceSafe(p, pos, len) != ':') goto err_invalid_char;
+        }
+        long value = scan.SkipOne(p, pos, len, index_);
+        if (value < 0) {
+          index_.DropMembers(first);
+          fail(SonicError(-value), pos);
+          return false;
+        }
+        index_.AddMember(key, value);
+        uint8_t c1 = scan.SkipSpaceSafe(p, pos, len);
+        if (c1 == close) break;
+        if (c1 != ',') goto err_invalid_char;
+      }
+    }
+    index_.SetScanned(c, first, pos, is_obj);
+    return true;
+  err_invalid_char:
+    index_.DropMembers(first);
+    fail(kParseErrorInvalidChar, pos - 1);
+    return false;
+  }
+
+  StringView json_;
+  internal::SkipIndex index_;
+  long root_{-1};
+  SonicError error_{kErrorNone};
+  size_t err_pos_{0};
+  std::vector<uint8_t> kbuf_;
+};
+
+}  // namespace sonic_json
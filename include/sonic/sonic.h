@@ -18,8 +18,16 @@
 
 #include "sonic/dom/dynamicnode.h"
 #include "sonic/dom/generic_document.h"
+#include "sonic/dom/ndjson.h"
+#include "sonic/dom/stream_parser.h"
+#include "sonic/dom/struct_parser.h"
+#include "sonic/dom/struct_serialize.h"
+#include "sonic/dom/tape.h"
+#include "sonic/dom/writer.h"
 #include "sonic/jsonpath/dom.h"
 #include "sonic/jsonpath/ondemand.h"
+#include "sonic/jsonpath/plan_cache.h"
+#include "sonic/jsonpath/prepared.h"
 
 #define SONIC_MAJOR_VERSION 1
 #define SONIC_MINOR_VERSION 0
@@ -82,6 +82,30 @@ TEST(Allocator, AdaptiveChunkPolicyGrowth) {
   EXPECT_EQ(cp.ChunkSize(max_cap - 1), max_cap);
 }
 
+TEST(Allocator, MemoryPoolAllocatorRewind) {
+  MemoryPoolAllocator<> pool(1024);
+  void *p1 = pool.Malloc(1000);
+  void *p2 = pool.Malloc(3000);
+  ASSERT_NE(p1, nullptr);
+  ASSERT_NE(p2, nullptr);
+  size_t cap = pool.Capacity();
+
+  // the chunks are kept and reused after rewinding
+  pool.Rewind();
+  EXPECT_EQ(pool.Size(), 0u);
+  EXPECT_EQ(pool.Capacity(), cap);
+  EXPECT_NE(pool.Malloc(2000), nullptr);
+  EXPECT_NE(pool.Malloc(500), nullptr);
+  EXPECT_EQ(pool.Capacity(), cap);
+
+  // a larger request still adds a chunk
+  EXPECT_NE(pool.Malloc(cap), nullptr);
+  EXPECT_GT(pool.Capacity(), cap);
+
+  pool.Clear();
+  EXPECT_EQ(pool.Capacity(), 0u);
+}
+
 TEST(Allocator, MemoryPoolAllocatorMoveAndMapAllocator) {
   // Moved-from allocator should be a no-op on destruction.
   {
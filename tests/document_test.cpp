@@ -17,11 +17,14 @@
 #include <dirent.h>
 
 #include <algorithm>
+#include <cstdlib>
 #include <fstream>
 #include <iostream>
 #include <map>
+#include <new>
 #include <sstream>
 #include <string>
+#include <thread>
 #include <vector>
 
 #include "gtest/gtest.h"
@@ -29,6 +32,20 @@
 #include "sonic/dom/parser.h"
 #include "sonic/sonic.h"
 
+// Counts the global operator new calls of the current thread while enabled,
+// to check the heap allocations out of the document allocator.
+static thread_local bool g_count_new = false;
+static thread_local size_t g_new_count = 0;
+
+void* operator new(size_t size) {
+  if (g_count_new) g_new_count++;
+  void* p = std::malloc(size ? size : 1);
+  if (p == nullptr) throw std::bad_alloc();
+  return p;
+}
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+
 namespace {
 
 using namespace sonic_json;
@@ -386,6 +403,460 @@ TYPED_TEST(DocumentTest, ParseFile) {
   }
 }
 
+TYPED_TEST(DocumentTest, ParseFileMapped) {
+  using Document = TypeParam;
+  const std::string file = testing::TempDir() + "sonic_parse_file.json";
+  auto write_file = [&](const std::string& json) {
+    std::ofstream ofs(file, std::ios::binary | std::ios::trunc);
+    ofs << json;
+  };
+
+  auto jsons = get_all_jsons("./testdata/");
+  // the file ends at the page boundary
+  jsons.push_back("[\"" + std::string(4092, 'a') + "\"]");
+  jsons.push_back(std::string(4095, ' ') + "1");
+  for (const auto& json : jsons) {
+    write_file(json);
+    Document expect;
+    expect.Parse(json);
+    Document doc;
+    doc.ParseFile(file.c_str());
+    EXPECT_FALSE(doc.HasParseError());
+    EXPECT_EQ(expect, doc);
+    // the mapping is moved together
+    Document moved = std::move(doc);
+    EXPECT_EQ(expect, moved);
+  }
+
+  {
+    write_file(R"({"a":{"b":["x", "y\"z"]},"c":1})");
+    Document doc;
+    doc.ParseFileOnDemand(file.c_str(), JsonPointer({"a", "b", 1}));
+    EXPECT_FALSE(doc.HasParseError());
+    EXPECT_EQ(doc.GetString(), "y\"z");
+    doc.ParseFileOnDemand(file.c_str(), JsonPointer({"d"}));
+    EXPECT_EQ(doc.GetParseError(), kParseErrorUnknownObjKey);
+  }
+
+  // truncated json never reads the zero padding as tokens
+  Document doc;
+  for (const char* json : {"", "[1,", "\"abc", "tr"}) {
+    write_file(json);
+    EXPECT_TRUE(doc.ParseFile(file.c_str()).HasParseError()) << json;
+  }
+  std::remove(file.c_str());
+  EXPECT_EQ(doc.ParseFile(file.c_str()).GetParseError(), kErrorOpenFile);
+  EXPECT_EQ(doc.ParseFile(testing::TempDir().c_str()).GetParseError(),
+            kErrorOpenFile);
+}
+
+TYPED_TEST(DocumentTest, ParseBorrowInput) {
+  using Document = TypeParam;
+  constexpr auto kBorrow = ParseFlags::kParseBorrowInput;
+  auto padded = [](const std::string& json, char pad = '\0') {
+    std::string buf(json);
+    buf.append(SONICJSON_PADDING, pad);
+    return buf;
+  };
+
+  auto jsons = get_all_jsons("./testdata/");
+  for (const auto& json : jsons) {
+    std::string buf = padded(json);
+    Document copied, borrowed;
+    copied.Parse(json);
+    borrowed.template Parse<kBorrow>(buf.data(), json.size());
+    EXPECT_FALSE(borrowed.HasParseError());
+    EXPECT_EQ(copied, borrowed);
+    EXPECT_EQ(buf, padded(json));
+  }
+
+  {
+    std::string json = R"({"plain":"abc","esc\"aped":"a\nb\u0041"})";
+    std::string buf = padded(json);
+    Document doc;
+    doc.template Parse<kBorrow>(buf.data(), json.size());
+    ASSERT_FALSE(doc.HasParseError());
+    EXPECT_EQ(buf, padded(json));
+    // the unescaped string refers to the input
+    EXPECT_EQ(doc["plain"].GetStringView().data(), buf.data() + 10);
+    EXPECT_EQ(doc["esc\"aped"].GetStringView(), "a\nbA");
+    WriteBuffer wb;
+    EXPECT_EQ(doc.Serialize(wb), kErrorNone);
+    EXPECT_STREQ(wb.ToString(), R"({"plain":"abc","esc\"aped":"a\nbA"})");
+  }
+
+  // tokens must not run into the padding, whatever the padding is
+  struct BorrowErrorTest {
+    std::string json;
+    std::string pad;
+  };
+  std::vector<BorrowErrorTest> tests = {
+      {"", ""},           {"   ", "1"},      {"1.", "5"},
+      {"[12", "3]"},      {"tr", "ue"},      {"[1, ", "  "},
+      {"[[]", "]"},       {"\"abc", "\""},   {"{\"a\":1", "}"},
+      {"\"a\tb\"", ""},   {"[\"\\x\"]", ""}, {"[\"a\\", "\"\"]"},
+  };
+  for (const auto& t : tests) {
+    std::string buf = t.json + t.pad;
+    buf.append(SONICJSON_PADDING - t.pad.size(), ' ');
+    Document doc;
+    doc.template Parse<kBorrow>(buf.data(), t.json.size());
+    EXPECT_TRUE(doc.HasParseError()) << "Error when parsing json: " << t.json;
+  }
+
+  // a root number ends at the end of the input, whatever the padding is
+  for (std::string json :
+       {"12", "-1.5", " 1e3", "0", "123456789012345678901234", "7 "}) {
+    Document expect;
+    expect.Parse(json);
+    for (char pad : {'3', '0', '.', 'e', '-'}) {
+      std::string buf = padded(json, pad);
+      Document doc;
+      doc.template Parse<kBorrow>(buf.data(), json.size());
+      EXPECT_FALSE(doc.HasParseError()) << json << " padded by " << pad;
+      EXPECT_EQ(doc, expect) << json << " padded by " << pad;
+    }
+  }
+  {
+    std::string buf = padded("123", '4');
+    Document doc;
+    doc.template Parse<kBorrow | ParseFlags::kParseIntegerAsRaw>(buf.data(),
+                                                                 3);
+    ASSERT_FALSE(doc.HasParseError());
+    // the raw text refers to the input
+    EXPECT_EQ(doc.GetRaw().data(), buf.data());
+    EXPECT_EQ(doc.GetRaw(), "123");
+
+    buf = padded("1.5", '9');
+    doc.template Parse<kBorrow | ParseFlags::kParseLazyNumbers>(buf.data(), 3);
+    ASSERT_FALSE(doc.HasParseError());
+    EXPECT_EQ(doc.GetDouble(), 1.5);
+  }
+}
+
+TYPED_TEST(DocumentTest, ParseLazyStrings) {
+  using Document = TypeParam;
+  constexpr auto kLazy = ParseFlags::kParseLazyStrings;
+  for (const auto& json : get_all_jsons("./testdata/")) {
+    Document expect, doc;
+    expect.Parse(json);
+    doc.template Parse<kLazy>(json);
+    EXPECT_FALSE(doc.HasParseError());
+    // the escaped text is dumped as it is, and unescaped when compared
+    Document dumped;
+    dumped.Parse(doc.Dump());
+    EXPECT_EQ(expect, dumped);
+    EXPECT_EQ(expect, doc);
+  }
+
+  {
+    const std::string json =
+        R"({"k\n":"a\"b\u00e9\ud83d\ude00","s":"plain","c":["\\\/\b\f\r\t"]})";
+    Document doc;
+    doc.template Parse<kLazy>(json);
+    ASSERT_FALSE(doc.HasParseError());
+    // the keys are unescaped when parsing
+    EXPECT_TRUE(doc.HasMember("k\n"));
+    EXPECT_EQ(doc.Dump(), json);
+    Document copy;
+    copy.CopyFrom(doc, copy.GetAllocator());
+    EXPECT_EQ(copy["k\n"].GetStringView(), "a\"b\u00e9\U0001F600");
+    EXPECT_EQ(doc["k\n"].Size(), 9);
+    EXPECT_EQ(doc["c"][0].GetString(), "\\/\b\f\r\t");
+    EXPECT_EQ(doc.Dump(),
+              R"({"k\n":"a\"bé😀","s":"plain","c":["\\/\b\f\r\t"]})");
+  }
+
+  {
+    // the strings are unescaped once, and the views are kept, also from
+    // several threads
+    const std::string json =
+        R"(["\u0041b","\u0041b","\u00e9",{"k":"\u0041"},"a\nb","c\td"])";
+    const std::string unescaped =
+        R"(["Ab","Ab","é",{"k":"A"},"a\nb","c\td"])";
+    Document doc;
+    doc.template Parse<kLazy>(json);
+    const Document& cdoc = doc;
+    StringView a = cdoc[4].GetStringView();
+    StringView b = cdoc[5].GetStringView();
+    EXPECT_EQ(a, "a\nb");
+    EXPECT_EQ(b, "c\td");
+    EXPECT_FALSE(a == b);
+    EXPECT_FALSE(cdoc[4] == cdoc[5]);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+      threads.emplace_back([&cdoc, &unescaped]() {
+        for (int i = 0; i < 100; i++) {
+          EXPECT_EQ(cdoc[0].GetStringView(), "Ab");
+          EXPECT_EQ(cdoc[2].Size(), 2u);
+          EXPECT_EQ(cdoc[2].GetString(), "\u00e9");
+          EXPECT_TRUE(cdoc[0] == cdoc[1]);
+          EXPECT_FALSE(cdoc[0] == cdoc[2]);
+          Document dumped;
+          dumped.Parse(cdoc.Dump());
+          EXPECT_EQ(dumped.Dump(), unescaped);
+        }
+      });
+    }
+    for (auto& t : threads) t.join();
+    EXPECT_EQ(a, "a\nb");
+    EXPECT_EQ(a.data(), cdoc[4].GetStringView().data());
+    // the untouched string is still dumped as its text
+    EXPECT_EQ(doc.Dump(),
+              R"(["Ab","Ab","é",{"k":"\u0041"},"a\nb","c\td"])");
+    Document copy;
+    copy.CopyFrom(cdoc, copy.GetAllocator());
+    EXPECT_EQ(copy[3]["k"].GetStringView(), "A");
+    EXPECT_EQ(copy.Dump(), unescaped);
+  }
+
+  {
+    Document doc;
+    doc.template Parse<kLazy>(R"(["\ud83d\ude00"])");
+    EXPECT_EQ(doc.template Dump<SerializeFlags::kSerializeEscapeEmoji>(),
+              R"(["\ud83d\ude00"])");
+    EXPECT_EQ(doc[0].GetStringView(), "\U0001F600");
+  }
+
+  for (const char* json : {R"("\x")", R"(["\ud800"])", "\"\\n\x01\"",
+                           R"({"a":"\n)", R"(["\u12"])"}) {
+    Document expect, doc;
+    expect.Parse(json);
+    doc.template Parse<kLazy>(json);
+    EXPECT_EQ(doc.GetParseError(), expect.GetParseError()) << json;
+  }
+}
+
+TYPED_TEST(DocumentTest, ParsePackNumberArrays) {
+  using Document = TypeParam;
+  constexpr auto kPack = ParseFlags::kParsePackNumberArrays;
+  for (const auto& json : get_all_jsons("./testdata/")) {
+    Document expect, doc;
+    expect.Parse(json);
+    doc.template Parse<kPack>(json);
+    EXPECT_FALSE(doc.HasParseError());
+    EXPECT_EQ(doc.Dump(), expect.Dump());
+    EXPECT_EQ(expect, doc);
+    EXPECT_EQ(doc, expect);
+  }
+
+  const std::string json =
+      R"({"d":[1.5,-2.0,0.25],"i":[1,-2,3],"m":[1,2.5],"u":[18446744073709551615],"e":[]})";
+  Document doc;
+  doc.template Parse<kPack>(json);
+  ASSERT_FALSE(doc.HasParseError());
+  auto ds = doc["d"].GetDoubleSpan();
+  ASSERT_EQ(ds.size(), 3);
+  EXPECT_EQ(ds[1], -2.0);
+  EXPECT_TRUE(doc["d"].GetInt64Span().empty());
+  auto is = doc["i"].GetInt64Span();
+  ASSERT_EQ(is.size(), 3);
+  EXPECT_EQ(is[1], -2);
+  EXPECT_TRUE(doc["m"].GetDoubleSpan().empty());
+  EXPECT_TRUE(doc["u"].GetInt64Span().empty());
+  EXPECT_TRUE(doc["e"].GetDoubleSpan().empty());
+  EXPECT_EQ(doc.Dump(), json);
+
+  // the copy is packed as well
+  Document copy;
+  copy.CopyFrom(doc, copy.GetAllocator());
+  EXPECT_EQ(copy["d"].GetDoubleSpan().size(), 3);
+  EXPECT_EQ(copy, doc);
+
+  // the const accessors make the nodes once and keep the array packed, from
+  // many threads
+  const Document& cdoc = doc;
+  const auto& held = cdoc["i"][1];
+  auto read = [&cdoc, &held]() {
+    const auto& d = cdoc["d"];
+    double sum = 0;
+    for (auto it = d.Begin(); it != d.End(); ++it) sum += it->GetDouble();
+    EXPECT_EQ(sum, -0.25);
+    EXPECT_EQ(d.End() - d.Begin(), 3);
+    EXPECT_EQ(d[0].GetDouble(), 1.5);
+    EXPECT_EQ(&d[0], &d[0]);
+    EXPECT_EQ(&d[0], &*d.Begin());
+    EXPECT_EQ(d.Back().GetDouble(), 0.25);
+    EXPECT_EQ(&cdoc["i"][1], &held);
+    EXPECT_TRUE(cdoc["i"][0].IsUint64());
+    EXPECT_TRUE(cdoc["i"][1].IsInt64());
+    EXPECT_EQ(cdoc.AtPointer("i", 2)->GetInt64(), 3);
+    auto res = cdoc.AtJsonPath("$..*");
+    ASSERT_EQ(res.nodes.size(), 14);
+    EXPECT_EQ(res.nodes[1]->GetDouble(), 1.5);
+    EXPECT_EQ(res.nodes[7]->GetInt64(), 3);
+    res = cdoc.AtJsonPath("$.d[?(@ > 1)]");
+    ASSERT_EQ(res.nodes.size(), 1);
+    EXPECT_EQ(res.nodes[0]->GetDouble(), 1.5);
+    res = cdoc.AtJsonPath("$.i[-1]");
+    ASSERT_EQ(res.nodes.size(), 1);
+    EXPECT_EQ(res.nodes[0]->GetInt64(), 3);
+    EXPECT_EQ(cdoc.AtJsonPath("$.i[0].a").error, kNotFoundByJsonPath);
+  };
+  std::vector<std::thread> readers;
+  for (int i = 0; i < 4; i++) readers.emplace_back(read);
+  for (auto& t : readers) t.join();
+  for (size_t k = 0; k < 100; k++) EXPECT_TRUE(cdoc["i"][k % 3].IsNumber());
+  EXPECT_EQ(held.GetInt64(), -2);
+  EXPECT_EQ(cdoc["d"].GetDoubleSpan().data(), ds.data());
+  EXPECT_EQ(cdoc["i"].GetInt64Span().size(), 3);
+
+  // the nodes are unpacked when accessed, the nodes made by the const
+  // accessors are kept
+  EXPECT_EQ(&doc["i"][1], &held);
+  EXPECT_TRUE(doc["i"][0].IsUint64());
+  EXPECT_TRUE(doc["i"][1].IsInt64());
+  EXPECT_TRUE(doc["i"].GetInt64Span().empty());
+  EXPECT_EQ(copy, doc);
+  doc["d"].PushBack(std::move(typename Document::NodeType(4)),
+                    doc.GetAllocator());
+  EXPECT_EQ(doc["d"].Size(), 4);
+  EXPECT_EQ(doc["d"].Back().GetInt64(), 4);
+  EXPECT_NE(copy, doc);
+  copy["i"].Clear();
+  EXPECT_EQ(copy["i"].Dump(), "[]");
+}
+
+TYPED_TEST(DocumentTest, ParseStream) {
+  using Document = TypeParam;
+  using NodeType = typename std::remove_reference_t<decltype(
+      std::declval<Document&>()[0])>;
+  auto parse_chunks = [](Document& doc, const std::string& json,
+                         size_t chunk) {
+    GenericDocumentStream<NodeType> stream(doc);
+    for (size_t i = 0; i < json.size(); i += chunk) {
+      // the chunk is released after feeding
+      std::string part = json.substr(i, chunk);
+      if (stream.Feed(part).Error()) break;
+    }
+    stream.Finish();
+  };
+
+  auto jsons = get_all_jsons("./testdata/");
+  for (const auto& json : jsons) {
+    Document expect;
+    expect.Parse(json);
+    for (size_t chunk : {7, 4096}) {
+      Document doc;
+      parse_chunks(doc, json, chunk);
+      EXPECT_FALSE(doc.HasParseError()) << chunk;
+      EXPECT_EQ(expect, doc) << chunk;
+    }
+  }
+
+  // split the tokens at every position
+  std::vector<std::string> valid = {
+      "true",
+      " -1.5e3 ",
+      R"("a\"b\\中😀")",
+      R"({"k\"ey" : [null, false, 12345678901234567890, {"": "\n"}], "d":-0})",
+  };
+  for (const auto& json : valid) {
+    Document expect;
+    expect.Parse(json);
+    ASSERT_FALSE(expect.HasParseError()) << json;
+    for (size_t chunk = 1; chunk <= json.size(); chunk++) {
+      Document doc;
+      parse_chunks(doc, json, chunk);
+      EXPECT_FALSE(doc.HasParseError()) << json << chunk;
+      EXPECT_EQ(expect, doc) << json << chunk;
+    }
+  }
+
+  struct ErrorTest {
+    std::string json;
+    SonicError err;
+    size_t offset;
+  };
+  std::vector<ErrorTest> invalid = {
+      {"", kParseErrorEof, 0},
+      {"  ", kParseErrorEof, 2},
+      {"[1,", kParseErrorEof, 3},
+      {R"({"a)", kParseErrorEof, 3},
+      {"[1 2]", kParseErrorInvalidChar, 3},
+      {"{}x", kParseErrorInvalidChar, 2},
+      {"[1,]", kParseErrorInvalidChar, 3},
+      {"[1.]", kParseErrorInvalidChar, 3},
+      {"[tru]", kParseErrorInvalidChar, 2},
+      {R"({"a" 1})", kParseErrorInvalidChar, 5},
+      {R"(["\x"])", kParseErrorEscapedFormat, 2},
+      {"[\"\x01\"]", kParseErrorUnEscaped, 2},
+  };
+  for (const auto& t : invalid) {
+    for (size_t chunk : {size_t(1), size_t(3), t.json.size() + 1}) {
+      Document doc;
+      parse_chunks(doc, t.json, chunk);
+      EXPECT_EQ(doc.GetParseError(), t.err) << t.json << chunk;
+      EXPECT_EQ(doc.GetErrorOffset(), t.offset) << t.json << chunk;
+    }
+  }
+
+  // the error is kept in the stream
+  {
+    Document doc;
+    GenericDocumentStream<NodeType> stream(doc);
+    EXPECT_EQ(stream.Feed("[1,,", 4).Error(), kParseErrorInvalidChar);
+    EXPECT_EQ(stream.Feed("2]", 2).Error(), kParseErrorInvalidChar);
+    EXPECT_TRUE(stream.Finish().HasParseError());
+  }
+}
+
+TYPED_TEST(DocumentTest, ParseParallel) {
+  using Document = TypeParam;
+  std::string records = " [";
+  for (int i = 0; i < 200; i++) {
+    if (i) records += i % 3 ? "," : " ,\n";
+    records += R"({"id":)" + std::to_string(i) +
+               R"(,"s":"a,\"b]c","v":[1.5,{"x":[]}],"n":null})";
+  }
+  records += "] ";
+
+  std::vector<std::string> jsons = get_all_jsons("./testdata/");
+  jsons.push_back(records);
+  jsons.push_back("[1,2,3,4,5,6,7,8,9]");
+  jsons.push_back(R"({"a":[1,2,3,4,5]})");
+  for (const auto& json : jsons) {
+    Document expect;
+    expect.Parse(json);
+    for (size_t threads : {2, 5}) {
+      for (size_t slice : {1, 64, 1 << 20}) {
+        Document doc;
+        doc.ParseParallel(json, threads, slice);
+        EXPECT_FALSE(doc.HasParseError()) << threads << " " << slice;
+        EXPECT_EQ(doc.GetErrorOffset(), expect.GetErrorOffset());
+        EXPECT_EQ(expect, doc) << threads << " " << slice;
+      }
+    }
+  }
+
+  // the elements are still valid after moved
+  {
+    Document doc;
+    doc.ParseParallel(records, 4, 64);
+    Document moved(std::move(doc));
+    EXPECT_EQ(moved.Size(), 200);
+    EXPECT_EQ(moved[199]["s"].GetString(), "a,\"b]c");
+    moved.PushBack(typename Document::NodeType(1), moved.GetAllocator());
+    EXPECT_EQ(moved.Size(), 201);
+  }
+
+  // the errors are the same as Parse
+  std::vector<std::string> invalid = {
+      "[1,2,3,4,5,6,7,8,,9]", "[1,2,3,4,5,6,7,8,9,]", "[,1,2,3,4,5,6,7,8,9]",
+      "[1,2,3,[4,5],6,7,8,9", "[1,2,3,4,5,6,7,8,9]x", "[1,2,3,4,5]]6,7,8,9]",
+      "[1,2,3,     ,4,5,6]", "[1,2,\"3,4,5,6,7,8,9]",
+  };
+  for (const auto& json : invalid) {
+    Document expect;
+    expect.Parse(json);
+    ASSERT_TRUE(expect.HasParseError()) << json;
+    Document doc;
+    doc.ParseParallel(json, 3, 1);
+    EXPECT_EQ(doc.GetParseError(), expect.GetParseError()) << json;
+    EXPECT_EQ(doc.GetErrorOffset(), expect.GetErrorOffset()) << json;
+  }
+}
+
 TYPED_TEST(DocumentTest, ParseOnDemandFile) {
   using Document = TypeParam;
   using CNode = DNode<SimpleAllocator>;
@@ -500,6 +971,198 @@ TYPED_TEST(DocumentTest, ParseOnDemand) {
   }
 }
 
+TYPED_TEST(DocumentTest, ReParse) {
+  using Document = TypeParam;
+  auto jsons = get_all_jsons("./testdata/");
+  jsons.push_back(R"({"a":"\n","b":[1,2,{"c":null}]})");
+  jsons.push_back("[1,]");
+  jsons.push_back("");
+  Document doc;
+  for (int round = 0; round < 2; round++) {
+    for (const auto& json : jsons) {
+      Document expect;
+      expect.Parse(json);
+      doc.ReParse(json);
+      EXPECT_EQ(doc.GetParseError(), expect.GetParseError());
+      EXPECT_EQ(doc.GetErrorOffset(), expect.GetErrorOffset());
+      if (!expect.HasParseError()) {
+        EXPECT_EQ(expect, doc);
+      }
+    }
+  }
+  doc.Reset();
+  EXPECT_TRUE(doc.IsNull());
+  doc.SetObject().AddMember("k", typename Document::NodeType("v"),
+                            doc.GetAllocator());
+  EXPECT_EQ(doc["k"].GetString(), "v");
+  doc.Parse("[1]");
+  doc.ReParse("[2]");
+  EXPECT_EQ(doc[0].GetInt64(), 2);
+}
+
+TYPED_TEST(DocumentTest, InternKeys) {
+  using Document = TypeParam;
+  using NodeType = typename std::remove_reference_t<decltype(
+      std::declval<Document&>()[0])>;
+  constexpr ParseFlags kIntern = ParseFlags::kParseInternKeys;
+  auto jsons = get_all_jsons("./testdata/");
+  for (const auto& json : jsons) {
+    Document expect, doc;
+    expect.Parse(json);
+    doc.template Parse<kIntern>(json);
+    EXPECT_EQ(expect, doc);
+  }
+
+  std::string json =
+      R"([{"id":1,"name":"a"},{"id":2,"name":"b"},{"na\u006de":"c","id":3}])";
+  auto check = [&](Document& doc, size_t saved) {
+    ASSERT_FALSE(doc.HasParseError());
+    const char* id = doc[0].FindMember("id")->name.GetStringView().data();
+    EXPECT_EQ(doc[1].FindMember("id")->name.GetStringView().data(), id);
+    EXPECT_EQ(doc[2].FindMember("id")->name.GetStringView().data(), id);
+    // the escaped key is unescaped before interning
+    EXPECT_EQ(doc[2].MemberBegin()->name.GetStringView().data(),
+              doc[0].FindMember("name")->name.GetStringView().data());
+    EXPECT_EQ(doc.GetInternSavedBytes(), saved);
+  };
+  // the keys in the parsed buffer are not freed
+  Document doc;
+  doc.template Parse<kIntern>(json);
+  check(doc, 0);
+  doc.template ReParse<kIntern>(json);
+  check(doc, 0);
+  // the escaped keys are copied from the borrowed input, and the repeated
+  // copy is freed if the allocator frees memory
+  std::string padded = json + std::string(SONICJSON_PADDING, '\0');
+  doc.template Parse<kIntern | ParseFlags::kParseBorrowInput>(padded.data(),
+                                                              json.size());
+  check(doc, Document::Allocator::kNeedFree ? 4 : 0);
+  {
+    GenericDocumentStream<NodeType, kIntern> stream(doc);
+    for (size_t i = 0; i < json.size(); i += 5) {
+      stream.Feed(json.substr(i, 5));
+    }
+    stream.Finish();
+  }
+  Document expect;
+  expect.Parse(json);
+  EXPECT_EQ(expect, doc);
+  // the streamed keys are owned by nodes, and are not shared if freed
+  EXPECT_EQ(doc.GetInternSavedBytes(), 0);
+
+  doc.Parse(json);
+  EXPECT_EQ(doc.GetInternSavedBytes(), 0);
+}
+
+// CountingAllocator counts the chunks allocated by the memory pool.
+struct CountingAllocator : public SimpleAllocator {
+  static size_t count;
+  void* Malloc(size_t size) {
+    count++;
+    return SimpleAllocator::Malloc(size);
+  }
+  void* Realloc(void* old_ptr, size_t old_size, size_t new_size) {
+    count++;
+    return SimpleAllocator::Realloc(old_ptr, old_size, new_size);
+  }
+};
+size_t CountingAllocator::count = 0;
+
+TEST(Document, ReParseNoAllocation) {
+  using Document = GenericDocument<DNode<MemoryPoolAllocator<CountingAllocator>>>;
+  std::vector<std::string> jsons = {
+      R"({"id":1,"name":"\u4e2d","tags":["a","b"],"v":[1.5,2,3]})",
+      std::string(10000, ' ') + "[" + std::string(100, '1') + "]",
+      R"([{"a":{}},{"b":[]},"xxxxxxxxxxxxxxxxxxxxxxxxxxxxxxxx"])",
+  };
+  Document doc;
+  for (const auto& json : jsons) doc.ReParse(json);
+  size_t warm = CountingAllocator::count;
+  g_new_count = 0;
+  g_count_new = true;
+  for (int i = 0; i < 100; i++) {
+    for (const auto& json : jsons) {
+      doc.ReParse(json);
+      if (doc.HasParseError()) break;
+    }
+  }
+  g_count_new = false;
+  ASSERT_FALSE(doc.HasParseError());
+  // neither the memory pool nor the parser allocates
+  EXPECT_EQ(CountingAllocator::count, warm);
+  EXPECT_EQ(g_new_count, 0u);
+
+  // Parse releases the chunks
+  doc.Parse(jsons[0]);
+  EXPECT_GT(CountingAllocator::count, warm);
+}
+
+TEST(Document, ParseCreateMap) {
+  using Document = GenericDocument<DNode<CountingAllocator>>;
+  using NodeType = DNode<CountingAllocator>;
+  constexpr ParseFlags kCreateMap = ParseFlags::kParseCreateMap;
+  std::string wide = "{";
+  for (int i = 0; i < 40; i++) {
+    wide += "\"key" + std::to_string(i) + "\":" + std::to_string(i) + ",";
+  }
+  wide += "\"key0\":-1}";
+  std::string json = "[" + wide + R"(,{"a":{"b":1}},{}])";
+
+  auto check = [&](Document& doc) {
+    ASSERT_FALSE(doc.HasParseError());
+    for (int i = 1; i < 40; i++) {
+      EXPECT_EQ(doc[0]["key" + std::to_string(i)].GetInt64(), i);
+    }
+    // the first one of the duplicated keys is found
+    EXPECT_EQ(doc[0]["key0"].GetInt64(), 0);
+    EXPECT_FALSE(doc[0].HasMember("key40"));
+    EXPECT_EQ(doc[1]["a"]["b"].GetInt64(), 1);
+    EXPECT_TRUE(doc[2].Empty());
+  };
+
+  // only the object above the threshold gets a map
+  Document doc;
+  CountingAllocator::count = 0;
+  doc.Parse(json);
+  size_t plain = CountingAllocator::count;
+  check(doc);
+  CountingAllocator::count = 0;
+  doc.Parse<kCreateMap>(json);
+  EXPECT_EQ(CountingAllocator::count, plain + 1);
+  check(doc);
+  doc.SetCreateMapMembers(1);
+  CountingAllocator::count = 0;
+  doc.Parse<kCreateMap>(json);
+  EXPECT_EQ(CountingAllocator::count, plain + 3);
+  check(doc);
+  doc.ReParse<kCreateMap>(json);
+  check(doc);
+
+  // the map is maintained by the changes after parsing
+  doc[0].AddMember("key40", NodeType(40), doc.GetAllocator());
+  EXPECT_TRUE(doc[0].RemoveMember("key1"));
+  EXPECT_EQ(doc[0]["key40"].GetInt64(), 40);
+  EXPECT_FALSE(doc[0].HasMember("key1"));
+  EXPECT_EQ(doc[0]["key2"].GetInt64(), 2);
+
+  {
+    GenericDocumentStream<NodeType, kCreateMap> stream(doc);
+    for (size_t i = 0; i < json.size(); i += 7) {
+      stream.Feed(json.substr(i, 7));
+    }
+    stream.Finish();
+  }
+  check(doc);
+  std::string records = "[" + wide;
+  for (int i = 0; i < 8; i++) records += "," + wide;
+  records += "]";
+  doc.ParseParallel<kCreateMap>(records, 4, 64);
+  ASSERT_FALSE(doc.HasParseError());
+  for (size_t i = 0; i < doc.Size(); i++) {
+    EXPECT_EQ(doc[i]["key39"].GetInt64(), 39);
+  }
+}
+
 TYPED_TEST(DocumentTest, Move) {
   using Document = TypeParam;
   auto& alloc = this->doc_.GetAllocator();
@@ -224,4 +224,28 @@ TEST(F64toa, ConnerCase) {
   TestF64toa("9.99999999999999e-7", 9.99999999999999e-7);
 }
 
+TEST(F64toa, DecimalPoint) {
+  // the point at every position of 16 and 17 digits
+  TestF64toa("1.2345678901234567", 1.2345678901234567);
+  TestF64toa("12.345678901234567", 12.345678901234567);
+  TestF64toa("123.45678901234568", 123.45678901234568);
+  TestF64toa("1234.567890123457", 1234.5678901234568);
+  TestF64toa("12345.678901234567", 12345.678901234567);
+  TestF64toa("123456.78901234567", 123456.78901234567);
+  TestF64toa("1234567.8901234567", 1234567.8901234567);
+  TestF64toa("12345678.901234567", 12345678.901234567);
+  TestF64toa("123456789.01234567", 123456789.01234567);
+  TestF64toa("1234567890.1234567", 1234567890.1234567);
+  TestF64toa("12345678901.234568", 12345678901.234568);
+  TestF64toa("123456789012.34567", 123456789012.34567);
+  TestF64toa("1234567890123.4568", 1234567890123.4568);
+  TestF64toa("12345678901234.568", 12345678901234.568);
+  TestF64toa("123456789012345.67", 123456789012345.67);
+  TestF64toa("1234567890123456.8", 1234567890123456.8);
+  TestF64toa("-0.1234567890123456", -0.1234567890123456);
+  TestF64toa("-9.876543210987654", -9.876543210987654);
+  TestF64toa("0.00001234567890123456", 1.234567890123456e-5);
+  TestF64toa("1.2345678901234566e-7", 1.2345678901234566e-7);
+}
+
 }  // namespace
@@ -235,6 +235,15 @@ TEST(JsonPathWildcard, Primitive) {
   TestOk("\"hello\"", "$[*]", "");
 }
 
+TEST(JsonPathWildcard, SkipUnselectedValues) {
+  // the primitive elements under a nested wildcard are skipped
+  TestOk(R"([[5, {"id": 1}, "s"]])", "$[0][*].id", "[1]");
+  TestOk(R"({"a": {"b": [{"id": 3}, 5, null]}})", "$..b[*].id", "3");
+  // the object under an unsupported selector is skipped
+  TestNoMatch(R"([{"a": {"x": 1}}])", "$[0].a[*]");
+  TestNoMatch(R"({"a": {"x": {"y": 1}}, "b": 2})", "$.a[*]");
+}
+
 TEST(JsonPathWildcard, PrimitiveNoMatchErrorCode) {
   TestNoMatch("1", "$[*]");
   TestNoMatch("null", "$[*]");
@@ -497,11 +506,14 @@ TEST(JsonPath, InvalidJsonPathMore) {
   TestUnsupportedPath(json, R"($['a])");
 
   // Unsupported features / expressions
-  TestUnsupportedPath(json, "$..a");
+  TestUnsupportedPath(json, "$..");
+  TestUnsupportedPath(json, "$...a");
+  TestNoMatch(json, "$..a");
   TestUnsupportedPath(json, "$[a]");
   TestUnsupportedPath(json, "$[1:3]");
   TestUnsupportedPath(json, "$[0,1]");
-  TestUnsupportedPath(json, "$[?(@.a)]");
+  TestUnsupportedPath(json, "$[?(@.a > $.b)]");
+  TestNoMatch(json, "$[?(@.a)]");
 
   // Empty key
   TestUnsupportedPath(json, "$.");
@@ -547,6 +559,8 @@ TEST(JsonPath, InternalParserBranches) {
   EXPECT_TRUE(parse_ok("$[*]"));
   EXPECT_TRUE(parse_ok("$[0]"));
   EXPECT_TRUE(parse_ok("$[-1]"));
+  EXPECT_TRUE(parse_ok("$..a"));
+  EXPECT_TRUE(parse_ok("$..[0]"));
   // Use "\\u" to keep it as two chars: '\\' + 'u' (avoid universal-char-name).
   EXPECT_TRUE(parse_ok("$[\"\\uD83D\\uDE0A\"]"));
 
@@ -557,7 +571,7 @@ TEST(JsonPath, InternalParserBranches) {
   EXPECT_FALSE(parse_ok("$["));
   EXPECT_FALSE(parse_ok("$[01]"));
   EXPECT_FALSE(parse_ok("$[999999999999999999999999999999999999999999]"));
-  EXPECT_FALSE(parse_ok("$..a"));
+  EXPECT_FALSE(parse_ok("$..[a]"));
 }
 
 TEST(JsonPath, TruncatedJsonReturnsInvalidChar) {
@@ -762,7 +776,7 @@ TEST(JsonPathDom, NotFoundAndUnsupportedPath) {
   EXPECT_EQ(std::get<1>(not_found), kNotFoundByJsonPath);
   EXPECT_EQ(std::get<0>(not_found), "");
 
-  auto unsupported = GetByJsonPath(R"({"a":1})", "$..a");
+  auto unsupported = GetByJsonPath(R"({"a":1})", "$..");
   EXPECT_EQ(std::get<1>(unsupported), kUnsupportedJsonPath);
   EXPECT_EQ(std::get<0>(unsupported), "");
 }
@@ -893,4 +907,364 @@ TEST(JsonPathDump, SerializeAcceptsConstResult) {
   EXPECT_EQ(std::get<1>(dumped), kErrorNone);
   EXPECT_EQ(std::get<0>(dumped), "abc");
 }
+
+TEST(JsonPath, PreparedJson) {
+  std::string json = R"({"a": {"b": [1, {"c": "x"}, [3]], "d\"e": true},
+    "f": [{"g": 1}, {"g": 2}], "a": "duplicated", "n": null,)";
+  // an object looked up by a member index
+  json += R"("wide": {)";
+  for (int i = 0; i < 40; i++) {
+    json += "\"k" + std::to_string(i) + "\": " + std::to_string(i) + ", ";
+  }
+  json += R"("k0": "duplicated"}})";
+
+  PreparedJson prepared(json);
+  std::vector<std::string> paths = {
+      "$.a.b[1].c", "$.a.b",  "$.f[*].g", "$.a['d\"e']", "$.wide.k39",
+      "$.wide.k0",  "$.x",    "$.a.b[5]", "$.f[1]",       "$.n",
+  };
+  std::vector<JsonPointer> pointers = {
+      {"a", "b", 1, "c"}, {"a", "b", 2}, {"a", "d\"e"}, {"wide", "k0"},
+      {"wide", "k39"},    {"f", 1, "g"}, {"a", "x"},     {"a", "b", 3},
+      {"f", "g"},         {"n", 0},      {},
+  };
+  // the later rounds use the index
+  for (int round = 0; round < 2; round++) {
+    for (const auto& path : paths) {
+      EXPECT_EQ(prepared.GetByJsonPath<kSerializeJavaStyleFlag>(path),
+                GetByJsonPathOnDemand<kSerializeJavaStyleFlag>(json, path))
+          << path;
+    }
+    for (const auto& ptr : pointers) {
+      StringView got, expect;
+      auto got_ret = prepared.GetOnDemand(ptr, got);
+      auto expect_ret = GetOnDemand(json, ptr, expect);
+      EXPECT_EQ(got_ret.Error(), expect_ret.Error()) << round;
+      EXPECT_EQ(got, expect) << round;
+    }
+  }
+
+  Document doc;
+  auto ret = prepared.ParseOnDemand(doc, JsonPointer({"f", 1}));
+  EXPECT_EQ(ret.Error(), kErrorNone);
+  EXPECT_EQ(doc["g"].GetInt64(), 2);
+
+  PreparedJson invalid(R"({"a": {"b": 1,, "c": 2}})");
+  StringView target;
+  EXPECT_EQ(invalid.GetOnDemand(JsonPointer({"a", "c"}), target).Error(),
+            kParseErrorInvalidChar);
+  EXPECT_EQ(invalid.GetOnDemand(JsonPointer({"a", "c"}), target).Error(),
+            kParseErrorInvalidChar);
+}
+
+TEST(JsonPath, CompiledPlan) {
+  std::string json =
+      R"({"a": {"b": [1, {"c": "x"}, 3]}, "k\"e": "q", "d": [{"e": 1}, {"e": 2}]})";
+  std::vector<std::string> paths = {
+      "$.a.b[1].c", "$.a.b", "$['k\"e']", "$.d[*].e", "$.a.x", "$",
+      "$.a..b",     "",      "$[abc]",
+  };
+  for (const auto& path : paths) {
+    JsonPathPlan plan(path);
+    EXPECT_EQ(plan.GetJsonPath(), path);
+    // use the plan many times and by a copy
+    JsonPathPlan copy = plan;
+    for (int i = 0; i < 2; i++) {
+      EXPECT_EQ(GetByJsonPathOnDemand<kSerializeJavaStyleFlag>(json, plan),
+                GetByJsonPathOnDemand<kSerializeJavaStyleFlag>(json, path))
+          << path;
+      EXPECT_EQ(GetByJsonPath(json, copy), GetByJsonPath(json, path)) << path;
+    }
+    PreparedJson prepared(json);
+    EXPECT_EQ(prepared.GetByJsonPath(plan), GetByJsonPathOnDemand(json, path))
+        << path;
+  }
+
+  JsonPathPlan plan;
+  EXPECT_FALSE(plan.IsValid());
+  EXPECT_TRUE(plan.Compile("$.a.b[0]"));
+  EXPECT_EQ(std::get<0>(GetByJsonPathOnDemand(json, plan)), "1");
+  EXPECT_FALSE(plan.Compile("$.a["));
+  EXPECT_EQ(std::get<1>(GetByJsonPathOnDemand(json, plan)),
+            kUnsupportedJsonPath);
+}
+
+TEST(JsonPath, CompiledPlanReusesScratch) {
+  // the thread-local document and buffer are reused across rows, and dropped
+  // after a large row
+  JsonPathPlan plan("$.a");
+  std::string big(2 << 20, 'x');
+  std::string mid(256 << 10, 'x');
+  std::vector<std::pair<std::string, std::string>> rows = {
+      {R"({"a": [1, {"b": "s"}]})", R"([1,{"b":"s"}])"},
+      {R"({"a": "\u0041"})", "A"},
+      {R"({"a": ")" + big + R"("})", big},
+      {R"({"a": {"c": 12345678901234567890}})",
+       R"({"c":12345678901234567890})"},
+      {R"({"b": 1})", ""},
+      {R"({"a": 2.5})", "2.5"},
+      // the node stack of the parser is larger than the json
+      {R"({"a": ")" + mid + R"("})", mid},
+  };
+  for (int i = 0; i < 2; i++) {
+    for (const auto& row : rows) {
+      EXPECT_EQ(std::get<0>(GetByJsonPathOnDemand(row.first, plan)),
+                row.second);
+    }
+  }
+  auto& scratch = internal::OnDemandScratch::ThreadLocal();
+  EXPECT_LE(scratch.wb.Capacity(), internal::OnDemandScratch::kKeepBytes);
+  EXPECT_LE(scratch.dom_doc.ReuseCapacity(),
+            internal::OnDemandScratch::kKeepBytes);
+}
+
+TEST(JsonPath, PlanCache) {
+  JsonPathPlanCache cache(2);
+  auto a = cache.Get("$.a");
+  EXPECT_EQ(cache.Get(std::string("$.a")), a);
+  EXPECT_EQ(cache.Hits(), 1u);
+  EXPECT_EQ(cache.Misses(), 1u);
+
+  auto b = cache.Get("$.b");
+  cache.Get("$.a");
+  // $.b is the least recently used
+  auto c = cache.Get("$['c']");
+  EXPECT_EQ(cache.Size(), 2u);
+  EXPECT_EQ(cache.Get("$.a"), a);
+  EXPECT_NE(cache.Get("$.b"), b);
+  EXPECT_EQ(cache.Misses(), 4u);
+  // the evicted plans are still usable
+  EXPECT_EQ(std::get<0>(GetByJsonPathOnDemand(R"({"c": 2})", *c)), "2");
+  EXPECT_EQ(b->GetJsonPath(), "$.b");
+
+  EXPECT_FALSE(cache.Get("$.a[").get()->IsValid());
+  cache.Clear();
+  EXPECT_EQ(cache.Size(), 0u);
+
+  auto& local = JsonPathPlanCache::ThreadLocal();
+  EXPECT_EQ(&local, &JsonPathPlanCache::ThreadLocal());
+  EXPECT_EQ(std::get<0>(GetByJsonPathOnDemand(R"({"a": [1, 2]})",
+                                              *local.Get("$.a[1]"))),
+            "2");
+}
+
+TEST(JsonPath, Filter) {
+  std::string json = R"({"items": [
+    {"id": 1, "price": 5, "tag": "a", "dims": [1, 2]},
+    {"id": 2, "price": 12.5, "tag": "bA", "dims": [3, 4]},
+    {"id": 3, "price": 3e1, "tag": null},
+    {"id": 4, "price": "10", "ok": true},
+    {"id": 5, "price": -0.5, "ok": false},
+    7, "s", null, [1]]})";
+  std::vector<std::pair<std::string, std::string>> cases = {
+      {"$.items[?(@.price > 10)].id", "[2,3]"},
+      {"$.items[?@.price > 10].id", "[2,3]"},
+      {"$.items[?(@.price >= 12.5 && @.tag)].id", "[2,3]"},
+      {"$.items[?(@.price < 0 || @.price == '10')].id", "[4,5]"},
+      {"$.items[?(@.tag == 'bA')].id", "2"},
+      {"$.items[?(@.tag == \"a\" || @.tag == null)].id", "[1,3]"},
+      {"$.items[?(!@.tag && @.id != 5)].id", "4"},
+      {"$.items[?(!(@.ok == true))].id", "[1,2,3,5]"},
+      {"$.items[?(@.ok == false)].id", "5"},
+      {"$.items[?(@.dims[1] > 3)].id", "2"},
+      {"$.items[?(@['price'] <= 5)].id", "[1,5]"},
+      {"$.items[?(@ == 7 || @ == 's')]", "[7,\"s\"]"},
+      {"$.items[?(@[0] == 1)]", "[1]"},
+      {"$.items[?(@.price > 100)].id", ""},
+  };
+  for (const auto& c : cases) {
+    auto got = GetByJsonPathOnDemand<kSerializeJavaStyleFlag>(json, c.first);
+    EXPECT_EQ(std::get<0>(got), c.second) << c.first;
+    // the dom selects the same nodes
+    auto dom = GetByJsonPath(json, c.first);
+    EXPECT_EQ(std::get<0>(dom), c.second.empty() ? "null" : c.second)
+        << c.first;
+  }
+
+  std::vector<std::string> invalid = {
+      "$.items[?(@.price >)]", "$.items[?(@.price > 1]",
+      "$.items[?(@..a)]",      "$.items[?($.a)]",
+      "$.items[?(1)]",         "$.items[?(@.a == 01)]",
+      "$.items[?@.a == tru]",  "$.items[?(@[-1])]",
+  };
+  for (const auto& path : invalid) {
+    EXPECT_EQ(std::get<1>(GetByJsonPathOnDemand(json, path)),
+              kUnsupportedJsonPath)
+        << path;
+  }
+
+  // the invalid json in the filtered fields
+  auto got = GetByJsonPathOnDemand(R"([{"a": 1}, {"a": tru}])",
+                                   "$[?(@.a == 1)].a");
+  EXPECT_EQ(std::get<1>(got), kParseErrorInvalidChar);
+  got = GetByJsonPathOnDemand(R"([{"a": [1,}, "b": [1]}])", "$[?(@.a == @.b)]");
+  EXPECT_EQ(std::get<1>(got), kParseErrorInvalidChar);
+}
+
+TEST(JsonPath, FilterMembersAndContainers) {
+  std::vector<std::tuple<std::string, std::string, std::string>> cases = {
+      // the filter selects the member values of an object
+      {R"({"a": {"x": 1}, "b": {"x": 2}})", "$[?(@.x == 1)]", R"({"x":1})"},
+      {R"({"a": {"x": 1}, "b": 3, "c": {"x": 2}})", "$[?(@.x)].x", "[1,2]"},
+      {R"({"o": {"a": 1, "b": "s", "c": 2}})", "$.o[?(@ >= 2 || @ == 's')]",
+       R"(["s",2])"},
+      {R"({"a": {}})", "$[?(@.x)]", ""},
+      // the containers are compared structurally, not by the raw texts
+      {R"([{"a": [1, 2], "b": [1,2]}])", "$[?(@.a == @.b)]",
+       R"({"a":[1,2],"b":[1,2]})"},
+      {R"([{"a": {"k": 1, "j": [2]}, "b": {"j": [2], "k": 1}}])",
+       "$[?(@.a == @.b)].b.k", "1"},
+      {R"([{"a": {"k": 1}, "b": {"k": 2}}])", "$[?(@.a != @.b)].b.k", "2"},
+      {R"([{"a": [1], "b": [1, 2]}])", "$[?(@.a == @.b)]", ""},
+      // the numbers are decoded by the parser
+      {R"([{"x": 1e0}, {"x": -0.0}, {"x": 10.000000000000000000001}])",
+       "$[?(@.x <= 1 || @.x == 10)].x", "[1.0,-0.0,10.0]"},
+  };
+  for (const auto& c : cases) {
+    const auto& json = std::get<0>(c);
+    const auto& path = std::get<1>(c);
+    const auto& expect = std::get<2>(c);
+    auto got = GetByJsonPathOnDemand(json, path);
+    EXPECT_EQ(std::get<0>(got), expect) << path;
+    EXPECT_EQ(std::get<1>(got), expect.empty() ? kErrorNoneNoMatch : kErrorNone)
+        << path;
+  }
+  auto dom = GetByJsonPath(R"({"a": {"x": 1}, "b": {"x": 2}})",
+                           "$[?(@.x == 1)]");
+  EXPECT_EQ(std::get<0>(dom), R"({"x":1})");
+}
+
+TEST(JsonPath, FilterMatchesDom) {
+  // the values selected by the chained and nested filters are in a flat list,
+  // as the dom
+  std::vector<std::pair<std::string, std::string>> cases = {
+      {R"([{"p": 1, "c": [{"p": 2}, {"p": 3}]}])", "$[?(@.p==1)].c[?(@.p==2)]"},
+      {R"([{"p": 1, "c": [{"p": 2}]}, {"p": 1, "c": [{"p": 2}, 4]}])",
+       "$[?(@.p==1)].c[?(@.p==2)]"},
+      {R"([{"c": [1, 2]}, {"c": [3]}, {"d": 4}])", "$[?(@.c)].c[*]"},
+      {R"([{"c": {"d": [{"p": 2}, {"p": 1}]}}])", "$[?(@.c)].c.d[?(@.p==2)]"},
+      {R"([[{"p": 2}], [{"p": 3}]])", "$[*][?(@.p==2)]"},
+      {R"([{"a": [{"p": 2}, {"p": 2, "q": null}]}])",
+       "$[*].a[?(@.p==2)].q"},
+      {R"({"a": {"x": {"p": 1}, "y": {"p": 2}}})", "$.a[?(@.p)].p"},
+      {R"([{"a": [1, 2, 3]}, {"a": [4]}])", "$[?(@.a[0] > 0)].a[-1]"},
+      {R"([{"p": 1}])", "$[?(@.p == 2)]"},
+  };
+  for (const auto& c : cases) {
+    auto got = GetByJsonPathOnDemand(c.first, c.second);
+    auto dom = GetByJsonPath(c.first, c.second);
+    ASSERT_EQ(std::get<1>(dom), kErrorNone) << c.second;
+    // no match is empty on-demand, and null in the dom
+    const std::string expect =
+        std::get<0>(dom) == "null" ? "" : std::get<0>(dom);
+    EXPECT_EQ(std::get<0>(got), expect) << c.first << " " << c.second;
+  }
+
+  // the number out of range is the same error
+  std::vector<std::pair<std::string, std::string>> inf = {
+      {R"([{"p": 1e999}])", "$[?(@.p == 1)]"},
+      {R"([{"p": -1e999}])", "$[?(@.p < 1)].p"},
+      {R"([{"p": [1e999]}])", "$[?(@.p == @.p)]"},
+  };
+  for (const auto& c : inf) {
+    auto got = GetByJsonPathOnDemand(c.first, c.second);
+    auto dom = GetByJsonPath(c.first, c.second);
+    EXPECT_EQ(std::get<1>(dom), kParseErrorInfinity) << c.second;
+    EXPECT_EQ(std::get<1>(got), std::get<1>(dom)) << c.second;
+  }
+}
+
+TEST(JsonPath, Descendant) {
+  std::string json = R"({"id": 1, "a": {"id": 2, "b": [{"id": 3},
+    {"x": {"id": "s"}}, 5, null]}, "s": "\"id\": 9", "k\"e": {"id": 4},
+    "i\u0064": 7, "n": {"id": null}})";
+  std::vector<std::pair<std::string, std::string>> cases = {
+      {"$..id", R"([1,2,3,"s",4,7])"},
+      {"$..['id']", R"([1,2,3,"s",4,7])"},
+      {"$.a..id", R"([2,3,"s"])"},
+      {"$..x.id", "s"},
+      {"$..b[0]", R"({"id":3})"},
+      {"$..[1]", R"({"x":{"id":"s"}})"},
+      {"$.a.b..*", R"([{"id":3},3,{"x":{"id":"s"}},{"id":"s"},"s",5])"},
+      {"$..[?(@.id > 2)]", R"([{"id":3},{"id":4}])"},
+      {"$..[?(@.id)].id", R"([2,3,"s",4])"},
+      {"$..nope", ""},
+  };
+  for (const auto& c : cases) {
+    auto got = GetByJsonPathOnDemand<kSerializeJavaStyleFlag>(json, c.first);
+    EXPECT_EQ(std::get<0>(got), c.second) << c.first;
+    auto dom = GetByJsonPath(json, c.first);
+    EXPECT_EQ(std::get<0>(dom), c.second.empty() ? "null" : c.second)
+        << c.first;
+  }
+
+  // the keys across the blocks, and in the strings with escaped chars
+  std::string big = "[";
+  for (int i = 0; i < 200; i++) {
+    big += i ? "," : "";
+    big += R"({"name": "n\"id\": )" + std::to_string(i) +
+           R"(", "v": {"w": [1, {"x": )" + std::to_string(i) + "}]}";
+    if (i % 7 == 0) big += R"(, "id": )" + std::to_string(i);
+    if (i % 11 == 0) big += R"(, "\u0069d": "e)" + std::to_string(i) + "\"";
+    big += std::string(i % 64, ' ') + "}";
+  }
+  big += "]";
+  for (std::string path : {"$..id", "$..x", "$..w[1].x"}) {
+    auto got = GetByJsonPathOnDemand<kSerializeJavaStyleFlag>(big, path);
+    EXPECT_EQ(std::get<1>(got), kErrorNone) << path;
+    EXPECT_EQ(std::get<0>(got), std::get<0>(GetByJsonPath(big, path))) << path;
+  }
+
+  for (std::string path : {"$..", "$...a", "$..[a]", "$..[*"}) {
+    EXPECT_EQ(std::get<1>(GetByJsonPathOnDemand(json, path)),
+              kUnsupportedJsonPath)
+        << path;
+  }
+}
+
+TEST(JsonPath, DescendantMatchesDom) {
+  // the values selected with `..` are in a flat list, as the dom
+  std::vector<std::pair<std::string, std::string>> cases = {
+      {R"({"a": {"b": 1}, "x": {"a": {"c": {"b": 2}}}})", "$..a..b"},
+      {R"({"a": {"b": 1}})", "$..a..b"},
+      {R"({"a": [{"b": 1}, 2]})", "$..a[*].b"},
+      {R"({"b": [1, [2]], "c": {"b": [3, null]}})", "$..b[*]"},
+      {R"([{"a": 1}, {"x": {"a": [2, 3]}}])", "$[*]..a"},
+      {R"({"a": [1, 2, 3], "b": {"a": [4]}})", "$..a[-1]"},
+      {R"({"a": [{"p": 2}, {"p": 1}], "c": {"a": {"x": {"p": 3}}}})",
+       "$..a[?(@.p > 1)]"},
+      {R"({"x": {"y": {"z": 1}}, "y": {"z": "s"}})", "$..y.z"},
+      {R"({"a": {"a": {"a": 1}}})", "$..a"},
+      {R"([[1, [2]], {"k": [3]}])", "$..[0]"},
+      {R"({"a": {"b": {"c": 1}}, "d": [true, "s"]})", "$..*"},
+      {R"({"a": null, "b": {"a": 1}})", "$..a"},
+      {R"({"a": 1})", "$..b"},
+  };
+  for (const auto& c : cases) {
+    auto got = GetByJsonPathOnDemand(c.first, c.second);
+    auto dom = GetByJsonPath(c.first, c.second);
+    ASSERT_EQ(std::get<1>(dom), kErrorNone) << c.second;
+    // no match is empty on-demand, and null in the dom
+    const std::string expect =
+        std::get<0>(dom) == "null" ? "" : std::get<0>(dom);
+    EXPECT_EQ(std::get<0>(got), expect) << c.first << " " << c.second;
+  }
+
+  // the deeply nested json is walked without recursion
+  const size_t depth = 100000;
+  std::string objs;
+  for (size_t i = 0; i < depth; i++) objs += R"({"x":)";
+  objs += R"({"a":1})" + std::string(depth, '}');
+  std::string arrs = std::string(depth, '[') + "0,7" + std::string(depth, ']');
+  std::vector<std::pair<std::string, std::string>> deep = {
+      {objs, "$..a"}, {arrs, "$..[1]"}};
+  for (const auto& c : deep) {
+    auto got = GetByJsonPathOnDemand(c.first, c.second);
+    auto dom = GetByJsonPath(c.first, c.second);
+    EXPECT_EQ(std::get<1>(got), kErrorNone) << c.second;
+    EXPECT_EQ(std::get<1>(dom), kErrorNone) << c.second;
+    EXPECT_EQ(std::get<0>(got), std::get<0>(dom)) << c.second;
+  }
+  EXPECT_EQ(std::get<0>(GetByJsonPath(arrs, "$..[1]")), "7");
+}
 }  // namespace
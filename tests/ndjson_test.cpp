@@ -0,0 +1,106 @@
+/*
+ * Copyright 2022 ByteDance Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "sonic/sonic.h"
+
+namespace {
+
+using namespace sonic_json;
+
+template <typename T>
+class NdjsonTest : public testing::Test {};
+
+using NdjsonTypes =
+    testing::Types<GenericNdjsonParser<DNode<MemoryPoolAllocator<>>>,
+                   GenericNdjsonParser<DNode<SimpleAllocator>>>;
+TYPED_TEST_SUITE(NdjsonTest, NdjsonTypes);
+
+TYPED_TEST(NdjsonTest, Parse) {
+  using NdjsonParser = TypeParam;
+  std::vector<std::string> records = {
+      R"({"a":"x\"}\n{","b":[1,2,{"c":null}]})",
+      "123",
+      R"("\\")",
+      R"(  {"long":")" + std::string(200, 'x') + R"("} )",
+      "[]",
+      "\t{}\r",
+  };
+  std::string input;
+  for (size_t i = 0; i < 50; i++) {
+    input += records[i % records.size()] + "\n";
+    // blank lines are ignored
+    if (i % 7 == 0) input += "  \n";
+  }
+  input.pop_back();  // the last newline is optional
+
+  for (size_t threads : {1, 3}) {
+    for (size_t batch : {64, 1 << 20}) {
+      NdjsonParser parser(threads, batch);
+      size_t i = 0;
+      auto ret = parser.Parse(input, [&](auto& doc) {
+        typename NdjsonParser::DocumentType expect;
+        expect.Parse(records[i % records.size()]);
+        EXPECT_EQ(doc, expect) << i;
+        i++;
+      });
+      EXPECT_EQ(ret.Error(), kErrorNone);
+      EXPECT_EQ(i, 50) << threads << " " << batch;
+    }
+  }
+
+  // the threads are kept for the later batches and inputs
+  NdjsonParser parser(4, 64);
+  for (int round = 0; round < 3; round++) {
+    size_t i = 0;
+    auto ret = parser.Parse(input, [&](auto&) { i++; });
+    EXPECT_EQ(ret.Error(), kErrorNone);
+    EXPECT_EQ(i, 50) << round;
+    EXPECT_EQ(parser.Parse("1\n[3,]", [](auto&) {}).Error(),
+              kParseErrorInvalidChar);
+  }
+}
+
+TYPED_TEST(NdjsonTest, Error) {
+  using NdjsonParser = TypeParam;
+  struct ErrorTest {
+    std::string input;
+    SonicError err;
+    size_t offset;
+    size_t visited;
+  };
+  std::vector<ErrorTest> tests = {
+      {"1\n2\n[3,]\n4", kParseErrorInvalidChar, 8, 2},
+      {"{}\n{} {}", kParseErrorInvalidChar, 6, 1},
+      // the newline in string is not a record boundary
+      {"1\n[\"a\nb\"]\n2", kParseErrorUnEscaped, 4, 1},
+  };
+  for (const auto& t : tests) {
+    for (size_t threads : {1, 2}) {
+      NdjsonParser parser(threads);
+      size_t visited = 0;
+      auto ret = parser.Parse(t.input, [&](auto&) { visited++; });
+      EXPECT_EQ(ret.Error(), t.err) << t.input;
+      EXPECT_EQ(ret.Offset(), t.offset) << t.input;
+      EXPECT_EQ(visited, t.visited) << t.input;
+    }
+  }
+}
+
+}  // namespace
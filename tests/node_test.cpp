@@ -527,6 +527,79 @@ TYPED_TEST(NodeTest, RemoveMemberWithDupKey) {
   EXPECT_TRUE(node_map.Empty());
 }
 
+TYPED_TEST(NodeTest, MemberMap) {
+  using NodeType = TypeParam;
+  using Allocator = typename NodeType::alloc_type;
+  Allocator a;
+  NodeType linear(kObject), indexed(kObject);
+  EXPECT_TRUE(indexed.CreateMap(a));
+
+  // grow the map several times, and remove members from the middle
+  for (int i = 0; i < 2000; ++i) {
+    std::string key = "key" + std::to_string(i);
+    linear.AddMember(key, NodeType(i), a);
+    indexed.AddMember(key, NodeType(i), a);
+    if (i % 3 == 2) {
+      std::string removed = "key" + std::to_string(i / 2);
+      EXPECT_EQ(linear.RemoveMember(removed), indexed.RemoveMember(removed));
+    }
+  }
+  ASSERT_EQ(linear.Size(), indexed.Size());
+  for (int i = 0; i < 2100; ++i) {
+    std::string key = "key" + std::to_string(i);
+    auto l = linear.FindMember(key);
+    auto m = indexed.FindMember(key);
+    ASSERT_EQ(l == linear.MemberEnd(), m == indexed.MemberEnd()) << key;
+    if (l != linear.MemberEnd()) {
+      EXPECT_TRUE(m->name == key);
+      EXPECT_EQ(l->value.GetInt64(), m->value.GetInt64());
+    }
+  }
+
+  // the first added one of the duplicated keys is found
+  NodeType dup(kObject);
+  dup.CreateMap(a);
+  for (int i = 0; i < 20; ++i) {
+    dup.AddMember("a", NodeType(i), a);
+    dup.AddMember("b" + std::to_string(i), NodeType(i), a);
+  }
+  EXPECT_EQ(dup["a"].GetInt64(), 0);
+  EXPECT_TRUE(dup.RemoveMember("a"));
+  EXPECT_EQ(dup["a"].GetInt64(), 1);
+  // the tail is moved by removing and still found
+  EXPECT_TRUE(dup.RemoveMember("b0"));
+  EXPECT_EQ(dup["b19"].GetInt64(), 19);
+  EXPECT_EQ(dup["a"].GetInt64(), 1);
+}
+
+TYPED_TEST(NodeTest, FindMemberByLength) {
+  using NodeType = TypeParam;
+  using Allocator = typename NodeType::alloc_type;
+  Allocator a;
+  NodeType obj(kObject);
+  // the keys of the same length differ in the head, middle or tail
+  for (size_t len = 0; len <= 40; ++len) {
+    std::string key(len, 'k');
+    obj.AddMember(key, NodeType(int64_t(len)), a);
+    if (len == 0) continue;
+    for (size_t pos : {size_t(0), len / 2, len - 1}) {
+      std::string other = key;
+      other[pos] = 'x';
+      obj.AddMember(other, NodeType(-1), a);
+    }
+  }
+  for (size_t len = 0; len <= 40; ++len) {
+    std::string key(len, 'k');
+    auto m = obj.FindMember(key);
+    ASSERT_TRUE(m != obj.MemberEnd()) << len;
+    EXPECT_EQ(m->value.GetInt64(), int64_t(len));
+    EXPECT_TRUE(obj.FindMember(key.data(), key.size()) == m);
+    if (len > 0) {
+      EXPECT_FALSE(obj.HasMember(std::string(len, 'z')));
+    }
+  }
+}
+
 TYPED_TEST(NodeTest, Erase) {
   using NodeType = TypeParam;
   using Allocator = typename NodeType::alloc_type;
@@ -868,6 +941,55 @@ TEST(DNodeTest, OwnedRawAndNumStrFreed) {
   EXPECT_EQ(CountingAllocator::malloc_cnt, CountingAllocator::free_cnt);
 }
 
+TEST(DNodeTest, AutoMap) {
+  using NodeType = DNode<CountingAllocator>;
+  CountingAllocator a;
+  CountingAllocator::Reset();
+  {
+    NodeType root(kArray), small(kObject), obj(kObject);
+    for (int i = 0; i < 64; ++i) {
+      obj.AddMember("key" + std::to_string(i), NodeType(i), a);
+    }
+    small.AddMember("key", NodeType(0), a);
+    root.PushBack(std::move(small), a).PushBack(std::move(obj), a);
+
+    // only the large object is traced
+    size_t mallocs = CountingAllocator::malloc_cnt;
+    EXPECT_TRUE(root.EnableAutoMap(a, 32, 16));
+    EXPECT_EQ(CountingAllocator::malloc_cnt, mallocs + 1);
+
+    // the map is created by the 16th lookup
+    NodeType& traced = root[1];
+    for (int i = 0; i < 15; ++i) {
+      EXPECT_EQ(traced["key" + std::to_string(i)].GetInt64(), i);
+    }
+    EXPECT_EQ(CountingAllocator::malloc_cnt, mallocs + 1);
+    EXPECT_EQ(traced["key15"].GetInt64(), 15);
+    EXPECT_EQ(CountingAllocator::malloc_cnt, mallocs + 2);
+    for (int i = 0; i < 64; ++i) {
+      EXPECT_EQ(traced["key" + std::to_string(i)].GetInt64(), i);
+    }
+    EXPECT_FALSE(traced.HasMember("key64"));
+    EXPECT_EQ(CountingAllocator::malloc_cnt, mallocs + 2);
+
+    // the map is maintained, and destroyed after many changes
+    size_t frees = CountingAllocator::free_cnt;
+    for (int i = 64; i < 96; ++i) {
+      traced.AddMember("key" + std::to_string(i), NodeType(i), a);
+      EXPECT_TRUE(traced.RemoveMember("key" + std::to_string(i - 64)));
+      EXPECT_EQ(traced["key" + std::to_string(i)].GetInt64(), i);
+    }
+    EXPECT_GT(CountingAllocator::free_cnt, frees);
+    for (int i = 32; i < 96; ++i) {
+      EXPECT_EQ(traced["key" + std::to_string(i)].GetInt64(), i);
+    }
+    EXPECT_FALSE(traced.HasMember("key0"));
+
+    traced.DestroyMap();
+    EXPECT_EQ(traced["key95"].GetInt64(), 95);
+  }
+}
+
 TEST(DNodeTest, CopyRawOrNumStrWithNullAllocatorDoesNotCrash) {
 #if defined(_WIN32)
   GTEST_SKIP() << "Subprocess exit assertions are not enabled on Windows here.";
@@ -175,4 +175,29 @@ TEST(ParseSchema, ParseOverflowNumAsNumStr) {
   EXPECT_EQ(doc["val"].GetStringView(), "18446744073709551616");
 }
 
+TEST(ParseSchema, Stream) {
+  std::string schema = R"({"a":null,"b":{"c":null},"e":[]})";
+  std::string json =
+      R"({"x":[{"a":1}, "y\"z"], "a":"str\n", "b":{"d":{}, "c":[1,2]},)"
+      R"( "e":[true, {"f":"g"}], "h":-1.5})";
+  std::string expect = R"({"a":"str\n","b":{"c":[1,2]},"e":[true,{"f":"g"}]})";
+  Document expect_doc;
+  expect_doc.Parse(expect);
+  ASSERT_FALSE(expect_doc.HasParseError());
+
+  for (size_t chunk = 1; chunk <= json.size(); chunk++) {
+    Document doc;
+    doc.Parse(schema);
+    SchemaHandler<Node> sax(&doc, doc.GetAllocator());
+    ASSERT_TRUE(sax.SetUp(StringView()));
+    StreamParser<> parser;
+    for (size_t i = 0; i < json.size(); i += chunk) {
+      std::string part = json.substr(i, chunk);
+      ASSERT_EQ(parser.Feed(part.data(), part.size(), sax).Error(), kErrorNone);
+    }
+    ASSERT_EQ(parser.Finish(sax).Error(), kErrorNone);
+    EXPECT_TRUE(doc == expect_doc) << chunk << doc.Dump();
+  }
+}
+
 }  // namespace
@@ -52,6 +52,16 @@ void TestParseDouble(double num, const std::string& input) {
     EXPECT_FALSE(doc.HasParseError()) << input;
     EXPECT_TRUE(doc.IsDouble()) << input;
     EXPECT_DOUBLE_EQ(num, doc.GetDouble()) << input;
+
+    // the lazy number is decoded to the same double, and keeps its text
+    Document lazy;
+    lazy.Parse<ParseFlags::kParseLazyNumbers>(input.data(), input.size());
+    EXPECT_FALSE(lazy.HasParseError()) << input;
+    EXPECT_TRUE(lazy.IsDouble()) << input;
+    EXPECT_EQ(lazy, doc) << input;
+    // the huge exponents are decoded when parsing
+    std::string dump = lazy.Dump();
+    EXPECT_TRUE(dump == input || dump == doc.Dump()) << input;
   }
   // test native atof
   { EXPECT_DOUBLE_EQ(num, internal::AtofNative(input.data(), input.size())); }
@@ -91,6 +101,8 @@ void TestParseError(const std::string& input, size_t off, SonicError err) {
   doc.Parse(input.data(), input.size());
   EXPECT_TRUE(doc.HasParseError()) << input;
   EXPECT_EQ(doc.GetParseError(), err) << input;
+  doc.Parse<ParseFlags::kParseLazyNumbers>(input.data(), input.size());
+  EXPECT_EQ(doc.GetParseError(), err) << input;
   // TODO: test offset
   (void)(off);
 }
@@ -187,6 +199,46 @@ TEST(ParserTest, ParseIntegerAsRaw) {
   }
 }
 
+TEST(ParserTest, ParseLazyNumbers) {
+  constexpr ParseFlags kLazy = ParseFlags::kParseLazyNumbers;
+  std::string json =
+      R"({"a":[1.50,-0.0e0,3E2,1,-2,0.000],"b":{"c":12345678901234567890.5}})";
+  Document doc, expect;
+  doc.Parse<kLazy>(json);
+  expect.Parse(json);
+  ASSERT_FALSE(doc.HasParseError());
+  EXPECT_EQ(doc, expect);
+  // the integers are decoded when parsing
+  EXPECT_TRUE(doc["a"][3].IsUint64());
+  EXPECT_EQ(doc["a"][4].GetInt64(), -2);
+  EXPECT_TRUE(doc["a"][0].IsDouble());
+  EXPECT_FALSE(doc["a"][0].IsInt64());
+  EXPECT_EQ(doc["a"][0].GetDouble(), 1.5);
+  EXPECT_EQ(doc["a"][0], 1.5);
+  EXPECT_TRUE(std::signbit(doc["a"][1].GetDouble()));
+  EXPECT_EQ(doc["b"]["c"].GetDouble(), 12345678901234567890.5);
+  // the undecoded numbers are written as their text
+  EXPECT_EQ(doc.Dump(), json);
+
+  // the copies are decoded, so they don't refer to the parsed buffer
+  MemoryPoolAllocator<> a;
+  auto copied = std::make_unique<Node>(doc, a);
+  doc.Parse<kLazy>("[]");
+  EXPECT_EQ(*copied, expect);
+  EXPECT_EQ(copied->Dump(), expect.Dump());
+
+  doc.Parse<kLazy>("[0.5]");
+  doc[0].SetDouble(2.5);
+  EXPECT_EQ(doc.Dump(), "[2.5]");
+
+  // the text is kept in the borrowed input
+  std::string padded = json + std::string(SONICJSON_PADDING, '\0');
+  doc.Parse<kLazy | ParseFlags::kParseBorrowInput>(padded.data(), json.size());
+  ASSERT_FALSE(doc.HasParseError());
+  EXPECT_EQ(doc, expect);
+  EXPECT_EQ(doc.Dump(), json);
+}
+
 TEST(ParserTest, AllowUnescapedControlChars) {
   std::string s = "\"";
   s.push_back('\t');
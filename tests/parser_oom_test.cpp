@@ -195,6 +195,20 @@ TEST(Document, ParseImplHandlesRepeatedOomCleanly) {
   EXPECT_EQ(doc.GetParseError(), kErrorNoMem);
 }
 
+TEST(Document, OomKeepsArrayPacked) {
+  OomAfterNthAllocator alloc(1000);
+  GenericDocument<DNode<OomAfterNthAllocator>> doc(&alloc);
+  doc.Parse<ParseFlags::kParsePackNumberArrays>("[1.5,2.5]");
+  ASSERT_FALSE(doc.HasParseError());
+  alloc.remaining = 0;
+  EXPECT_TRUE(doc.Begin() == doc.End());
+  doc.PushBack(DNode<OomAfterNthAllocator>(3.5), alloc);
+  // the values can't be made into nodes without memory
+  EXPECT_TRUE(doc[1].IsNull());
+  EXPECT_EQ(doc.GetDoubleSpan().size(), 2u);
+  EXPECT_EQ(doc.Dump(), "[1.5,2.5]");
+}
+
 struct SentinelTrackingAllocator {
   static int balance;
   void* Malloc(size_t n) {
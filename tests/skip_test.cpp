@@ -102,4 +102,42 @@ TEST(GetOnDemand, Failed) {
 
   TestGetOnDemandFailed(R"("\")", {}, ParseResult(kParseErrorInvalidChar, 3));
 }
+
+TEST(GetOnDemand, MultiPointers) {
+  std::string json = R"({
+    "a": {"b": [1, {"c": "x"}, 3], "d\"e": true},
+    "f": [[1, 2], [3, 4]],
+    "a": {"b": "duplicated"},
+    "g": {"h": null}, "i": 10
+  })";
+  std::vector<JsonPointer> paths = {
+      {"a", "b", 1, "c"}, {"a", "b"}, {"f", 1, 0}, {"a", "d\"e"},
+      {"a", "b", 1, "c"}, {"f", 5},   {"a", "x"},  {"a", 0},
+      {"f", -1},          {"f", 0},   {"i"},       {},
+  };
+  std::vector<StringView> targets;
+  auto result = GetOnDemand(json, paths, targets);
+  EXPECT_EQ(result.Error(), kErrorNone);
+  ASSERT_EQ(targets.size(), paths.size());
+  for (size_t i = 0; i < paths.size(); i++) {
+    // the same as getting them one by one
+    StringView expect;
+    GetOnDemand(json, paths[i], expect);
+    EXPECT_EQ(targets[i], expect) << i;
+  }
+  EXPECT_EQ(targets[0], "\"x\"");
+  EXPECT_EQ(targets[1], R"([1, {"c": "x"}, 3])");
+  EXPECT_EQ(targets[5], "");
+
+  // stops when all targets are found
+  JsonPointerTrie trie(std::vector<JsonPointer>{{"a", "b", 0}, {"f", 0}});
+  result = GetOnDemand(json, trie, targets);
+  EXPECT_EQ(result.Error(), kErrorNone);
+  EXPECT_EQ(targets, std::vector<StringView>({"1", "[1, 2]"}));
+  EXPECT_EQ(result.Offset(), json.find("[1, 2]") + 6);
+
+  result = GetOnDemand(R"({"a": [1, 2}, "b": 1})", trie, targets);
+  EXPECT_EQ(result.Error(), kParseErrorInvalidChar);
+  EXPECT_EQ(targets, std::vector<StringView>({"", ""}));
+}
 }  // namespace
@@ -0,0 +1,154 @@
+/*
+ * Copyright 2022 ByteDance Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "sonic/sonic.h"
+
+namespace struct_test {
+
+struct Point {
+  double x = 0;
+  double y = 0;
+};
+SONIC_DEFINE_FIELDS(Point, x, y)
+
+struct User {
+  int64_t id = 0;
+  uint32_t age = 0;
+  bool active = false;
+  std::string name;
+  std::vector<std::string> tags;
+  std::optional<Point> home;
+  std::optional<int> score;
+  std::vector<Point> path;
+  std::vector<std::vector<int>> grid;
+};
+SONIC_DEFINE_FIELDS(User, id, age, active, name, tags, home, score, path,
+                    grid)
+
+}  // namespace struct_test
+
+namespace {
+
+using namespace sonic_json;
+using struct_test::Point;
+using struct_test::User;
+
+TEST(StructParser, Basic) {
+  std::string json = R"({
+    "id": -42, "age": 30, "active": true, "name": "a\nbé",
+    "unknown": {"nested": [1, 2, {"x": 1}], "s": "\"}"},
+    "tags": ["t1", "t2"], "home": {"y": 2.5, "x": -1, "z": null},
+    "score": null, "path": [{"x": 1, "y": 2}, {"x": 3e2, "y": 4}],
+    "grid": [[1, 2], [], [3]]
+  })";
+  User u;
+  u.score = 7;
+  ParseResult ret = ParseStruct(json, u);
+  ASSERT_EQ(ret.Error(), kErrorNone) << ret.Offset();
+  EXPECT_EQ(u.id, -42);
+  EXPECT_EQ(u.age, 30u);
+  EXPECT_TRUE(u.active);
+  EXPECT_EQ(u.name, "a\nb\xc3\xa9");
+  EXPECT_EQ(u.tags, (std::vector<std::string>{"t1", "t2"}));
+  ASSERT_TRUE(u.home.has_value());
+  EXPECT_EQ(u.home->x, -1);
+  EXPECT_EQ(u.home->y, 2.5);
+  EXPECT_FALSE(u.score.has_value());
+  ASSERT_EQ(u.path.size(), 2u);
+  EXPECT_EQ(u.path[1].x, 300);
+  EXPECT_EQ(u.path[1].y, 4);
+  EXPECT_EQ(u.grid, (std::vector<std::vector<int>>{{1, 2}, {}, {3}}));
+
+  // the vectors are cleared, and the absent members are kept
+  StructParser p;
+  ret = p.Parse(R"({"tags": ["t3"], "grid": []})", u);
+  ASSERT_EQ(ret.Error(), kErrorNone);
+  EXPECT_EQ(u.tags, (std::vector<std::string>{"t3"}));
+  EXPECT_TRUE(u.grid.empty());
+  EXPECT_EQ(u.id, -42);
+
+  // a vector of structs as the root
+  std::vector<Point> points;
+  ret = p.Parse(R"([{"x": 1}, {"y": 2}])", points);
+  ASSERT_EQ(ret.Error(), kErrorNone);
+  ASSERT_EQ(points.size(), 2u);
+  EXPECT_EQ(points[0].x, 1);
+  EXPECT_EQ(points[1].y, 2);
+}
+
+TEST(StructParser, BorrowInput) {
+  std::string json = R"({"name": "a\tb", "zz": "\"", "tags": ["A", "c"]})";
+  json.append(SONICJSON_PADDING, '\0');
+  User u;
+  ParseResult ret = ParseStruct<ParseFlags::kParseBorrowInput>(
+      StringView(json.data(), json.size() - SONICJSON_PADDING), u);
+  ASSERT_EQ(ret.Error(), kErrorNone);
+  EXPECT_EQ(u.name, "a\tb");
+  EXPECT_EQ(u.tags, (std::vector<std::string>{"A", "c"}));
+}
+
+TEST(StructParser, Errors) {
+  struct Case {
+    std::string json;
+    SonicError err;
+  };
+  std::vector<Case> cases = {
+      {R"({"id": "1"})", kParseErrorMismatchType},
+      {R"({"id": 1.5})", kParseErrorMismatchType},
+      {R"({"age": -1})", kParseErrorMismatchType},
+      {R"({"age": 4294967296})", kParseErrorMismatchType},
+      {R"({"active": 1})", kParseErrorMismatchType},
+      {R"({"name": null})", kParseErrorMismatchType},
+      {R"({"tags": {}})", kParseErrorMismatchType},
+      {R"({"home": []})", kParseErrorMismatchType},
+      {R"({"grid": [[1, true]]})", kParseErrorMismatchType},
+      {R"([])", kParseErrorMismatchType},
+      {R"({"id": 1,})", kParseErrorInvalidChar},
+      {R"({"unknown": [1, 2)", kParseErrorInvalidChar},
+      {R"({"id": 1} x)", kParseErrorInvalidChar},
+  };
+  for (const auto& c : cases) {
+    User u;
+    EXPECT_EQ(ParseStruct(c.json, u).Error(), c.err) << c.json;
+  }
+}
+
+TEST(StructParser, SameAsDocument) {
+  std::string json = R"([
+    {"id": 1, "name": "x", "tags": ["a"], "score": 3},
+    {"id": 2, "name": "y", "home": {"x": 1.5, "y": -2}, "extra": [null]}
+  ])";
+  std::vector<User> users;
+  ASSERT_EQ(ParseStruct(json, users).Error(), kErrorNone);
+  Document doc;
+  doc.Parse(json);
+  ASSERT_FALSE(doc.HasParseError());
+  ASSERT_EQ(users.size(), doc.Size());
+  for (size_t i = 0; i < users.size(); i++) {
+    EXPECT_EQ(users[i].id, doc[i]["id"].GetInt64());
+    EXPECT_EQ(users[i].name, doc[i]["name"].GetString());
+  }
+  EXPECT_EQ(users[0].score, std::optional<int>(3));
+  EXPECT_EQ(users[1].home->x, doc[1]["home"]["x"].GetDouble());
+}
+
+}  // namespace
@@ -0,0 +1,124 @@
+/*
+ * Copyright 2022 ByteDance Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cmath>
+#include <limits>
+#include <cstdint>
+#include <map>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "sonic/sonic.h"
+
+namespace struct_serialize_test {
+
+struct Item {
+  std::string name;
+  double price = 0;
+  std::optional<int> count;
+};
+SONIC_DEFINE_FIELDS(Item, name, price, count)
+
+struct Order {
+  uint64_t id = 0;
+  int8_t level = 0;
+  bool paid = false;
+  float discount = 0;
+  std::vector<Item> items;
+  std::map<std::string, std::vector<int>> groups;
+  std::optional<Item> gift;
+  std::vector<std::optional<std::string>> notes;
+};
+SONIC_DEFINE_FIELDS(Order, id, level, paid, discount, items, groups, gift,
+                    notes)
+
+}  // namespace struct_serialize_test
+
+namespace {
+
+using namespace sonic_json;
+using struct_serialize_test::Item;
+using struct_serialize_test::Order;
+
+Order MakeOrder() {
+  Order o;
+  o.id = 18446744073709551615ULL;
+  o.level = -3;
+  o.paid = true;
+  o.discount = 0.5f;
+  o.items = {{"a\"b\n", 1.25, 3}, {"\xe4\xbd\xa0", -0.0, std::nullopt}};
+  o.groups = {{"x", {1, 2}}, {"y\\", {}}};
+  o.notes = {std::string("n"), std::nullopt};
+  return o;
+}
+
+TEST(StructSerialize, Basic) {
+  WriteBuffer wb;
+  ASSERT_EQ(SerializeStruct(MakeOrder(), wb), kErrorNone);
+  EXPECT_EQ(
+      wb.ToStringView(),
+      R"({"id":18446744073709551615,"level":-3,"paid":true,"discount":0.5,)"
+      R"("items":[{"name":"a\"b\n","price":1.25,"count":3},)"
+      R"({"name":"你","price":-0.0}],"groups":{"x":[1,2],"y\\":[]},)"
+      R"("notes":["n",null]})");
+
+  // the same as building a document and serializing it
+  Document doc;
+  doc.Parse(wb.ToStringView());
+  ASSERT_FALSE(doc.HasParseError());
+  WriteBuffer wb2;
+  doc.Serialize(wb2);
+  EXPECT_EQ(wb.ToStringView(), wb2.ToStringView());
+
+  // round trip by ParseStruct
+  Order o;
+  ASSERT_EQ(ParseStruct(wb.ToStringView(), o).Error(), kErrorNone);
+  WriteBuffer wb3;
+  ASSERT_EQ(SerializeStruct(o, wb3), kErrorNone);
+  EXPECT_EQ(wb.ToStringView(), wb3.ToStringView());
+  EXPECT_EQ(o.groups, MakeOrder().groups);
+}
+
+TEST(StructSerialize, Values) {
+  WriteBuffer wb;
+  SerializeStruct(std::vector<int>{}, wb);
+  EXPECT_EQ(wb.ToStringView(), "[]");
+  SerializeStruct(Order().groups, wb);
+  EXPECT_EQ(wb.ToStringView(), "{}");
+  SerializeStruct(std::optional<Item>(), wb);
+  EXPECT_EQ(wb.ToStringView(), "null");
+  SerializeStruct(Item(), wb);
+  EXPECT_EQ(wb.ToStringView(), R"({"name":"","price":0.0})");
+  SerializeStruct(std::string("x"), wb);
+  SerializeStruct<SerializeFlags::kSerializeAppendBuffer>(int64_t(-1), wb);
+  EXPECT_EQ(wb.ToStringView(), R"("x"-1)");
+}
+
+TEST(StructSerialize, Infinity) {
+  Item item{"x", std::numeric_limits<double>::infinity(), 1};
+  WriteBuffer wb;
+  wb.Push('[');
+  EXPECT_EQ(SerializeStruct<SerializeFlags::kSerializeAppendBuffer>(item, wb),
+            kSerErrorInfinity);
+  EXPECT_EQ(wb.ToStringView(), "[");
+  EXPECT_EQ(SerializeStruct<SerializeFlags::kSerializeInfNan>(item, wb),
+            kErrorNone);
+  EXPECT_EQ(wb.ToStringView(), R"({"name":"x","price":"Infinity","count":1})");
+}
+
+}  // namespace
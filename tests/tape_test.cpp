@@ -0,0 +1,188 @@
+/*
+ * Copyright 2022 ByteDance Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "sonic/sonic.h"
+
+namespace {
+
+using namespace sonic_json;
+
+static std::string get_json(const std::string& file) {
+  std::ifstream ifs(file);
+  std::stringstream ss;
+  ss << ifs.rdbuf();
+  return ss.str();
+}
+
+// Compare the tape with the DNode document value by value.
+static void ExpectSame(const TapeNode& tape, const Node& node) {
+  ASSERT_EQ(tape.GetType(), node.GetType());
+  switch (node.GetType()) {
+    case kObject: {
+      ASSERT_EQ(tape.Size(), node.Size());
+      auto m = tape.MemberBegin();
+      for (auto n = node.MemberBegin(); n != node.MemberEnd(); ++n, ++m) {
+        ASSERT_EQ(m->name.GetStringView(), n->name.GetStringView());
+        ExpectSame(m->value, n->value);
+      }
+      EXPECT_TRUE(m == tape.MemberEnd());
+      break;
+    }
+    case kArray: {
+      ASSERT_EQ(tape.Size(), node.Size());
+      auto i = tape.Begin();
+      for (auto n = node.Begin(); n != node.End(); ++n, ++i) {
+        ExpectSame(*i, *n);
+      }
+      EXPECT_TRUE(i == tape.End());
+      break;
+    }
+    case kStringCopy:
+      EXPECT_EQ(tape.GetStringView(), node.GetStringView());
+      break;
+    case kUint:
+      EXPECT_EQ(tape.GetUint64(), node.GetUint64());
+      break;
+    case kSint:
+      EXPECT_EQ(tape.GetInt64(), node.GetInt64());
+      break;
+    case kReal:
+      EXPECT_EQ(tape.GetDouble(), node.GetDouble());
+      break;
+    default:
+      break;
+  }
+}
+
+TEST(TapeDocument, ParseTestdata) {
+  for (auto file : {"book", "canada", "citm_catalog", "github_events",
+                    "gsoc-2018", "lottie", "poet", "twitter",
+                    "twitterescaped"}) {
+    std::string json = get_json(std::string("./testdata/") + file + ".json");
+    Document doc;
+    doc.Parse(json);
+    ASSERT_FALSE(doc.HasParseError()) << file;
+    TapeDocument tape;
+    tape.Parse(json);
+    ASSERT_FALSE(tape.HasParseError()) << file;
+    ExpectSame(tape, doc);
+
+    WriteBuffer wb1, wb2;
+    EXPECT_EQ(doc.Serialize(wb1), kErrorNone);
+    EXPECT_EQ(tape.Serialize(wb2), kErrorNone);
+    EXPECT_EQ(wb1.ToStringView(), wb2.ToStringView()) << file;
+  }
+}
+
+TEST(TapeDocument, Serialize) {
+  std::vector<std::string> tests = {
+      "null",
+      "true",
+      "-1",
+      "1.5",
+      "18446744073709551615",
+      R"("a\"中\n")",
+      "[]",
+      "{}",
+      R"([[],{},[{}],{"a":[]}])",
+      R"({"a":{"b":[1,-2,3.5,"c",true,false,null]},"d":"e"})",
+  };
+  TapeDocument doc;
+  for (const auto& json : tests) {
+    doc.Parse(json);
+    ASSERT_FALSE(doc.HasParseError()) << json;
+    WriteBuffer wb;
+    EXPECT_EQ(doc.Serialize(wb), kErrorNone);
+    Document expect;
+    expect.Parse(json);
+    WriteBuffer wb_expect;
+    expect.Serialize(wb_expect);
+    EXPECT_EQ(wb.ToStringView(), wb_expect.ToStringView()) << json;
+  }
+
+  // serialize a nested node and append to the buffer
+  doc.Parse(R"({"a":[1,{"b":"c"}],"d":2})");
+  WriteBuffer wb;
+  wb.Push('#');
+  EXPECT_EQ(doc["a"].Serialize<SerializeFlags::kSerializeAppendBuffer>(wb),
+            kErrorNone);
+  EXPECT_STREQ(wb.ToString(), R"(#[1,{"b":"c"}])");
+
+  // raw numbers are written as they are
+  doc.Parse<ParseFlags::kParseIntegerAsRaw>("[1,-0,123]");
+  ASSERT_FALSE(doc.HasParseError());
+  EXPECT_TRUE(doc[0].IsRaw());
+  EXPECT_EQ(doc.Serialize(wb), kErrorNone);
+  EXPECT_STREQ(wb.ToString(), "[1,-0,123]");
+}
+
+TEST(TapeDocument, Access) {
+  TapeDocument doc;
+  doc.Parse(R"({"a":{"b":[1,{"c":"x\ty"}],"e":{}},"f":[],"g":true})");
+  ASSERT_FALSE(doc.HasParseError());
+  EXPECT_TRUE(doc.IsObject());
+  EXPECT_EQ(doc.Size(), 3);
+  EXPECT_TRUE(doc.HasMember("g"));
+  EXPECT_FALSE(doc.HasMember("h"));
+  EXPECT_TRUE(doc.FindMember("h") == doc.MemberEnd());
+  EXPECT_TRUE(doc["g"].GetBool());
+  EXPECT_TRUE(doc["f"].IsArray());
+  EXPECT_TRUE(doc["f"].Empty());
+  EXPECT_TRUE(doc["a"]["e"].Empty());
+  EXPECT_EQ(doc["a"]["b"][1]["c"].GetString(), "x\ty");
+  EXPECT_EQ(doc["a"]["b"][0].GetInt64(), 1);
+  EXPECT_FALSE(doc["a"]["b"][2].IsValid());
+  EXPECT_FALSE(doc["x"]["y"].IsValid());
+  EXPECT_TRUE(doc["x"].IsNull());
+
+  auto node = doc.AtPointer(JsonPointer({"a", "b", 1, "c"}));
+  ASSERT_TRUE(node.IsValid());
+  EXPECT_EQ(node.GetStringView(), "x\ty");
+  EXPECT_EQ(doc.AtPointer("a", "b", 0).GetUint64(), 1);
+  EXPECT_FALSE(doc.AtPointer(JsonPointer({"a", "b", 2})).IsValid());
+  EXPECT_FALSE(doc.AtPointer(JsonPointer({"g", 0})).IsValid());
+  EXPECT_FALSE(doc.AtPointer(JsonPointer({"a", -1})).IsValid());
+
+  size_t cnt = 0;
+  for (auto m = doc.MemberBegin(); m != doc.MemberEnd(); ++m) cnt++;
+  EXPECT_EQ(cnt, 3);
+  // null, true, false take one word, numbers and strings take two
+  doc.Parse(R"([null,true,false,1,"a",{"b":[]}])");
+  EXPECT_EQ(doc.TapeSize(), 1 + 3 + 2 + 2 + (1 + 2 + 2 + 1) + 1);
+}
+
+TEST(TapeDocument, ParseError) {
+  TapeDocument doc;
+  doc.Parse(R"({"a":[1,2})");
+  EXPECT_EQ(doc.GetParseError(), kParseErrorInvalidChar);
+  EXPECT_EQ(doc.GetErrorOffset(), 10);
+  EXPECT_TRUE(doc.IsNull());
+  EXPECT_EQ(doc.TapeSize(), 0);
+
+  // the document can be parsed again after errors, and moved
+  doc.Parse(R"(["abc"])");
+  ASSERT_FALSE(doc.HasParseError());
+  TapeDocument other(std::move(doc));
+  EXPECT_EQ(other[0].GetStringView(), "abc");
+}
+
+}  // namespace
@@ -0,0 +1,119 @@
+/*
+ * Copyright 2022 ByteDance Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <fstream>
+#include <limits>
+#include <sstream>
+#include <string>
+
+#include "gtest/gtest.h"
+#include "sonic/sonic.h"
+
+namespace {
+
+using namespace sonic_json;
+
+static std::string get_json(const std::string& file) {
+  std::ifstream ifs(file);
+  std::stringstream ss;
+  ss << ifs.rdbuf();
+  return ss.str();
+}
+
+TEST(Writer, Basic) {
+  WriteBuffer wb;
+  Writer w(wb);
+  EXPECT_FALSE(w.IsComplete());
+  w.StartObject();
+  w.Key("a");
+  w.Int(-1);
+  w.Key("b\"");
+  w.StartArray();
+  w.Uint(18446744073709551615ULL);
+  w.Double(1.5);
+  w.Bool(true);
+  w.Bool(false);
+  w.Null();
+  w.String("x\n");
+  w.StartObject();
+  w.EndObject();
+  w.StartArray();
+  w.EndArray();
+  w.Raw("1e1000", 6);
+  w.EndArray();
+  w.Key("c");
+  w.StartObject();
+  w.Key("d");
+  w.NumStr("0.1");
+  w.EndObject();
+  w.EndObject();
+  EXPECT_TRUE(w.IsComplete());
+  EXPECT_EQ(wb.ToStringView(),
+            R"({"a":-1,"b\"":[18446744073709551615,1.5,true,false,null,"x\n",)"
+            R"({},[],1e1000],"c":{"d":0.1}})");
+
+  // the scalars at root
+  for (auto f : {+[](Writer& w) { w.Null(); }, +[](Writer& w) { w.Bool(true); },
+                 +[](Writer& w) { w.Int(0); }}) {
+    w.Reset();
+    f(w);
+    EXPECT_TRUE(w.IsComplete());
+  }
+  EXPECT_EQ(wb.ToStringView(), "0");
+}
+
+TEST(Writer, Flags) {
+  WriteBuffer wb;
+  wb.Push('#');
+  GenericWriter<SerializeFlags::kSerializeAppendBuffer |
+                SerializeFlags::kSerializeEscapeEmoji>
+      w(wb);
+  w.StartArray();
+  w.String("\xF0\x9F\x98\x80");
+  w.EndArray();
+  EXPECT_EQ(wb.ToStringView(), R"(#["\ud83d\ude00"])");
+
+  Writer w2(wb);
+  EXPECT_FALSE(w2.Double(std::numeric_limits<double>::infinity()));
+  GenericWriter<SerializeFlags::kSerializeInfNan> w3(wb);
+  EXPECT_TRUE(w3.Double(-std::numeric_limits<double>::infinity()));
+  EXPECT_EQ(wb.ToStringView(), R"("-Infinity")");
+}
+
+// The writer is a SAX handler, so the parser can minify JSON by it.
+TEST(Writer, Transcode) {
+  for (auto file : {"book", "canada", "citm_catalog", "github_events",
+                    "gsoc-2018", "lottie", "poet", "twitter",
+                    "twitterescaped"}) {
+    std::string json = get_json(std::string("./testdata/") + file + ".json");
+    Document doc;
+    doc.Parse(json);
+    ASSERT_FALSE(doc.HasParseError()) << file;
+    WriteBuffer expect;
+    ASSERT_EQ(doc.Serialize(expect), kErrorNone);
+
+    size_t len = json.size();
+    json.append(SONICJSON_PADDING, '\0');
+    WriteBuffer wb;
+    Writer w(wb);
+    Parser<ParseFlags::kParseBorrowInput> p;
+    ASSERT_EQ(p.Parse(&json[0], len, w).Error(), kErrorNone) << file;
+    EXPECT_TRUE(w.IsComplete());
+    EXPECT_EQ(wb.ToStringView(), expect.ToStringView()) << file;
+  }
+}
+
+}  // namespace